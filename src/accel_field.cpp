@@ -0,0 +1,243 @@
+﻿#include "accel_field.h"
+#include <cmath>
+#include <algorithm>
+#include "task_pool.h"
+
+// fine 격자 레벨별 반 크기 (천체 반지름의 2배보다는 크게)
+static const float FIELD_FINE_HALF[FIELD_FINE_LEVELS] = { 24.0f, 8.0f };
+static const float FIELD_BOX = 200.0f;
+// 최근접 거리는 이 값까지만 정확히 구함 (가변 dt 기준 sqrt(2000) ~ 45 보다 크면 충분)
+// 먼 격자점에서 최근접 탐색이 천체를 잔뜩 여는 것을 막음
+static const float FIELD_DIST_CAP = 64.0f;
+
+// --- 굽기 ---
+
+// 한 격자점의 가속도 / 최근접 거리를 옥트리로 계산
+// 천체 안쪽은 균일 밀도 구의 내부 중력 (M * r / R^3) 으로 바꿔서 격자 보간이 발산하지 않게 함
+// 가속도용으로 근사한 노드도 최근접 거리가 갱신될 수 있으면 다시 열어서 확인 (가속도는 중복 합산하지 않음)
+// bound: 최근접 거리의 상한 (이웃 격자점 값 + 격자 간격), 이보다 먼 노드는 최근접 탐색에서 제외
+static FieldSample evaluateSample(const BodyOctree& tree, const glm::vec3& pos, float theta, const FieldSample* bound, float spacing) {
+    const BodySoA& soa = tree.bodies;
+    const float thetaSq = theta * theta;
+    glm::vec3 accel(0.0f);
+    float bestClearance = FIELD_DIST_CAP, bestCenterSq = FIELD_DIST_CAP * FIELD_DIST_CAP;
+    if (bound) {
+        // 거리 함수는 1-립시츠라서 이웃 값 + 간격이 상한 (여유를 조금 둬서 같은 천체도 다시 찾게 함)
+        float slack = spacing * 1.01f + 1e-3f;
+        bestClearance = std::min(bestClearance, bound->clearance + slack);
+        bestCenterSq = std::min(bestCenterSq, (bound->centerDist + slack) * (bound->centerDist + slack));
+    }
+
+    struct Entry { int node; bool accelDone; };
+    Entry stack[OCTREE_STACK_SIZE];
+    int top = 0;
+    stack[top++] = { 0, false };
+
+    while (top > 0) {
+        Entry e = stack[--top];
+        const OctreeNode& node = tree.nodes[e.node];
+        if (node.count == 0) continue;
+
+        glm::vec3 d = glm::max(glm::max(node.boxMin - pos, pos - node.boxMax), glm::vec3(0.0f));
+        float boxDist = glm::length(d);
+        bool needNearest = (boxDist - node.maxRadius < bestClearance) || (boxDist * boxDist < bestCenterSq);
+        bool accelDone = e.accelDone;
+
+        if (node.firstChild >= 0) {
+            if (!accelDone) {
+                glm::vec3 dir = node.centerOfMass - pos;
+                float distSq = glm::dot(dir, dir);
+                if (node.size * node.size < thetaSq * distSq && boxDist > node.maxRadius) {
+                    accel += dir * (node.mass / (distSq * std::sqrt(distSq)) * 5.0f);
+                    accelDone = true;
+                }
+            }
+            if (accelDone && !needNearest) continue;
+            for (int c = 0; c < node.childCount; c++) stack[top++] = { node.firstChild + c, accelDone };
+            continue;
+        }
+
+        for (int b = node.first; b < node.first + node.count; b++) {
+            glm::vec3 dir = glm::vec3(soa.x[b], soa.y[b], soa.z[b]) - pos;
+            float distSq = glm::dot(dir, dir);
+            float dist = std::sqrt(distSq);
+            float radius = std::sqrt(soa.radiusSq[b]);
+
+            bestCenterSq = std::min(bestCenterSq, distSq);
+            bestClearance = std::min(bestClearance, dist - radius);
+
+            if (accelDone) continue;
+            if (distSq < soa.radiusSq[b]) {
+                accel += dir * (soa.mass[b] / (soa.radiusSq[b] * radius) * 5.0f);
+            }
+            else {
+                accel += dir * (soa.mass[b] / (distSq * dist) * 5.0f);
+            }
+        }
+    }
+
+    FieldSample s;
+    s.ax = accel.x; s.ay = accel.y; s.az = accel.z;
+    s.clearance = bestClearance;
+    s.centerDist = std::sqrt(bestCenterSq);
+    return s;
+}
+
+static void resizeGrid(FieldGrid& grid, glm::vec3 origin, float size, int cells) {
+    grid.origin = origin;
+    grid.spacing = size / cells;
+    grid.points = cells + 1;
+    grid.samples.resize((size_t)grid.points * grid.points * grid.points);
+}
+
+// 모든 격자의 격자점을 하나의 병렬 루프로 계산 (z 단면 단위로 나눔)
+// 같은 줄의 앞 격자점 (줄 첫 점은 윗줄 첫 점) 을 최근접 탐색 상한으로 씀
+static void bakeGrids(AccelField& field, const BodyOctree& tree, float theta) {
+    struct Slice { FieldGrid* grid; int z; };
+    std::vector<Slice> slices;
+    slices.reserve(field.coarse.points + field.fineCount * (FIELD_FINE_CELLS + 1));
+    for (int z = 0; z < field.coarse.points; z++) slices.push_back({ &field.coarse, z });
+    for (int g = 0; g < field.fineCount; g++) {
+        for (int z = 0; z < field.fine[g].points; z++) slices.push_back({ &field.fine[g], z });
+    }
+
+    // z 평면 하나가 작업 하나
+    parallelFor((int)slices.size(), 1, [&](int i, int) {
+        FieldGrid& grid = *slices[i].grid;
+        const int n = grid.points, z = slices[i].z;
+        for (int y = 0; y < n; y++) {
+            for (int x = 0; x < n; x++) {
+                glm::vec3 p = grid.origin + glm::vec3((float)x, (float)y, (float)z) * grid.spacing;
+                size_t index = ((size_t)z * n + y) * n + x;
+                const FieldSample* bound = (x > 0) ? &grid.samples[index - 1] : (y > 0) ? &grid.samples[index - n] : nullptr;
+                grid.samples[index] = evaluateSample(tree, p, theta, bound, grid.spacing);
+            }
+        }
+    });
+}
+
+bool isAccelFieldCurrent(const AccelField& field, const BodySoA& soa, float theta) {
+    const BodySoA& a = field.baked;
+    if (!field.valid || field.bakedTheta != theta || a.count != soa.count) return false;
+    for (int i = 0; i < a.count; i++) {
+        if (a.x[i] != soa.x[i] || a.y[i] != soa.y[i] || a.z[i] != soa.z[i]) return false;
+        if (a.mass[i] != soa.mass[i] || a.radiusSq[i] != soa.radiusSq[i]) return false;
+    }
+    return true;
+}
+
+void bakeAccelField(AccelField& field, const BodySoA& soa, const BodyOctree& tree, float theta) {
+    resizeGrid(field.coarse, glm::vec3(-FIELD_BOX), FIELD_BOX * 2.0f, FIELD_COARSE_CELLS);
+
+    // 질량이 큰 천체부터 fine 격자를 배정
+    int fineBodies = std::min(soa.count, FIELD_MAX_FINE_BODIES);
+    std::vector<int>& order = field.order;
+    order.resize(soa.count);
+    for (int i = 0; i < soa.count; i++) order[i] = i;
+    std::partial_sort(order.begin(), order.begin() + fineBodies, order.end(),
+        [&](int a, int b) { return soa.mass[a] > soa.mass[b]; });
+
+    field.fineCount = fineBodies * FIELD_FINE_LEVELS;
+    if ((int)field.fine.size() < field.fineCount) field.fine.resize(field.fineCount);
+    for (int i = 0; i < fineBodies; i++) {
+        int b = order[i];
+        glm::vec3 center(soa.x[b], soa.y[b], soa.z[b]);
+        float radius = std::sqrt(soa.radiusSq[b]);
+        for (int level = 0; level < FIELD_FINE_LEVELS; level++) {
+            float half = std::max(FIELD_FINE_HALF[level], radius * 2.0f);
+            resizeGrid(field.fine[i * FIELD_FINE_LEVELS + level], center - glm::vec3(half), half * 2.0f, FIELD_FINE_CELLS);
+        }
+    }
+
+    // coarse 칸별로 겹치는 fine 격자 목록 (계수 정렬 2패스)
+    // 1패스: 칸별 개수 -> 누적합으로 각 칸의 끝 위치, 2패스: 끝에서부터 채우면 cellStart[c]가 시작 위치가 됨
+    const int cells = FIELD_COARSE_CELLS;
+    const float coarseSpacing = field.coarse.spacing;
+    field.cellStart.assign((size_t)cells * cells * cells + 1, 0);
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            for (size_t c = 1; c < field.cellStart.size(); c++) field.cellStart[c] += field.cellStart[c - 1];
+            field.cellItems.resize(field.cellStart.back());
+        }
+        for (int g = 0; g < field.fineCount; g++) {
+            const FieldGrid& grid = field.fine[g];
+            glm::vec3 lo = (grid.origin + FIELD_BOX) / coarseSpacing;
+            glm::vec3 hi = (grid.origin + grid.spacing * (float)(grid.points - 1) + FIELD_BOX) / coarseSpacing;
+            glm::ivec3 a = glm::clamp(glm::ivec3(glm::floor(lo)), glm::ivec3(0), glm::ivec3(cells - 1));
+            glm::ivec3 b = glm::clamp(glm::ivec3(glm::floor(hi)), glm::ivec3(0), glm::ivec3(cells - 1));
+            for (int z = a.z; z <= b.z; z++) {
+                for (int y = a.y; y <= b.y; y++) {
+                    for (int x = a.x; x <= b.x; x++) {
+                        size_t c = ((size_t)z * cells + y) * cells + x;
+                        if (pass == 0) field.cellStart[c]++;
+                        else field.cellItems[--field.cellStart[c]] = g;
+                    }
+                }
+            }
+        }
+    }
+
+    bakeGrids(field, tree, theta);
+
+    field.baked = soa;
+    field.bakedTheta = theta;
+    field.valid = true;
+}
+
+// --- 샘플링 ---
+
+static inline bool gridContains(const FieldGrid& grid, const glm::vec3& pos) {
+    glm::vec3 local = pos - grid.origin;
+    float size = grid.spacing * (float)(grid.points - 1);
+    return local.x >= 0.0f && local.y >= 0.0f && local.z >= 0.0f &&
+        local.x <= size && local.y <= size && local.z <= size;
+}
+
+// 삼선형 보간 (격자 밖은 가장자리로 고정)
+static inline FieldSample sampleGrid(const FieldGrid& grid, const glm::vec3& pos) {
+    const int n = grid.points;
+    glm::vec3 f = (pos - grid.origin) / grid.spacing;
+    f = glm::clamp(f, glm::vec3(0.0f), glm::vec3((float)(n - 1) - 1e-4f));
+    glm::ivec3 i = glm::ivec3(f);
+    glm::vec3 t = f - glm::vec3(i);
+
+    const FieldSample* base = &grid.samples[((size_t)i.z * n + i.y) * n + i.x];
+    const size_t dy = n, dz = (size_t)n * n;
+    const FieldSample* corner[8] = {
+        base, base + 1, base + dy, base + dy + 1,
+        base + dz, base + dz + 1, base + dz + dy, base + dz + dy + 1
+    };
+    float w[8] = {
+        (1 - t.x) * (1 - t.y) * (1 - t.z), t.x * (1 - t.y) * (1 - t.z),
+        (1 - t.x) * t.y * (1 - t.z), t.x * t.y * (1 - t.z),
+        (1 - t.x) * (1 - t.y) * t.z, t.x * (1 - t.y) * t.z,
+        (1 - t.x) * t.y * t.z, t.x * t.y * t.z
+    };
+
+    FieldSample r = { 0, 0, 0, 0, 0 };
+    for (int k = 0; k < 8; k++) {
+        r.ax += corner[k]->ax * w[k];
+        r.ay += corner[k]->ay * w[k];
+        r.az += corner[k]->az * w[k];
+        r.clearance += corner[k]->clearance * w[k];
+        r.centerDist += corner[k]->centerDist * w[k];
+    }
+    return r;
+}
+
+glm::vec3 sampleAccelField(const AccelField& field, const glm::vec3& pos, float& minDistSq, bool& crashed) {
+    // coarse 칸에 걸친 fine 격자 중 pos를 포함하는 가장 촘촘한 격자를 고름
+    const FieldGrid* grid = &field.coarse;
+    const int cells = FIELD_COARSE_CELLS;
+    glm::ivec3 c = glm::clamp(glm::ivec3(glm::floor((pos + FIELD_BOX) / field.coarse.spacing)), glm::ivec3(0), glm::ivec3(cells - 1));
+    size_t cell = ((size_t)c.z * cells + c.y) * cells + c.x;
+    for (int k = field.cellStart[cell]; k < field.cellStart[cell + 1]; k++) {
+        const FieldGrid& candidate = field.fine[field.cellItems[k]];
+        if (candidate.spacing < grid->spacing && gridContains(candidate, pos)) grid = &candidate;
+    }
+
+    FieldSample s = sampleGrid(*grid, pos);
+    crashed = s.clearance < 0.0f;
+    minDistSq = s.centerDist * s.centerDist;
+    return glm::vec3(s.ax, s.ay, s.az);
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "ray_batch.h"
+#include "octree.h"
+
+// --- 미리 구운 가속도장 ---
+// 천체가 멈춰 있는 동안 중력 가속도를 3D 격자에 구워두고 광선은 삼선형 보간으로 읽음
+// 광선 한 스텝 비용이 천체 수와 무관해짐 (굽는 비용은 격자점 수 x 옥트리 질의)
+// 박스 전체를 덮는 coarse 격자 + 무거운 천체 주변에 점점 촘촘해지는 fine 격자
+
+// 격자점 하나에 저장하는 값
+struct FieldSample {
+    float ax, ay, az;
+    float clearance;  // 가장 가까운 천체 표면까지 거리 (천체 안쪽이면 음수 -> 충돌)
+    float centerDist; // 가장 가까운 천체 중심까지 거리 (가변 dt 판정용)
+};
+
+struct FieldGrid {
+    glm::vec3 origin; // 첫 격자점 위치
+    float spacing = 0.0f;
+    int points = 0;   // 축당 격자점 수
+    std::vector<FieldSample> samples; // (z * points + y) * points + x
+};
+
+// coarse 격자 해상도 (박스 400을 64칸 -> 칸 크기 6.25)
+const int FIELD_COARSE_CELLS = 64;
+// fine 격자: 천체당 레벨 수, 레벨별 반 크기, 칸 수
+const int FIELD_FINE_LEVELS = 2;
+const int FIELD_FINE_CELLS = 20;
+// fine 격자를 받는 천체 수 상한 (질량 순), 나머지 천체는 coarse 해상도로만 표현됨
+const int FIELD_MAX_FINE_BODIES = 32;
+
+struct AccelField {
+    FieldGrid coarse;
+    std::vector<FieldGrid> fine; // 천체별 레벨 순서 (안쪽 레벨이 뒤)
+    int fineCount = 0;           // 사용 중인 fine 격자 수 (fine.size()는 용량 유지용)
+
+    // coarse 칸 -> 겹치는 fine 격자 목록 (CSR)
+    std::vector<int> cellStart, cellItems;
+    std::vector<int> order; // fine 격자 배정용 질량 순서
+
+    BodySoA baked; // 마지막으로 구운 천체 상태 (같으면 다시 굽지 않음)
+    float bakedTheta = -1.0f;
+    bool valid = false;
+};
+
+// 천체와 열림 각도가 마지막으로 구운 상태와 같으면 true (다시 구울 필요 없음)
+bool isAccelFieldCurrent(const AccelField& field, const BodySoA& soa, float theta);
+
+// tree는 soa로 만든 옥트리 (굽기용 질의), theta는 굽기에 쓰는 열림 각도
+void bakeAccelField(AccelField& field, const BodySoA& soa, const BodyOctree& tree, float theta);
+
+// computeAcceleration과 같은 인터페이스로 가속도장을 읽음
+glm::vec3 sampleAccelField(const AccelField& field, const glm::vec3& pos, float& minDistSq, bool& crashed);
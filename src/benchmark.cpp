@@ -0,0 +1,1613 @@
+﻿// --- 헤드리스 벤치마크 ---
+// 창/GL 컨텍스트 없이 시뮬레이션 코어의 핫 함수들을 측정해서 JSON으로 출력함
+// 디스플레이 없는 빌드 서버에서 성능 회귀를 잡기 위한 용도
+//
+// 사용 예:
+//   Event-Horizon-Bench --scene default --seed 42 --rays 300,3000 --steps 500,2000 --threads 1,4
+//   Event-Horizon-Bench --scene cluster:200 --frames 10 --textures texture/8k_jupiter.jpg --out bench.json
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/random.hpp>
+#include "simulation.h"
+#include "sim_thread.h"
+#include "spline.h"
+#include "image.h"
+#include "texture_cache.h"
+#include "quality_governor.h"
+#include "task_pool.h"
+#include "scene_file.h"
+#include "nbody.h"
+#include "frame_profiler.h"
+
+// --- 할당 횟수 측정 ---
+// 전역 operator new를 가로채서 프레임당 힙 할당 횟수를 셈
+static std::atomic<long long> allocationCount(0);
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// --- 설정 ---
+struct BenchOptions {
+    std::string scene = "default";
+    unsigned seed = 42;
+    std::vector<int> rays = { 300 };
+    std::vector<int> steps = { 2000 };
+    std::vector<int> threads = { 1 };
+    bool affinity = false; // 작업 스레드를 코어에 고정
+    std::vector<std::string> engines = { "scalar", "simd", "wavefront", "rk45" };
+    std::vector<float> tolerances = { 1e-4f, 1e-5f, 1e-6f };
+    std::vector<float> escapes = { 0.0f, 0.25f }; // 해석적 탈출 허용 변위 (0 = 끔)
+    std::vector<float> thetas = { 0.5f }; // 옥트리 열림 각도 (0 = 직접 합산)
+    std::vector<int> fields = { 0 }; // 가속도장 굽기 모드 (0/1)
+    std::vector<int> amortize = { 1 }; // 시간 분할 간격 k (1 = 매 프레임 전체 적분)
+    bool staticBodies = false; // 프레임 사이에 천체를 움직이지 않음 (가속도장 재사용 측정)
+    bool accuracy = true;
+    bool simThread = true; // 백그라운드 스레드 + 렌더 루프 흉내 측정
+    bool governor = true;  // 품질 조절기 수렴 측정
+    bool phaseCache = true; // 궤도 위상 캐시 채우기 / 재생 측정
+    std::vector<float> massTolerances = { 4.0f }; // 질량 편집 후 그대로 둘 광선의 끝점 변위 허용치 (빈 목록 = 측정 안 함)
+    double targetMs = 16.6;
+    int frames = 30;
+    int sceneBodies = 1000000; // sceneFile 측정에 쓸 천체 수 (0 = 측정 안 함)
+    int nbodyBodies = 10000;   // nbody 힘 계산 측정에 쓸 천체 수 (0 = N체 측정 안 함)
+    std::vector<std::string> textures;
+    std::string outPath;
+};
+
+static double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static std::vector<int> parseIntList(const char* text) {
+    std::vector<int> values;
+    std::string s(text);
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t comma = s.find(',', start);
+        if (comma == std::string::npos) comma = s.size();
+        if (comma > start) values.push_back(std::atoi(s.substr(start, comma - start).c_str()));
+        start = comma + 1;
+    }
+    return values;
+}
+
+static std::vector<std::string> parseStringList(const char* text) {
+    std::vector<std::string> values;
+    std::string s(text);
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t comma = s.find(',', start);
+        if (comma == std::string::npos) comma = s.size();
+        if (comma > start) values.push_back(s.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return values;
+}
+
+static std::vector<float> parseFloatList(const char* text) {
+    std::vector<float> values;
+    for (const auto& item : parseStringList(text)) values.push_back((float)std::atof(item.c_str()));
+    return values;
+}
+
+static void printUsage() {
+    std::fprintf(stderr,
+        "usage: Event-Horizon-Bench [--scene default|cluster:N|file:path] [--seed N]\n"
+        "                           [--rays a,b,..] [--steps a,b,..] [--threads a,b,..] [--affinity 0|1]\n"
+        "                           [--engine scalar,simd,wavefront,rk45] [--frames N]\n"
+        "                           [--tolerances 1e-4,1e-5] [--escape 0,0.25] [--theta 0,0.5]\n"
+        "                           [--field 0,1] [--amortize 1,4] [--static 0|1] [--accuracy 0|1]\n"
+        "                           [--sim-thread 0|1] [--governor 0|1] [--target-ms 16.6] [--phase-cache 0|1]\n"
+        "                           [--mass-tolerance 2,4,8] [--scene-bodies N] [--nbody N]"
+        " [--textures file,..] [--out result.json]\n");
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions& opt) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value) { printUsage(); return false; }
+
+        if (!std::strcmp(arg, "--scene")) opt.scene = value;
+        else if (!std::strcmp(arg, "--seed")) opt.seed = (unsigned)std::strtoul(value, nullptr, 10);
+        else if (!std::strcmp(arg, "--rays")) opt.rays = parseIntList(value);
+        else if (!std::strcmp(arg, "--steps")) opt.steps = parseIntList(value);
+        else if (!std::strcmp(arg, "--threads")) opt.threads = parseIntList(value);
+        else if (!std::strcmp(arg, "--affinity")) opt.affinity = std::atoi(value) != 0;
+        else if (!std::strcmp(arg, "--engine")) opt.engines = parseStringList(value);
+        else if (!std::strcmp(arg, "--frames")) opt.frames = std::atoi(value);
+        else if (!std::strcmp(arg, "--tolerances")) opt.tolerances = parseFloatList(value);
+        else if (!std::strcmp(arg, "--escape")) opt.escapes = parseFloatList(value);
+        else if (!std::strcmp(arg, "--theta")) opt.thetas = parseFloatList(value);
+        else if (!std::strcmp(arg, "--field")) opt.fields = parseIntList(value);
+        else if (!std::strcmp(arg, "--amortize")) opt.amortize = parseIntList(value);
+        else if (!std::strcmp(arg, "--static")) opt.staticBodies = std::atoi(value) != 0;
+        else if (!std::strcmp(arg, "--accuracy")) opt.accuracy = std::atoi(value) != 0;
+        else if (!std::strcmp(arg, "--sim-thread")) opt.simThread = std::atoi(value) != 0;
+        else if (!std::strcmp(arg, "--governor")) opt.governor = std::atoi(value) != 0;
+        else if (!std::strcmp(arg, "--target-ms")) opt.targetMs = std::atof(value);
+        else if (!std::strcmp(arg, "--phase-cache")) opt.phaseCache = std::atoi(value) != 0;
+        else if (!std::strcmp(arg, "--mass-tolerance")) opt.massTolerances = parseFloatList(value);
+        else if (!std::strcmp(arg, "--scene-bodies")) opt.sceneBodies = std::atoi(value);
+        else if (!std::strcmp(arg, "--nbody")) opt.nbodyBodies = std::atoi(value);
+        else if (!std::strcmp(arg, "--textures")) opt.textures = parseStringList(value);
+        else if (!std::strcmp(arg, "--out")) opt.outPath = value;
+        else { printUsage(); return false; }
+        i++;
+    }
+    return true;
+}
+
+// --- 장면 구성 ---
+// "default": setupScene()과 동일
+// "cluster:N": 중심 블랙홀 + 무작위 궤도의 천체 N개 (시드 고정)
+//   setupScene처럼 블랙홀이 광원 주위 50 거리에서 공전 (광원이 블랙홀 안에 있으면 모든 광선이 바로 충돌함)
+// "file:path": 장면 파일 (.ehscene 텍스트 또는 컴파일된 .ehsb)
+static bool buildScene(const std::string& scene, unsigned seed) {
+    clearBodies(bodies);
+    if (scene == "default") {
+        setupScene();
+        return true;
+    }
+    if (scene.compare(0, 8, "cluster:") == 0) {
+        int count = std::atoi(scene.c_str() + 8);
+        std::srand(seed);
+
+        Body core;
+        core.mass = 800.0f;
+        core.radius = 4.0f;
+        core.color = { 0.1f, 0.1f, 0.1f };
+        core.relativeOffset = glm::vec3(lightPosition);
+        core.orbitRadius = 50.0f;
+        core.orbitSpeed = 0.3f;
+        core.rotationSpeed = 0.05f;
+        int coreIndex = addBody(bodies, core);
+
+        reserveBodies(bodies, count + 1);
+        for (int i = 0; i < count; i++) {
+            Body star;
+            star.mass = glm::linearRand(5.0f, 50.0f);
+            star.radius = glm::linearRand(0.3f, 1.5f);
+            star.color = { 0.8f, 0.8f, 0.6f };
+            star.parent = coreIndex;
+            star.orbitRadius = glm::linearRand(10.0f, 180.0f);
+            star.orbitSpeed = glm::linearRand(0.1f, 3.0f);
+            star.rotationSpeed = 1.0f;
+            addBody(bodies, star);
+        }
+        sortBodyLevels(bodies);
+        return true;
+    }
+    if (scene.compare(0, 5, "file:") == 0) {
+        std::string error;
+        if (loadSceneFile(scene.c_str() + 5, &error)) return true;
+        std::fprintf(stderr, "%s\n", error.c_str());
+    }
+    return false;
+}
+
+// --- JSON 출력 ---
+static std::string results;
+
+static void beginResult(const char* function) {
+    if (!results.empty()) results += ",\n";
+    results += "    { \"function\": \"";
+    results += function;
+    results += "\"";
+}
+
+static void addField(const char* name, double value) {
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), ", \"%s\": %.6g", name, value);
+    results += buffer;
+}
+
+static void addField(const char* name, const std::string& value) {
+    results += ", \"";
+    results += name;
+    results += "\": \"";
+    results += value;
+    results += "\"";
+}
+
+static void endResult() {
+    results += " }";
+}
+
+// 작업 풀 슬롯 수 (설정이 같으면 스레드를 다시 띄우지 않음)
+static void setBenchThreads(const BenchOptions& opt, int threads) {
+    const TaskPoolConfig& current = taskPoolConfig();
+    if (current.threads == threads && current.pinThreads == opt.affinity) return;
+    TaskPoolConfig config;
+    config.threads = threads;
+    config.pinThreads = opt.affinity;
+    configureTaskPool(config);
+}
+
+// --- 개별 측정 ---
+
+static void benchSimulateRay(const BenchOptions& opt, const std::string& engine, int rays, int steps, int threads, float escape, float theta, int field, int stride) {
+    numRays = rays;
+    rayAmortizeStride = stride;
+    invalidateRayHistory();
+    useAccelField = field != 0;
+    escapeTolerance = escape;
+    useOctree = theta > 0.0f;
+    octreeTheta = theta;
+    maxSteps = steps;
+    useSimdRays = (engine == "simd" || engine == "wavefront");
+    useWavefrontRays = (engine == "wavefront");
+    rayIntegrator = (engine == "rk45") ? RAY_INTEGRATOR_RK45 : RAY_INTEGRATOR_EULER;
+    setBenchThreads(opt, threads);
+
+    std::srand(opt.seed);
+    makeVelocities();
+
+    float time = 0.0f;
+    glm::vec3 startPos(lightPosition);
+
+    // 워밍업 1회 (경로 버퍼 용량 확보)
+    updateBodyPhysics(time);
+    simulateRay(startPos);
+
+    double totalMs = 0.0;
+    long long totalSteps = 0;
+    long long totalEvals = 0;
+    long long totalEscapes = 0;
+    long long bakes = 0;
+    long long reused = 0;
+    long long allocations = 0;
+    for (int frame = 0; frame < opt.frames; frame++) {
+        if (!opt.staticBodies) time += 0.02f;
+        updateBodyPhysics(time);
+
+        long long allocBefore = allocationCount.load();
+        double t0 = nowMs();
+        simulateRay(startPos);
+        totalMs += nowMs() - t0;
+        allocations += allocationCount.load() - allocBefore;
+        totalSteps += lastRayStats.steps;
+        totalEvals += lastRayStats.forceEvals;
+        totalEscapes += lastRayStats.escapes;
+        if (lastRayStats.bakedField) bakes++;
+        reused += lastRayStats.reusedRays;
+    }
+
+    // 시간 분할: 마지막 프레임 끝점을 같은 천체 위치에서 전체 적분한 끝점과 비교 (재사용한 경로가 얼마나 낡았는지)
+    double staleMean = 0.0, staleMax = 0.0;
+    if (stride > 1) {
+        std::vector<glm::vec3> amortizedEnds(rays);
+        for (int i = 0; i < rays; i++) amortizedEnds[i] = rayPaths.path(i).back();
+        rayAmortizeStride = 1;
+        simulateRay(startPos);
+        for (int i = 0; i < rays; i++) {
+            double d = glm::length(rayPaths.path(i).back() - amortizedEnds[i]);
+            staleMean += d / rays;
+            staleMax = std::max(staleMax, d);
+        }
+    }
+    rayAmortizeStride = 1;
+
+    double seconds = totalMs / 1000.0;
+    beginResult("simulateRay");
+    std::string engineName = engine;
+    if (engine == "simd") engineName = rayBatchInstructionSet();
+    if (engine == "wavefront") engineName = std::string(rayBatchInstructionSet()) + " wavefront";
+    addField("engine", engineName);
+    addField("scene", opt.scene);
+    addField("bodies", (double)bodies.count);
+    addField("numRays", rays);
+    addField("maxSteps", steps);
+    addField("threads", threads);
+    addField("escapeTolerance", escape);
+    addField("gravity", std::string(lastRayStats.usedField ? "field" : lastRayStats.usedOctree ? "octree" : "direct"));
+    addField("octreeTheta", theta);
+    addField("frames", opt.frames);
+    addField("msPerFrame", totalMs / opt.frames);
+    addField("raysPerSec", seconds > 0 ? (double)rays * opt.frames / seconds : 0.0);
+    addField("stepsPerSec", seconds > 0 ? (double)totalSteps / seconds : 0.0);
+    addField("forceEvalsPerRay", (double)totalEvals / ((double)rays * opt.frames));
+    addField("analyticEscapesPerFrame", (double)totalEscapes / opt.frames);
+    addField("staticBodies", opt.staticBodies ? 1 : 0);
+    addField("fieldBakesPerFrame", (double)bakes / opt.frames);
+    addField("amortizeStride", stride);
+    addField("raysIntegratedPerFrame", rays - (double)reused / opt.frames);
+    addField("staleEndpointErrorMean", staleMean);
+    addField("staleEndpointErrorMax", staleMax);
+    addField("allocationsPerFrame", (double)allocations / opt.frames);
+    endResult();
+}
+
+// --- 적분 정확도 ---
+// double 정밀도 RK45(허용오차 1e-10)를 기준해로 두고
+// 각 적분기의 광선 끝점(박스 탈출 지점)과 충돌 여부를 비교함
+struct D3 { double x, y, z; };
+static D3 operator+(D3 a, D3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+static D3 operator-(D3 a, D3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+static D3 operator*(D3 a, double s) { return { a.x * s, a.y * s, a.z * s }; }
+static double len(D3 a) { return std::sqrt(a.x * a.x + a.y * a.y + a.z * a.z); }
+
+static D3 referenceAccel(const D3& p, bool& crashed) {
+    D3 a = { 0, 0, 0 };
+    crashed = false;
+    for (int b = 0; b < bodySoA.count; b++) {
+        D3 dir = D3{ bodySoA.x[b], bodySoA.y[b], bodySoA.z[b] } - p;
+        double distSq = dir.x * dir.x + dir.y * dir.y + dir.z * dir.z;
+        if (distSq < bodySoA.radiusSq[b]) { crashed = true; return a; }
+        a = a + dir * (bodySoA.mass[b] * 5.0 / (distSq * std::sqrt(distSq)));
+    }
+    return a;
+}
+
+static bool outsideBox(const D3& p) {
+    return std::fabs(p.x) > 200.0 || std::fabs(p.y) > 200.0 || std::fabs(p.z) > 200.0;
+}
+
+// 선분 a->b가 ±200 박스를 빠져나가는 지점
+static D3 clipToBox(const D3& a, const D3& b) {
+    double t = 1.0;
+    const double pa[3] = { a.x, a.y, a.z }, pb[3] = { b.x, b.y, b.z };
+    for (int k = 0; k < 3; k++) {
+        double d = pb[k] - pa[k];
+        if (d > 0 && pb[k] > 200.0) t = std::min(t, (200.0 - pa[k]) / d);
+        if (d < 0 && pb[k] < -200.0) t = std::min(t, (-200.0 - pa[k]) / d);
+    }
+    return a + (b - a) * std::max(0.0, t);
+}
+
+// 결과: 0 = 탈출(exitPoint 유효), 1 = 충돌, 2 = 스텝 제한
+static int referenceRay(D3 p, D3 v, D3& exitPoint) {
+    static const double A[7][6] = {
+        { 0 }, { 1.0 / 5 }, { 3.0 / 40, 9.0 / 40 }, { 44.0 / 45, -56.0 / 15, 32.0 / 9 },
+        { 19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729 },
+        { 9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656 },
+        { 35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84 } };
+    static const double E[7] = { 71.0 / 57600, 0, -71.0 / 16695, 71.0 / 1920, -17253.0 / 339200, 22.0 / 525, -1.0 / 40 };
+    const double tol = 1e-10;
+    double h = 1e-3;
+    D3 kp[7], kv[7];
+    bool hit;
+    kp[0] = v;
+    kv[0] = referenceAccel(p, hit);
+    if (hit) return 1;
+    for (int attempt = 0; attempt < 2000000; attempt++) {
+        bool stageHit = false;
+        for (int s = 1; s < 7 && !stageHit; s++) {
+            D3 sp = p, sv = v;
+            for (int j = 0; j < s; j++) { sp = sp + kp[j] * (h * A[s][j]); sv = sv + kv[j] * (h * A[s][j]); }
+            kp[s] = sv;
+            kv[s] = referenceAccel(sp, stageHit);
+        }
+        if (stageHit) {
+            if (h < 1e-9) return 1;
+            h *= 0.25;
+            continue;
+        }
+        D3 np = p, nv = v, ep = { 0, 0, 0 }, ev = { 0, 0, 0 };
+        for (int j = 0; j < 6; j++) { np = np + kp[j] * (h * A[6][j]); nv = nv + kv[j] * (h * A[6][j]); }
+        for (int j = 0; j < 7; j++) { ep = ep + kp[j] * (h * E[j]); ev = ev + kv[j] * (h * E[j]); }
+        double err = std::max(len(ep) / (tol * (1 + len(np))), len(ev) / (tol * (1 + len(nv))));
+        double factor = std::min(5.0, std::max(0.2, err > 0 ? 0.9 * std::pow(err, -0.2) : 5.0));
+        if (err > 1.0) { h *= factor; continue; }
+        if (outsideBox(np)) { exitPoint = clipToBox(p, np); return 0; }
+        p = np; v = nv; kp[0] = kp[6]; kv[0] = kv[6];
+        h = std::min(h * factor, 0.05);
+    }
+    return 2;
+}
+
+static void benchAccuracy(const BenchOptions& opt) {
+    const int rays = 300;
+    numRays = rays;
+    maxSteps = 2000;
+    std::srand(opt.seed);
+    makeVelocities();
+    updateBodyPhysics(1.0f);
+    packBodies(bodySoA);
+
+    // 기준해
+    std::vector<int> refOutcome(rays);
+    std::vector<D3> refExit(rays);
+    glm::vec3 start(lightPosition);
+    for (int i = 0; i < rays; i++) {
+        const glm::vec3& v = initialVelocities[i];
+        refOutcome[i] = referenceRay({ start.x, start.y, start.z }, { v.x, v.y, v.z }, refExit[i]);
+    }
+
+    struct Config { const char* name; int integrator; float tolerance; float escape; int field; };
+    std::vector<Config> configs;
+    for (int field : opt.fields) {
+        for (float escape : opt.escapes) {
+            configs.push_back({ "euler", RAY_INTEGRATOR_EULER, 0.0f, escape, field });
+            for (float tol : opt.tolerances) configs.push_back({ "rk45", RAY_INTEGRATOR_RK45, tol, escape, field });
+        }
+    }
+
+    useOctree = false; // 기준해와 같은 직접 합산으로 적분기 오차만 비교 (가속도장은 따로 표시)
+    for (const auto& config : configs) {
+        useSimdRays = false;
+        useAccelField = config.field != 0;
+        escapeTolerance = config.escape;
+        rayIntegrator = config.integrator;
+        if (config.integrator == RAY_INTEGRATOR_RK45) rk45Tolerance = config.tolerance;
+        simulateRay(start);
+
+        int compared = 0, mismatched = 0;
+        double sumError = 0.0, maxError = 0.0;
+        for (int i = 0; i < rays; i++) {
+            RayPathView path = rayPaths.path(i);
+            D3 last = { path.back().x, path.back().y, path.back().z };
+            D3 prev = last;
+            if (path.size() >= 2) prev = { path[path.size() - 2].x, path[path.size() - 2].y, path[path.size() - 2].z };
+            bool escaped = outsideBox(last);
+            if (refOutcome[i] == 2) continue;
+            if (escaped != (refOutcome[i] == 0)) { mismatched++; continue; }
+            if (!escaped) continue;
+            double error = len(clipToBox(prev, last) - refExit[i]);
+            sumError += error;
+            maxError = std::max(maxError, error);
+            compared++;
+        }
+
+        beginResult("integratorAccuracy");
+        addField("integrator", std::string(config.name));
+        addField("tolerance", config.tolerance);
+        addField("escapeTolerance", config.escape);
+        addField("accelField", config.field);
+        addField("numRays", rays);
+        addField("forceEvalsPerRay", (double)lastRayStats.forceEvals / rays);
+        addField("escapedCompared", compared);
+        addField("outcomeMismatches", mismatched);
+        addField("meanExitError", compared ? sumError / compared : 0.0);
+        addField("maxExitError", maxError);
+        endResult();
+    }
+    rayIntegrator = RAY_INTEGRATOR_EULER;
+    useAccelField = false;
+}
+
+// --- 옥트리 근사 오차 ---
+// 박스 안 무작위 지점에서 직접 합산과 옥트리 가속도를 비교 (열림 각도별 오차/속도)
+static void benchOctreeForce(const BenchOptions& opt) {
+    const int samples = 20000;
+    updateBodyPhysics(1.0f);
+    packBodies(bodySoA);
+
+    double t0 = nowMs();
+    buildBodyOctree(bodyOctree, bodySoA);
+    double buildMs = nowMs() - t0;
+
+    std::srand(opt.seed);
+    std::vector<glm::vec3> points(samples), direct(samples);
+    std::vector<char> directCrashed(samples);
+    for (int i = 0; i < samples; i++) points[i] = glm::linearRand(glm::vec3(-200.0f), glm::vec3(200.0f));
+
+    // 직접 합산 (theta = 0이면 모든 노드를 열게 되므로 리프 합산과 같음)
+    t0 = nowMs();
+    for (int i = 0; i < samples; i++) {
+        float minDistSq;
+        bool crashed;
+        direct[i] = octreeAcceleration(bodyOctree, points[i], 0.0f, minDistSq, crashed);
+        directCrashed[i] = crashed;
+    }
+    double directMs = nowMs() - t0;
+
+    for (float theta : opt.thetas) {
+        if (theta <= 0.0f) continue;
+        double sumSq = 0.0, maxRel = 0.0;
+        int compared = 0, crashMismatches = 0;
+        glm::vec3 checksum(0.0f);
+        t0 = nowMs();
+        for (int i = 0; i < samples; i++) {
+            float minDistSq;
+            bool crashed;
+            glm::vec3 a = octreeAcceleration(bodyOctree, points[i], theta, minDistSq, crashed);
+            checksum += a;
+            if (crashed != (directCrashed[i] != 0)) { crashMismatches++; continue; }
+            if (crashed) continue;
+            double ref = glm::length(direct[i]);
+            if (ref <= 0.0) continue;
+            double rel = glm::length(a - direct[i]) / ref;
+            sumSq += rel * rel;
+            maxRel = std::max(maxRel, rel);
+            compared++;
+        }
+        double treeMs = nowMs() - t0;
+
+        beginResult("octreeForce");
+        addField("scene", opt.scene);
+        addField("bodies", (double)bodySoA.count);
+        addField("nodes", (double)bodyOctree.nodes.size());
+        addField("buildMs", buildMs);
+        addField("octreeTheta", theta);
+        addField("directNsPerQuery", directMs * 1e6 / samples);
+        addField("octreeNsPerQuery", treeMs * 1e6 / samples);
+        addField("rmsRelativeError", compared ? std::sqrt(sumSq / compared) : 0.0);
+        addField("maxRelativeError", maxRel);
+        addField("crashMismatches", crashMismatches);
+        addField("checksum", checksum.x + checksum.y + checksum.z);
+        endResult();
+    }
+}
+
+// --- 가속도장 ---
+// 굽는 시간/메모리와 무작위 지점에서 직접 합산 대비 보간 오차
+static void benchAccelField(const BenchOptions& opt) {
+    const int samples = 20000;
+    updateBodyPhysics(1.0f);
+    packBodies(bodySoA);
+
+    double t0 = nowMs();
+    buildBodyOctree(bodyOctree, bodySoA);
+    bakeAccelField(accelField, bodySoA, bodyOctree, octreeTheta);
+    double bakeMs = nowMs() - t0;
+
+    size_t bytes = accelField.coarse.samples.size() * sizeof(FieldSample);
+    for (int g = 0; g < accelField.fineCount; g++) bytes += accelField.fine[g].samples.size() * sizeof(FieldSample);
+
+    std::srand(opt.seed);
+    std::vector<glm::vec3> points(samples);
+    for (int i = 0; i < samples; i++) points[i] = glm::linearRand(glm::vec3(-200.0f), glm::vec3(200.0f));
+
+    // 오차가 큰 천체 근처를 따로 보기 위해 최근접 천체 표면에서 거리별로 나눔
+    const float bands[] = { 5.0f, 20.0f, 1e9f };
+    double sumSq[3] = { 0 }, maxRel[3] = { 0 };
+    int compared[3] = { 0 }, crashMismatches = 0;
+    glm::vec3 checksum(0.0f);
+
+    std::vector<glm::vec3> sampled(samples);
+    std::vector<char> sampledCrashed(samples);
+    t0 = nowMs();
+    for (int i = 0; i < samples; i++) {
+        float minDistSq;
+        bool crashed;
+        sampled[i] = sampleAccelField(accelField, points[i], minDistSq, crashed);
+        sampledCrashed[i] = crashed;
+    }
+    double sampleMs = nowMs() - t0;
+
+    for (int i = 0; i < samples; i++) {
+        float refMinDistSq;
+        bool refCrashed;
+        const glm::vec3& a = sampled[i];
+        bool crashed = sampledCrashed[i] != 0;
+        checksum += a;
+        glm::vec3 ref = octreeAcceleration(bodyOctree, points[i], 0.0f, refMinDistSq, refCrashed);
+        if (crashed != refCrashed) { crashMismatches++; continue; }
+        if (refCrashed || glm::length(ref) <= 0.0f) continue;
+
+        float clearance = 1e9f;
+        for (int b = 0; b < bodySoA.count; b++) {
+            glm::vec3 d = glm::vec3(bodySoA.x[b], bodySoA.y[b], bodySoA.z[b]) - points[i];
+            clearance = std::min(clearance, glm::length(d) - std::sqrt(bodySoA.radiusSq[b]));
+        }
+        int band = (clearance < bands[0]) ? 0 : (clearance < bands[1]) ? 1 : 2;
+        double rel = glm::length(a - ref) / glm::length(ref);
+        sumSq[band] += rel * rel;
+        maxRel[band] = std::max(maxRel[band], rel);
+        compared[band]++;
+    }
+
+    beginResult("accelField");
+    addField("scene", opt.scene);
+    addField("bodies", (double)bodySoA.count);
+    addField("fineGrids", accelField.fineCount);
+    addField("megabytes", bytes / (1024.0 * 1024.0));
+    addField("bakeMs", bakeMs);
+    addField("threads", taskPoolThreads());
+    addField("nsPerSample", sampleMs * 1e6 / samples);
+    const char* names[3] = { "near", "mid", "far" };
+    for (int k = 0; k < 3; k++) {
+        addField((std::string("rmsRelativeError_") + names[k]).c_str(), compared[k] ? std::sqrt(sumSq[k] / compared[k]) : 0.0);
+        addField((std::string("maxRelativeError_") + names[k]).c_str(), maxRel[k]);
+    }
+    addField("crashMismatches", crashMismatches);
+    addField("checksum", checksum.x + checksum.y + checksum.z);
+    endResult();
+}
+
+// --- 백그라운드 시뮬레이션 스레드 ---
+// 144Hz 렌더 루프를 흉내내면서 렌더 쪽 프레임 시간이 적분 시간과 무관한지 확인
+// 렌더 작업은 받은 세대의 경로 점을 한 번 훑는 것으로 대신함
+// 고정 스텝 시계: 시뮬레이션 시간이 벽시계 속도로 흐르는지와
+// 렌더 프레임마다 보여준 시간의 간격이 벽시계 간격에서 벗어난 정도(보간 vs 최신 세대 그대로)를 잼
+static void benchSimulationThread(const BenchOptions& opt) {
+    const double durationMs = 1000.0;
+    const double frameMs = 1000.0 / 144.0;
+    numRays = opt.rays.back();
+    maxSteps = opt.steps.back();
+    std::srand(opt.seed);
+    makeVelocities();
+    setBenchThreads(opt, opt.threads.back());
+
+    startSimulationThread();
+    std::vector<double> frameTimes;
+    frameTimes.reserve((size_t)(durationMs / frameMs) + 8);
+    const SimFrame& firstFrame = acquireSimFrame();
+    long long firstGeneration = firstFrame.generation, lastGeneration = firstGeneration;
+    const long long firstStep = firstFrame.step;
+    double solveMsSum = 0.0;
+    int solveCount = 0;
+    double checksum = 0.0;
+    std::vector<glm::vec3> positions;
+    SimPlayback playback;
+    // 렌더 프레임 사이 보여준 시간 간격 - 벽시계 간격 (ms 단위), 보간 / 최신 세대 그대로
+    const double msPerTime = SIM_STEP_MS / SIM_STEP_TIME;
+    double lastClock = -1.0, lastShown = 0.0, lastRaw = 0.0;
+    double shownErrSq = 0.0, rawErrSq = 0.0, shownErrMax = 0.0, rawErrMax = 0.0;
+    int intervals = 0;
+
+    double start = nowMs();
+    long long lastStep = firstStep;
+    while (nowMs() - start < durationMs) {
+        double t0 = nowMs();
+        const SimFrame& frame = acquireSimFrame();
+        if (frame.generation != lastGeneration) {
+            lastGeneration = frame.generation;
+            solveMsSum += frame.solveMs;
+            solveCount++;
+        }
+        lastStep = frame.step;
+        double clock = profileClockMs();
+        double shown = interpolateSimFrame(frame, advanceSimPlayback(playback, frame, clock), positions) * msPerTime;
+        double raw = frame.time * msPerTime;
+        if (lastClock >= 0.0) {
+            double wall = clock - lastClock;
+            double shownErr = (shown - lastShown) - wall, rawErr = (raw - lastRaw) - wall;
+            shownErrSq += shownErr * shownErr;
+            rawErrSq += rawErr * rawErr;
+            shownErrMax = std::max(shownErrMax, std::fabs(shownErr));
+            rawErrMax = std::max(rawErrMax, std::fabs(rawErr));
+            intervals++;
+        }
+        lastClock = clock;
+        lastShown = shown;
+        lastRaw = raw;
+        for (const glm::vec3& p : positions) checksum += p.x;
+        for (int i = 0; i < frame.rayPaths.numPaths; i++) {
+            for (const auto& p : frame.rayPaths.path(i)) checksum += p.x;
+        }
+        double t1 = nowMs();
+        frameTimes.push_back(t1 - t0);
+        double wait = frameMs - (t1 - t0);
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(wait));
+    }
+    double elapsedMs = nowMs() - start;
+    long long dropped = acquireSimFrame().droppedSteps;
+    stopSimulationThread();
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    beginResult("simulationThread");
+    addField("scene", opt.scene);
+    addField("numRays", numRays);
+    addField("renderFrames", (double)frameTimes.size());
+    addField("renderMsP50", frameTimes[frameTimes.size() / 2]);
+    addField("renderMsMax", frameTimes.back());
+    addField("generationsPerSec", (lastGeneration - firstGeneration) * 1000.0 / durationMs);
+    addField("solveMsMean", solveCount ? solveMsSum / solveCount : 0.0);
+    // 1이면 시뮬레이션 시간이 벽시계 속도로 흐름 (보여준 세대는 최대 한 세대 늦음)
+    addField("simTimeRate", (lastStep - firstStep) * SIM_STEP_MS / elapsedMs);
+    addField("droppedSteps", (double)dropped);
+    addField("shownStepErrorMsRms", intervals ? std::sqrt(shownErrSq / intervals) : 0.0);
+    addField("shownStepErrorMsMax", shownErrMax);
+    addField("rawStepErrorMsRms", intervals ? std::sqrt(rawErrSq / intervals) : 0.0);
+    addField("rawStepErrorMsMax", rawErrMax);
+    addField("checksum", checksum);
+    endResult();
+}
+
+// --- 품질 조절기 ---
+// 매 프레임 updateBodyPhysics + simulateRay를 현재 단계로 돌리고 그 시간을 조절기에 넣음
+// 수렴한 단계와 뒤쪽 절반에서 단계가 바뀐 횟수(흔들림), 뒤쪽 절반 프레임 시간 백분위수를 출력
+static void benchQualityGovernor(const BenchOptions& opt) {
+    const int frames = 600;
+    setBenchThreads(opt, opt.threads.back());
+    std::srand(opt.seed);
+    makeVelocities();
+
+    QualityGovernorConfig config;
+    config.targetMs = opt.targetMs;
+    QualityGovernor governor;
+    initQualityGovernor(governor, config);
+
+    std::vector<double> lateFrames;
+    int lateChanges = 0;
+    float time = 0.0f;
+    glm::vec3 startPos(lightPosition);
+    for (int frame = 0; frame < frames; frame++) {
+        const QualityLevel& q = currentQualityLevel(governor);
+        setActiveRayCount(q.numRays);
+        maxSteps = q.maxSteps;
+
+        time += 0.02f;
+        double t0 = nowMs();
+        updateBodyPhysics(time);
+        simulateRay(startPos);
+        double ms = nowMs() - t0;
+
+        bool changed = updateQualityGovernor(governor, ms);
+        if (frame >= frames / 2) {
+            lateFrames.push_back(ms);
+            if (changed) lateChanges++;
+        }
+    }
+
+    std::sort(lateFrames.begin(), lateFrames.end());
+    const QualityLevel& q = currentQualityLevel(governor);
+    beginResult("qualityGovernor");
+    addField("scene", opt.scene);
+    addField("threads", opt.threads.back());
+    addField("targetMs", opt.targetMs);
+    addField("finalLevel", governor.level);
+    addField("numRays", q.numRays);
+    addField("maxSteps", q.maxSteps);
+    addField("levelChanges", governor.changes);
+    addField("levelChangesSecondHalf", lateChanges);
+    addField("frameMsP50", lateFrames[lateFrames.size() / 2]);
+    addField("frameMsP99", lateFrames[lateFrames.size() * 99 / 100]);
+    endResult();
+
+    // 다른 측정에 영향이 없게 기본값으로 되돌림
+    setActiveRayCount(QUALITY_LADDER[QUALITY_DEFAULT_LEVEL].numRays);
+    maxSteps = QUALITY_LADDER[QUALITY_DEFAULT_LEVEL].maxSteps;
+}
+
+// --- 질량 편집 후 부분 재적분 ---
+// 천체 하나의 질량을 방향키 한 번만큼(+50) 바꾸고, 영향 기록으로 고른 광선만 다시 적분한 결과를 전체 재적분과 비교
+// 여러 시각에서 반복한 평균: 다시 적분한 광선 비율, 실제로 끝점이 허용치 넘게 움직인 광선 비율,
+// 그대로 둔 광선 중 허용치를 넘은 비율 / 최대 오차, 부분 / 전체 재적분 시간, 영향 기록 시간
+// 천체가 많으면 질량이 가장 작은 천체와 가장 큰 천체만 측정
+static void benchMassEdit(const BenchOptions& opt) {
+    const float delta = 50.0f;
+    const int samples = 8;
+    setBenchThreads(opt, opt.threads.back());
+    numRays = opt.rays.back();
+    maxSteps = opt.steps.back();
+    std::srand(opt.seed);
+    makeVelocities();
+    glm::vec3 startPos(lightPosition);
+
+    std::vector<int> edited;
+    if (bodies.count <= 4) {
+        for (int b = 0; b < bodies.count; b++) edited.push_back(b);
+    }
+    else {
+        int lightest = 0, heaviest = 0;
+        for (int b = 0; b < bodies.count; b++) {
+            if (bodies.mass[b] < bodies.mass[lightest]) lightest = b;
+            if (bodies.mass[b] > bodies.mass[heaviest]) heaviest = b;
+        }
+        edited = { lightest, heaviest };
+    }
+
+    RayPathArena basePaths;
+    RayInfluence influence;
+    std::vector<int> stale;
+    std::vector<glm::vec3> baseEnds(numRays), partialEnds(numRays);
+    const float savedTolerance = massEditTolerance;
+    for (float tolerance : opt.massTolerances) {
+        massEditTolerance = tolerance;
+        for (int body : edited) {
+            double retraced = 0.0, moved = 0.0, keptOver = 0.0, keptMax = 0.0;
+            double partialMs = 0.0, fullMs = 0.0, recordMs = 0.0;
+            bool recorded = true;
+            for (int k = 0; k < samples; k++) {
+                updateBodyPhysics(7.3f * k);
+                simulateRay(startPos, false);
+                basePaths = rayPaths;
+                for (int i = 0; i < numRays; i++) baseEnds[i] = basePaths.path(i).back();
+                double t0 = nowMs();
+                recordRayInfluence(bodySoA, basePaths, influence);
+                recordMs += nowMs() - t0;
+
+                bodies.mass[body] += delta;
+                t0 = nowMs();
+                recorded = selectMassEditRays(influence, body, delta, stale);
+                if (recorded) resimulateRays(startPos, stale, basePaths, influence);
+                else simulateRay(startPos, false);
+                partialMs += nowMs() - t0;
+                for (int i = 0; i < numRays; i++) partialEnds[i] = rayPaths.path(i).back();
+
+                t0 = nowMs();
+                simulateRay(startPos, false);
+                fullMs += nowMs() - t0;
+                bodies.mass[body] -= delta;
+
+                retraced += recorded ? (double)stale.size() : (double)numRays;
+                for (int i = 0; i < numRays; i++) {
+                    const glm::vec3& end = rayPaths.path(i).back();
+                    if (glm::length(end - baseEnds[i]) > tolerance) moved++;
+                    double error = glm::length(end - partialEnds[i]);
+                    if (error > tolerance) keptOver++;
+                    keptMax = std::max(keptMax, error);
+                }
+            }
+            const double total = (double)numRays * samples;
+
+            beginResult("massEdit");
+            addField("scene", opt.scene);
+            addField("numRays", numRays);
+            addField("threads", opt.threads.back());
+            addField("body", body);
+            addField("mass", bodies.mass[body]);
+            addField("deltaMass", delta);
+            addField("tolerance", tolerance);
+            addField("influenceRecorded", recorded ? 1 : 0);
+            addField("retracedFraction", retraced / total);
+            addField("movedFraction", moved / total);
+            addField("keptOverTolerance", keptOver / total);
+            addField("keptEndpointErrorMax", keptMax);
+            addField("partialMs", partialMs / samples);
+            addField("fullMs", fullMs / samples);
+            addField("recordMs", recordMs / samples);
+            endResult();
+        }
+    }
+    massEditTolerance = savedTolerance;
+}
+
+// --- 궤도 위상 캐시 ---
+// 한 주기 전체를 채우는 시간 / 메모리, 60 FPS 재생 중 적중률과 프레임당 시간을 매번 적분할 때와 비교
+// 저장된 경로가 같은 위상 시각에서 새로 적분한 경로와 같은지도 확인 (maxEndpointDiff = 0이어야 함)
+static void benchRayPhaseCache(const BenchOptions& opt) {
+    const int frames = 600;
+    setBenchThreads(opt, opt.threads.back());
+    numRays = opt.rays.back();
+    maxSteps = opt.steps.back();
+    std::srand(opt.seed);
+    makeVelocities();
+    glm::vec3 startPos(lightPosition);
+
+    const bool savedPhaseCache = useRayPhaseCache;
+    useRayPhaseCache = true;
+    invalidateRayPhaseCache();
+    double t0 = nowMs();
+    fillRayPhaseCache(0.0f, startPos, 1e9);
+    double fillMs = nowMs() - t0;
+    RayPhaseCacheStats stats = rayPhaseCacheStats();
+
+    beginResult("rayPhaseCache");
+    addField("scene", opt.scene);
+    addField("numRays", numRays);
+    addField("threads", opt.threads.back());
+    addField("period", stats.period);
+    if (!stats.active) {
+        addField("active", 0);
+        endResult();
+        return;
+    }
+    addField("active", 1);
+    addField("slots", RAY_PHASE_SLOTS);
+    addField("filledSlots", stats.filled);
+    addField("cacheMB", stats.bytes / (1024.0 * 1024.0));
+    addField("fillMsTotal", fillMs);
+    addField("slotWallMs", stats.period / RAY_PHASE_SLOTS / (60.0 * 0.02) * 1000.0);
+
+    // 재생: 시작 시각을 주기 한가운데로 옮겨서 위상 계산이 한 바퀴 뒤에도 맞는지 같이 확인
+    float time = (float)(stats.period * 7.5);
+    int hits = 0;
+    double replayMs = 0.0;
+    for (int frame = 0; frame < frames; frame++) {
+        time += 0.02f;
+        updateBodyPhysics(time);
+        double f0 = nowMs();
+        simulateRayPhase(time, startPos);
+        replayMs += nowMs() - f0;
+        if (rayPhaseCacheStats().hit) hits++;
+    }
+
+    // 정확성: 몇 위상을 재생한 경로와 같은 시각에서 새로 적분한 경로의 끝점 비교
+    double maxDiff = 0.0;
+    std::vector<glm::vec3> cachedEnds(numRays);
+    for (int k = 0; k < 16; k++) {
+        int slot = k * (RAY_PHASE_SLOTS / 16) + 5;
+        float slotTime = (float)(stats.period * slot / RAY_PHASE_SLOTS);
+        updateBodyPhysics(slotTime);
+        simulateRayPhase(slotTime, startPos);
+        for (int i = 0; i < numRays; i++) cachedEnds[i] = rayPaths.path(i).back();
+        simulateRay(startPos, false);
+        for (int i = 0; i < numRays; i++) {
+            maxDiff = std::max(maxDiff, (double)glm::length(rayPaths.path(i).back() - cachedEnds[i]));
+        }
+    }
+
+    // 비교: 캐시 없이 매 프레임 적분
+    invalidateRayPhaseCache();
+    useRayPhaseCache = false;
+    double liveMs = 0.0;
+    const int liveFrames = 60;
+    for (int frame = 0; frame < liveFrames; frame++) {
+        time += 0.02f;
+        updateBodyPhysics(time);
+        double f0 = nowMs();
+        simulateRay(startPos);
+        liveMs += nowMs() - f0;
+    }
+    useRayPhaseCache = savedPhaseCache;
+
+    // 위상 양자화: 광선은 가장 가까운 위상 시각의 배치로 계산되므로 천체가 위상 간격 절반 동안 움직이는 최대 거리
+    const float halfSlot = (float)(stats.period / RAY_PHASE_SLOTS * 0.5);
+    double bodyOffsetMax = 0.0;
+    std::vector<glm::vec3> slotPositions(bodies.count);
+    for (int k = 0; k < 64; k++) {
+        float t = (float)(stats.period * k / 64.0);
+        updateBodyPhysics(t);
+        for (int b = 0; b < bodies.count; b++) slotPositions[b] = bodies.position(b);
+        updateBodyPhysics(t + halfSlot);
+        for (int b = 0; b < bodies.count; b++) {
+            bodyOffsetMax = std::max(bodyOffsetMax, (double)glm::length(bodies.position(b) - slotPositions[b]));
+        }
+    }
+
+    addField("replayFrames", frames);
+    addField("hitRate", (double)hits / frames);
+    addField("replayMsMean", replayMs / frames);
+    addField("integrateMsMean", liveMs / liveFrames);
+    addField("maxEndpointDiff", maxDiff);
+    addField("phaseOffsetStepsMax", halfSlot / SIM_STEP_TIME);
+    addField("phaseBodyOffsetMax", bodyOffsetMax);
+    endResult();
+}
+
+static void benchUpdateBodyPhysics(const BenchOptions& opt) {
+    const int iterations = 10000;
+    float time = 0.0f;
+    long long allocBefore = allocationCount.load();
+    double t0 = nowMs();
+    for (int i = 0; i < iterations; i++) {
+        time += 0.02f;
+        updateBodyPhysics(time);
+    }
+    double totalMs = nowMs() - t0;
+
+    beginResult("updateBodyPhysics");
+    addField("scene", opt.scene);
+    addField("bodies", (double)bodies.count);
+    addField("iterations", iterations);
+    addField("usPerCall", totalMs * 1000.0 / iterations);
+    addField("allocationsPerCall", (double)(allocationCount.load() - allocBefore) / iterations);
+    endResult();
+}
+
+// 위성의 위성 ... 계층 (뿌리 10개, 천체마다 위성 10개씩 5단계 = 111110개)을 updateBodyPositions로 한 번 갱신하는 시간과
+// 예전 방식 (천체마다 new, 부모 포인터를 따라 앞에서부터 차례로 갱신) 비교, orbitSinCos의 std::sin / cos 대비 최대 오차
+static void benchBodyHierarchy(const BenchOptions& opt) {
+    const int roots = 10, fanout = 10, levels = 5;
+    BodyStore store;
+    std::srand(opt.seed);
+    int levelBegin = 0, levelEnd = 0;
+    for (int l = 0; l < levels; l++) {
+        const int parents = (l == 0) ? 1 : levelEnd - levelBegin;
+        const int children = (l == 0) ? roots : fanout;
+        const int nextBegin = store.count;
+        for (int p = 0; p < parents; p++) {
+            for (int c = 0; c < children; c++) {
+                Body body;
+                body.mass = glm::linearRand(1.0f, 50.0f);
+                body.radius = glm::linearRand(0.1f, 1.0f);
+                body.parent = (l == 0) ? -1 : levelBegin + p;
+                body.orbitRadius = glm::linearRand(1.0f, 100.0f) / (float)(l + 1);
+                body.orbitSpeed = glm::linearRand(0.1f, 5.0f);
+                addBody(store, body);
+            }
+        }
+        levelBegin = nextBegin;
+        levelEnd = store.count;
+    }
+    sortBodyLevels(store);
+
+    // 예전 방식
+    struct PointerBody {
+        glm::vec3 position;
+        PointerBody* parent;
+        glm::vec3 relativeOffset;
+        float orbitRadius, orbitSpeed;
+    };
+    std::vector<PointerBody*> pointerBodies(store.count);
+    for (int i = 0; i < store.count; i++) {
+        pointerBodies[i] = new PointerBody{ glm::vec3(0.0f), store.parent[i] < 0 ? nullptr : pointerBodies[store.parent[i]],
+            glm::vec3(store.centerX[i], store.centerY[i], store.centerZ[i]), store.orbitRadius[i], store.orbitSpeed[i] };
+    }
+    const int iterations = 200;
+    float time = 0.0f;
+    double t0 = nowMs();
+    for (int k = 0; k < iterations; k++) {
+        time += 0.02f;
+        for (PointerBody* body : pointerBodies) {
+            float angle = time * body->orbitSpeed * 0.5f;
+            glm::vec3 origin = body->parent ? body->parent->position : glm::vec3(0.0f);
+            body->position = origin + body->relativeOffset + glm::vec3(std::cos(angle) * body->orbitRadius, 0.0f, std::sin(angle) * body->orbitRadius);
+        }
+    }
+    double pointerUs = (nowMs() - t0) * 1000.0 / iterations;
+
+    // 같은 시각에서 두 방식의 위치 차이
+    double maxDiff = 0.0;
+    updateBodyPositions(store, time);
+    for (int i = 0; i < store.count; i++) {
+        maxDiff = std::max(maxDiff, (double)glm::length(store.position(i) - pointerBodies[i]->position));
+    }
+    for (PointerBody* body : pointerBodies) delete body;
+
+    double maxSinCosError = 0.0;
+    std::vector<float> angle(100000), sinValue(angle.size()), cosValue(angle.size());
+    for (size_t i = 0; i < angle.size(); i++) angle[i] = ((float)i - angle.size() / 2.0f) * 0.173f;
+    orbitSinCos(angle.data(), sinValue.data(), cosValue.data(), (int)angle.size());
+    for (size_t i = 0; i < angle.size(); i++) {
+        maxSinCosError = std::max(maxSinCosError, (double)std::fabs(sinValue[i] - std::sin(angle[i])));
+        maxSinCosError = std::max(maxSinCosError, (double)std::fabs(cosValue[i] - std::cos(angle[i])));
+    }
+
+    for (int threads : opt.threads) {
+        setBenchThreads(opt, threads);
+        updateBodyPositions(store, time); // 워밍업
+        long long allocBefore = allocationCount.load();
+        t0 = nowMs();
+        for (int k = 0; k < iterations; k++) {
+            time += 0.02f;
+            updateBodyPositions(store, time);
+        }
+        double storeUs = (nowMs() - t0) * 1000.0 / iterations;
+
+        beginResult("bodyHierarchy");
+        addField("bodies", store.count);
+        addField("levels", store.levels());
+        addField("threads", threads);
+        addField("iterations", iterations);
+        addField("usPerCall", storeUs);
+        addField("pointerUsPerCall", pointerUs);
+        addField("speedup", storeUs > 0 ? pointerUs / storeUs : 0.0);
+        addField("maxPositionDiff", maxDiff);
+        addField("maxSinCosError", maxSinCosError);
+        addField("allocationsPerCall", (double)(allocationCount.load() - allocBefore) / iterations);
+        endResult();
+    }
+}
+
+// 무작위 타원 궤도 천체 10000개 (이심률 0 ~ 0.95, 기울기 / 승교점 / 근점 / 위상 무작위)를 무작위 시각으로 건너뛰며 계산 (되감기 / 빨리 감기)
+// 같은 천체를 원궤도로 바꿨을 때와 비교하고, double 이분법으로 푼 위치 대비 최대 오차 (긴반지름 대비)
+static void benchKeplerOrbits(const BenchOptions& opt) {
+    const int count = 10000;
+    const float twoPi = 6.28318531f;
+    BodyStore elliptic, circular;
+    std::srand(opt.seed);
+    for (int i = 0; i < count; i++) {
+        Body body;
+        body.mass = 1.0f;
+        body.orbitRadius = glm::linearRand(10.0f, 180.0f);
+        body.orbitSpeed = glm::linearRand(0.1f, 3.0f);
+        body.eccentricity = glm::linearRand(0.0f, 0.95f);
+        body.inclination = glm::linearRand(0.0f, 3.14159265f);
+        body.ascendingNode = glm::linearRand(0.0f, twoPi);
+        body.periapsisArgument = glm::linearRand(0.0f, twoPi);
+        body.meanAnomaly = glm::linearRand(0.0f, twoPi);
+        addBody(elliptic, body);
+        body.eccentricity = body.inclination = body.ascendingNode = body.periapsisArgument = body.meanAnomaly = 0.0f;
+        addBody(circular, body);
+    }
+    sortBodyLevels(elliptic);
+    sortBodyLevels(circular);
+
+    const int iterations = 200;
+    std::vector<float> times(iterations);
+    for (float& t : times) t = glm::linearRand(-1000.0f, 1000.0f);
+
+    // 오차: 궤도면 위 점 a ((cos E - e), sqrt(1 - e^2) sin E)를 double로 다시 계산해서 비교
+    double maxError = 0.0;
+    updateBodyPositions(elliptic, times[0]);
+    for (int i = 0; i < count; i++) {
+        double e = elliptic.eccentricity[i];
+        // 평균 근점 이각은 계산과 같은 float 값에서 시작 (큰 시각에서 float M 자체의 반올림은 원궤도와 같으므로 빼고 잼)
+        float meanAnomaly = times[0] * 0.5f * elliptic.orbitSpeed[i] + elliptic.meanAnomaly[i];
+        double M = std::remainder((double)meanAnomaly, 2.0 * 3.14159265358979);
+        double lo = -4.0, hi = 4.0;
+        for (int k = 0; k < 60; k++) {
+            double mid = (lo + hi) * 0.5;
+            if (mid - e * std::sin(mid) > M) hi = mid;
+            else lo = mid;
+        }
+        double E = (lo + hi) * 0.5;
+        double a = elliptic.orbitRadius[i];
+        double u = a * (std::cos(E) - e), v = a * std::sin(E);
+        double dx = elliptic.x[i] - (u * elliptic.planePX[i] + v * elliptic.planeQX[i]);
+        double dy = elliptic.y[i] - (u * elliptic.planePY[i] + v * elliptic.planeQY[i]);
+        double dz = elliptic.z[i] - (u * elliptic.planePZ[i] + v * elliptic.planeQZ[i]);
+        maxError = std::max(maxError, std::sqrt(dx * dx + dy * dy + dz * dz) / a);
+    }
+
+    for (int threads : opt.threads) {
+        setBenchThreads(opt, threads);
+        double t0 = nowMs();
+        for (float t : times) updateBodyPositions(circular, t);
+        double circularUs = (nowMs() - t0) * 1000.0 / iterations;
+        long long allocBefore = allocationCount.load();
+        t0 = nowMs();
+        for (float t : times) updateBodyPositions(elliptic, t);
+        double ellipticUs = (nowMs() - t0) * 1000.0 / iterations;
+
+        beginResult("keplerOrbits");
+        addField("bodies", count);
+        addField("threads", threads);
+        addField("iterations", iterations);
+        addField("usPerCall", ellipticUs);
+        addField("circularUsPerCall", circularUs);
+        addField("nsPerBody", ellipticUs * 1000.0 / count);
+        addField("maxRelativeError", maxError);
+        addField("allocationsPerCall", (double)(allocationCount.load() - allocBefore) / iterations);
+        endResult();
+    }
+}
+
+// 작업 풀 자체 비용: 빈 작업 루프 한 번의 시간 (웨이브프런트는 프레임마다 수십 번 부름)과
+// 작업마다 걸리는 시간이 크게 다를 때 작업 훔치기로 나눈 결과 (스레드별 이상적인 시간 대비)
+static void benchTaskPool(const BenchOptions& opt) {
+    for (int threads : opt.threads) {
+        setBenchThreads(opt, threads);
+        std::atomic<long long> sink(0);
+        auto empty = [&](int begin, int end) { sink += end - begin; };
+        parallelFor(4096, 64, empty); // 워밍업
+
+        const int loops = 2000;
+        double t0 = nowMs();
+        for (int k = 0; k < loops; k++) parallelFor(4096, 64, empty);
+        double loopUs = (nowMs() - t0) * 1000.0 / loops;
+
+        // 앞쪽 작업일수록 오래 걸리는 루프 (광선이 블랙홀에 일찍 빠지는 것과 반대로 한쪽에 몰린 경우)
+        const int tasks = 256;
+        auto skewed = [&](int begin, int end) {
+            for (int t = begin; t < end; t++) {
+                double x = 0.0;
+                int work = (tasks - t) * 200;
+                for (int i = 0; i < work; i++) x += std::sqrt((double)i + t);
+                sink += (long long)x;
+            }
+        };
+        t0 = nowMs();
+        parallelFor(tasks, 1, skewed);
+        double skewedMs = nowMs() - t0;
+        setBenchThreads(opt, 1);
+        t0 = nowMs();
+        parallelFor(tasks, 1, skewed);
+        double serialMs = nowMs() - t0;
+        setBenchThreads(opt, threads);
+
+        beginResult("taskPool");
+        addField("threads", threads);
+        addField("affinity", opt.affinity ? 1 : 0);
+        addField("emptyLoopUs", loopUs);
+        addField("skewedMs", skewedMs);
+        addField("skewedSerialMs", serialMs);
+        addField("skewedSpeedup", skewedMs > 0 ? serialMs / skewedMs : 0.0);
+        endResult();
+    }
+}
+
+// 마지막으로 계산된 rayPaths를 이용해 스플라인 보간/컬링을 측정
+static void benchSplineAndCulling() {
+    const int segments = 10;
+    long long points = 0;
+    glm::vec3 checksum(0.0f);
+
+    double t0 = nowMs();
+    for (int r = 0; r < rayPaths.numPaths; r++) {
+        RayPathView path = rayPaths.path(r);
+        for (size_t i = 0; i + 1 < path.size(); ++i) {
+            glm::vec3 p0 = (i == 0) ? path[0] : path[i - 1];
+            glm::vec3 p3 = (i + 1 == path.size() - 1) ? path[i + 1] : path[i + 2];
+            for (int j = 0; j <= segments; ++j) {
+                checksum += catmullRom(p0, path[i], path[i + 1], p3, (float)j / (float)segments);
+                points++;
+            }
+        }
+    }
+    double splineMs = nowMs() - t0;
+
+    beginResult("catmullRom");
+    addField("segments", segments);
+    addField("points", (double)points);
+    addField("pointsPerSec", splineMs > 0 ? points / (splineMs / 1000.0) : 0.0);
+    addField("checksum", checksum.x + checksum.y + checksum.z);
+    endResult();
+
+    // 같은 곡선을 작업 풀로 경로 묶음마다 나눠 계산 (구간 이음새 점을 한 번만 쓰므로 점 수는 조금 적음)
+    static RayPathArena tessellated;
+    tessellateRayPaths(rayPaths, segments, tessellated); // 워밍업 (용량 확보)
+    const int repeats = 20;
+    t0 = nowMs();
+    for (int k = 0; k < repeats; k++) tessellateRayPaths(rayPaths, segments, tessellated);
+    double tessellateMs = (nowMs() - t0) / repeats;
+
+    beginResult("tessellateRayPaths");
+    addField("threads", taskPoolThreads());
+    addField("segments", segments);
+    addField("points", (double)tessellated.used);
+    addField("pointsPerSec", tessellateMs > 0 ? (double)tessellated.used / (tessellateMs / 1000.0) : 0.0);
+    endResult();
+
+    // main.cpp 기본 카메라(거리 80, 원점 주시)와 같은 시점
+    glm::mat4 mvp = glm::perspective(glm::radians(60.0f), 1280.0f / 720.0f, 1.0f, 500.0f)
+        * glm::lookAt(glm::vec3(0.0f, 0.0f, 80.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    long long tested = 0, visible = 0;
+    t0 = nowMs();
+    for (int r = 0; r < rayPaths.numPaths; r++) {
+        for (const auto& p : rayPaths.path(r)) {
+            if (isPointVisible(p, mvp)) visible++;
+            tested++;
+        }
+    }
+    double cullMs = nowMs() - t0;
+
+    beginResult("isPointVisible");
+    addField("points", (double)tested);
+    addField("visible", (double)visible);
+    addField("pointsPerSec", cullMs > 0 ? tested / (cullMs / 1000.0) : 0.0);
+    endResult();
+}
+
+// --- N체 모드 ---
+// 1) 기본 장면을 오래 적분했을 때 적분기별 에너지 드리프트 (심플렉틱이면 커지지 않고 흔들림)
+// 2) 무작위 궤도 천체 N개에서 직접 합산 / 트리 힘 계산과 스텝 시간, 트리 가속도의 오차
+static void benchNBody(const BenchOptions& opt) {
+    if (opt.nbodyBodies <= 0) return;
+    const int integrators[2] = { NBODY_LEAPFROG, NBODY_YOSHIDA4 };
+    const char* integratorNames[2] = { "leapfrog", "yoshida4" };
+
+    // 스텝 수만큼 advanceNBody를 나눠 부름 (한 번에 NBODY_MAX_STEPS_PER_UPDATE까지)
+    auto runSteps = [](int steps) {
+        const double h = nbodyTimeStep;
+        for (int done = 0; done < steps;) {
+            int chunk = std::min(NBODY_MAX_STEPS_PER_UPDATE, steps - done);
+            done += std::max(1, advanceNBody((float)(nbodyStats.time + (chunk + 0.5) * h)));
+        }
+    };
+
+    const int driftSteps = 20000;
+    for (int k = 0; k < 2; k++) {
+        buildScene("default", opt.seed);
+        setBenchThreads(opt, 1);
+        nbodyIntegrator = integrators[k];
+        nbodyForce = NBODY_FORCE_DIRECT;
+        nbodyEnergyInterval = 64;
+        resetNBody();
+        advanceNBody(0.0f);
+        double t0 = nowMs();
+        runSteps(driftSteps);
+        double ms = nowMs() - t0;
+        measureNBodyEnergy();
+
+        beginResult("nbodyDrift");
+        addField("integrator", std::string(integratorNames[k]));
+        addField("bodies", bodies.count);
+        addField("steps", (double)nbodyStats.steps);
+        addField("timeStep", nbodyTimeStep);
+        addField("usPerStep", ms * 1000.0 / driftSteps);
+        addField("relativeDrift", nbodyStats.relativeDrift);
+        addField("maxRelativeDrift", nbodyStats.maxRelativeDrift);
+        endResult();
+    }
+
+    // 중심 천체 + 기울어진 타원 궤도 천체 (질량이 작아 처음에는 케플러 궤도에 가까움)
+    const int count = opt.nbodyBodies;
+    const float twoPi = 6.28318531f;
+    clearBodies(bodies);
+    std::srand(opt.seed);
+    Body core;
+    core.mass = 800.0f;
+    core.radius = 4.0f;
+    int coreIndex = addBody(bodies, core);
+    reserveBodies(bodies, count);
+    for (int i = 1; i < count; i++) {
+        Body star;
+        star.mass = glm::linearRand(0.05f, 0.5f);
+        star.radius = 0.5f;
+        star.parent = coreIndex;
+        star.orbitRadius = glm::linearRand(10.0f, 180.0f);
+        star.orbitSpeed = glm::linearRand(0.1f, 3.0f);
+        star.eccentricity = glm::linearRand(0.0f, 0.5f);
+        star.inclination = glm::linearRand(0.0f, 3.14159265f);
+        star.ascendingNode = glm::linearRand(0.0f, twoPi);
+        star.periapsisArgument = glm::linearRand(0.0f, twoPi);
+        star.meanAnomaly = glm::linearRand(0.0f, twoPi);
+        addBody(bodies, star);
+    }
+    sortBodyLevels(bodies);
+    updateBodyPositions(bodies, 0.0f);
+
+    // 트리 가속도 오차 (같은 커널의 직접 합산 기준)
+    {
+        const int n = bodies.count;
+        std::vector<float> dax(n), day(n), daz(n), tax(n), tay(n), taz(n);
+        computeNBodyAccelerations(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), n, false, dax.data(), day.data(), daz.data());
+        computeNBodyAccelerations(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), n, true, tax.data(), tay.data(), taz.data());
+        double maxError = 0.0, sumSq = 0.0;
+        for (int i = 0; i < n; i++) {
+            double ex = tax[i] - dax[i], ey = tay[i] - day[i], ez = taz[i] - daz[i];
+            double ref = std::sqrt((double)dax[i] * dax[i] + (double)day[i] * day[i] + (double)daz[i] * daz[i]);
+            double err = std::sqrt(ex * ex + ey * ey + ez * ez) / std::max(ref, 1e-12);
+            maxError = std::max(maxError, err);
+            sumSq += err * err;
+        }
+        beginResult("nbodyTreeError");
+        addField("bodies", n);
+        addField("theta", nbodyTheta);
+        addField("maxRelativeError", maxError);
+        addField("rmsRelativeError", std::sqrt(sumSq / n));
+        endResult();
+    }
+
+    // 천체 수별 힘 계산 한 번 (NBODY_TREE_MIN_BODIES를 정한 기준)
+    for (int threads : opt.threads) {
+        setBenchThreads(opt, threads);
+        for (int n = 1024; n <= count; n *= 2) {
+            std::vector<float> ax(n), ay(n), az(n);
+            double ms[2];
+            for (int tree = 0; tree < 2; tree++) {
+                const int repeats = 3;
+                computeNBodyAccelerations(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), n, tree != 0, ax.data(), ay.data(), az.data());
+                double t0 = nowMs();
+                for (int r = 0; r < repeats; r++) {
+                    computeNBodyAccelerations(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), n, tree != 0, ax.data(), ay.data(), az.data());
+                }
+                ms[tree] = (nowMs() - t0) / repeats;
+            }
+            beginResult("nbodyForce");
+            addField("bodies", n);
+            addField("threads", threads);
+            addField("directMs", ms[0]);
+            addField("treeMs", ms[1]);
+            addField("directGInteractionsPerSec", (double)n * n / (ms[0] * 1e6));
+            endResult();
+        }
+    }
+
+    // 전체 스텝 (에너지는 끝에 한 번만 잼)
+    const int stepCount = 4;
+    for (int threads : opt.threads) {
+        setBenchThreads(opt, threads);
+        for (int force = NBODY_FORCE_DIRECT; force <= NBODY_FORCE_TREE; force++) {
+            for (int k = 0; k < 2; k++) {
+                nbodyIntegrator = integrators[k];
+                nbodyForce = force;
+                nbodyEnergyInterval = 0;
+                resetNBody();
+                advanceNBody(0.0f);
+                double t0 = nowMs();
+                runSteps(stepCount);
+                double ms = nowMs() - t0;
+                measureNBodyEnergy();
+
+                beginResult("nbodyStep");
+                addField("integrator", std::string(integratorNames[k]));
+                addField("force", std::string(force == NBODY_FORCE_TREE ? "tree" : "direct"));
+                addField("bodies", bodies.count);
+                addField("threads", threads);
+                addField("msPerStep", ms / stepCount);
+                addField("forceMs", nbodyStats.forceMs);
+                addField("relativeDrift", nbodyStats.relativeDrift);
+                endResult();
+            }
+        }
+    }
+
+    nbodyIntegrator = NBODY_LEAPFROG;
+    nbodyForce = NBODY_FORCE_AUTO;
+    nbodyEnergyInterval = 64;
+    resetNBody();
+}
+
+// --- 장면 파일 ---
+// cluster처럼 무작위 궤도 천체 sceneBodies개를 텍스트 장면으로 써서
+// 컴파일(텍스트 -> 바이너리, 첫 매핑 포함) 시간과 최신 바이너리를 다시 매핑해서 읽는 시간을 잼
+static void benchSceneFile(const BenchOptions& opt) {
+    if (opt.sceneBodies <= 0) return;
+    std::error_code ec;
+    std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+    if (ec) dir = ".";
+    const std::string textPath = (dir / "event_horizon_bench.ehscene").string();
+    const std::string binaryPath = sceneBinaryPath(textPath.c_str());
+    std::filesystem::remove(binaryPath, ec);
+
+    FILE* f = std::fopen(textPath.c_str(), "w");
+    if (!f) return;
+    std::srand(opt.seed);
+    std::fprintf(f, "body core mass 800 radius 4 color 0.1 0.1 0.1 orbit 50 0.3 spin 0.05\n");
+    for (int i = 1; i < opt.sceneBodies; i++) {
+        std::fprintf(f, "body star%d mass %.4g radius %.4g color 0.8 0.8 0.6 parent core orbit %.5g %.4g spin 1\n", i,
+            glm::linearRand(5.0f, 50.0f), glm::linearRand(0.3f, 1.5f), glm::linearRand(10.0f, 180.0f), glm::linearRand(0.1f, 3.0f));
+    }
+    std::fclose(f);
+
+    std::string error;
+    double t0 = nowMs();
+    bool ok = loadSceneFile(textPath.c_str(), &error);
+    double compileMs = nowMs() - t0;
+
+    // 바이너리가 최신이라 매핑해서 복사만 함 (천체 배열 용량은 첫 번째 읽기에서 잡힘)
+    const int repeats = 5;
+    long long allocations = allocationCount.load();
+    t0 = nowMs();
+    for (int k = 0; ok && k < repeats; k++) ok = loadSceneFile(textPath.c_str(), &error);
+    double loadMs = (nowMs() - t0) / repeats;
+    allocations = allocationCount.load() - allocations;
+    if (!ok) std::fprintf(stderr, "sceneFile: %s\n", error.c_str());
+
+    beginResult("sceneFile");
+    addField("bodies", (double)bodies.count);
+    addField("textBytes", (double)std::filesystem::file_size(textPath, ec));
+    addField("binaryBytes", (double)std::filesystem::file_size(binaryPath, ec));
+    addField("compileMs", compileMs);
+    addField("loadMs", loadMs);
+    addField("bodiesPerSec", loadMs > 0 ? bodies.count / (loadMs / 1000.0) : 0.0);
+    addField("allocationsPerLoad", (double)allocations / repeats);
+    endResult();
+
+    std::filesystem::remove(textPath, ec);
+    std::filesystem::remove(binaryPath, ec);
+}
+
+static void benchTextureCache(const std::string& filename, const Image& source) {
+    std::string cachePath = textureCachePath(filename.c_str());
+    double t0 = nowMs();
+    bool built = buildTextureCache(filename.c_str(), cachePath.c_str());
+    double buildMs = nowMs() - t0;
+
+    MappedTexture texture;
+    bool rebuilt = false;
+    t0 = nowMs();
+    bool opened = built && openTextureCache(filename.c_str(), texture, &rebuilt);
+    // 업로드할 때처럼 모든 레벨을 한 번 읽음 (페이지 폴트 포함)
+    size_t cacheBytes = 0;
+    unsigned checksum = 0;
+    for (int i = 0; opened && i < texture.levels; i++) {
+        for (size_t k = 0; k < texture.level[i].size; k += 4096) checksum += texture.level[i].data[k];
+        cacheBytes += texture.level[i].size;
+    }
+    double openMs = nowMs() - t0;
+
+    // 레벨 0을 풀어서 원본과 PSNR 비교
+    double psnr = 0.0;
+    if (opened && texture.format == TEXTURE_CACHE_BC1) {
+        std::vector<unsigned char> rgb((size_t)texture.width * texture.height * 3);
+        decodeBC1Level(texture.level[0], rgb.data());
+        double sumSq = 0.0;
+        for (size_t i = 0; i < rgb.size(); i++) {
+            double d = (double)rgb[i] - source.pixels[i];
+            sumSq += d * d;
+        }
+        double mse = sumSq / rgb.size();
+        psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+    }
+
+    beginResult("textureCache");
+    addField("file", filename);
+    addField("ok", (opened && !rebuilt) ? 1.0 : 0.0);
+    addField("levels", texture.levels);
+    addField("buildMs", buildMs);
+    addField("openMs", openMs);
+    addField("cacheMB", cacheBytes / 1e6);
+    addField("uncompressedMB", (double)source.width * source.height * 3 * 4.0 / 3.0 / 1e6); // RGB + 밉맵
+    addField("psnr", psnr);
+    addField("checksum", checksum);
+    endResult();
+    closeTextureCache(texture);
+}
+
+static void benchTextureDecode(const std::string& filename) {
+    Image image;
+    long long allocBefore = allocationCount.load();
+    double t0 = nowMs();
+    bool ok = loadImageFile(filename.c_str(), image);
+    double ms = nowMs() - t0;
+
+    beginResult("loadImageFile");
+    addField("file", filename);
+    addField("ok", ok ? 1.0 : 0.0);
+    addField("width", image.width);
+    addField("height", image.height);
+    addField("ms", ms);
+    addField("megapixelsPerSec", (ok && ms > 0) ? (double)image.width * image.height / 1e6 / (ms / 1000.0) : 0.0);
+    addField("allocations", (double)(allocationCount.load() - allocBefore));
+    endResult();
+
+    // 밉맵 + BC1 캐시: 만드는 시간 (첫 실행), 매핑 시간 (이후 실행), 크기, 레벨 0 화질
+    if (ok && image.channels == 3) benchTextureCache(filename, image);
+    freeImage(image);
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    if (!parseArgs(argc, argv, opt)) return 1;
+    if (opt.frames < 1) opt.frames = 1;
+
+    if (!buildScene(opt.scene, opt.seed)) {
+        std::fprintf(stderr, "unknown scene: %s\n", opt.scene.c_str());
+        return 1;
+    }
+
+    benchUpdateBodyPhysics(opt);
+    benchBodyHierarchy(opt);
+    benchKeplerOrbits(opt);
+    benchTaskPool(opt);
+
+    for (const auto& engine : opt.engines) {
+        for (int rays : opt.rays) {
+            for (int steps : opt.steps) {
+                for (int threads : opt.threads) {
+                    for (float escape : opt.escapes) {
+                        for (float theta : opt.thetas) {
+                            for (int field : opt.fields) {
+                                for (int stride : opt.amortize) {
+                                    benchSimulateRay(opt, engine, rays, steps, threads, escape, theta, field, stride);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    benchSplineAndCulling();
+    benchOctreeForce(opt);
+    for (int field : opt.fields) {
+        if (field) benchAccelField(opt);
+    }
+
+    if (opt.accuracy) benchAccuracy(opt);
+    if (opt.simThread) benchSimulationThread(opt);
+    if (opt.governor) benchQualityGovernor(opt);
+    if (opt.phaseCache) benchRayPhaseCache(opt);
+    if (!opt.massTolerances.empty()) benchMassEdit(opt);
+
+    for (const auto& texture : opt.textures) {
+        benchTextureDecode(texture);
+    }
+    benchNBody(opt);     // bodies를 바꾸므로 뒤쪽에
+    benchSceneFile(opt); // bodies를 큰 장면으로 바꾸므로 마지막에
+
+    std::string json = "{\n  \"seed\": " + std::to_string(opt.seed) +
+        ",\n  \"simd\": \"" + rayBatchInstructionSet() +
+        "\",\n  \"results\": [\n" + results + "\n  ]\n}\n";
+
+    if (opt.outPath.empty()) {
+        std::fputs(json.c_str(), stdout);
+    }
+    else {
+        FILE* f = std::fopen(opt.outPath.c_str(), "w");
+        if (!f) {
+            std::fprintf(stderr, "cannot write %s\n", opt.outPath.c_str());
+            stopTaskPool();
+            return 1;
+        }
+        std::fputs(json.c_str(), f);
+        std::fclose(f);
+    }
+    stopTaskPool();
+    return 0;
+}
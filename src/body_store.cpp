@@ -0,0 +1,308 @@
+﻿#include "body_store.h"
+#include <algorithm>
+#include <cmath>
+#include "task_pool.h"
+#include "simd_lanes.h"
+
+// 단계 하나를 작업 풀로 나눌 때 작업 하나가 맡는 천체 수 (RAY_BATCH_LANES의 배수, 작은 장면은 호출한 스레드에서 바로 끝남)
+static const int BODY_UPDATE_TASK_BODIES = 4096;
+
+// 천체마다 값 하나씩인 float 성분 (정렬 / 비우기 / 용량 확보를 한 번에)
+static std::vector<float> BodyStore::* const FLOAT_COLUMNS[] = {
+    &BodyStore::x, &BodyStore::y, &BodyStore::z,
+    &BodyStore::mass, &BodyStore::radius,
+    &BodyStore::colorR, &BodyStore::colorG, &BodyStore::colorB,
+    &BodyStore::centerX, &BodyStore::centerY, &BodyStore::centerZ,
+    &BodyStore::orbitRadius, &BodyStore::orbitSpeed, &BodyStore::rotationSpeed,
+    &BodyStore::eccentricity, &BodyStore::meanAnomaly,
+    &BodyStore::planePX, &BodyStore::planePY, &BodyStore::planePZ,
+    &BodyStore::planeQX, &BodyStore::planeQY, &BodyStore::planeQZ,
+};
+
+void clearBodies(BodyStore& store) {
+    for (auto column : FLOAT_COLUMNS) (store.*column).clear();
+    store.parent.clear();
+    store.levelStart.clear();
+    store.count = 0;
+}
+
+void reserveBodies(BodyStore& store, int count) {
+    for (auto column : FLOAT_COLUMNS) (store.*column).reserve(count);
+    store.parent.reserve(count);
+}
+
+int addBody(BodyStore& store, const Body& body) {
+    // 위치는 updateBodyPositions가 채움
+    store.x.push_back(0.0f);
+    store.y.push_back(0.0f);
+    store.z.push_back(0.0f);
+    store.mass.push_back(body.mass);
+    store.radius.push_back(body.radius);
+    store.colorR.push_back(body.color.r);
+    store.colorG.push_back(body.color.g);
+    store.colorB.push_back(body.color.b);
+    store.centerX.push_back(body.relativeOffset.x);
+    store.centerY.push_back(body.relativeOffset.y);
+    store.centerZ.push_back(body.relativeOffset.z);
+    store.orbitRadius.push_back(body.orbitRadius);
+    store.orbitSpeed.push_back(body.orbitSpeed);
+    store.rotationSpeed.push_back(body.rotationSpeed);
+
+    // 궤도면 기저 (기준면 XZ에 맞춰 표준 식의 X, Y, Z를 x, z, y로 놓음)
+    // 각도가 모두 0이면 P = +X, Q = +Z라서 예전 원운동 식 (cos * r, 0, sin * r)과 같음
+    const float e = std::min(std::max(body.eccentricity, 0.0f), ORBIT_MAX_ECCENTRICITY);
+    const float cn = std::cos(body.ascendingNode), sn = std::sin(body.ascendingNode);
+    const float cw = std::cos(body.periapsisArgument), sw = std::sin(body.periapsisArgument);
+    const float ci = std::cos(body.inclination), si = std::sin(body.inclination);
+    const float minor = std::sqrt(1.0f - e * e);
+    store.eccentricity.push_back(e);
+    store.meanAnomaly.push_back(body.meanAnomaly);
+    store.planePX.push_back(cn * cw - sn * sw * ci);
+    store.planePY.push_back(sw * si);
+    store.planePZ.push_back(sn * cw + cn * sw * ci);
+    store.planeQX.push_back((-cn * sw - sn * cw * ci) * minor);
+    store.planeQY.push_back(cw * si * minor);
+    store.planeQZ.push_back((-sn * sw + cn * cw * ci) * minor);
+    store.parent.push_back(body.parent);
+    store.levelStart.clear();
+    return store.count++;
+}
+
+bool sortBodyLevels(BodyStore& store, std::vector<int>* order) {
+    const int n = store.count;
+    // 부모를 따라 올라가며 깊이를 구함 (깊이를 아는 천체나 뿌리에서 멈추고, n번 넘게 올라가면 순환)
+    std::vector<int> depth(n, -1), chain;
+    int levels = 0;
+    for (int i = 0; i < n; i++) {
+        chain.clear();
+        int b = i;
+        while (b >= 0 && depth[b] < 0) {
+            if ((int)chain.size() >= n) return false;
+            chain.push_back(b);
+            b = store.parent[b];
+            if (b < -1 || b >= n) return false;
+        }
+        int d = (b < 0) ? -1 : depth[b];
+        for (int k = (int)chain.size() - 1; k >= 0; k--) depth[chain[k]] = ++d;
+        levels = std::max(levels, depth[i] + 1);
+    }
+
+    // 깊이별 계수 정렬 (같은 단계 안에서는 원래 순서 유지)
+    std::vector<int> start(levels + 1, 0);
+    for (int i = 0; i < n; i++) start[depth[i] + 1]++;
+    for (int l = 0; l < levels; l++) start[l + 1] += start[l];
+    std::vector<int> fill(start.begin(), start.end() - 1), newIndex(n);
+    bool sorted = true;
+    for (int i = 0; i < n; i++) {
+        newIndex[i] = fill[depth[i]]++;
+        sorted = sorted && newIndex[i] == i;
+    }
+
+    if (!sorted) {
+        std::vector<float> moved(n);
+        for (auto column : FLOAT_COLUMNS) {
+            std::vector<float>& values = store.*column;
+            for (int i = 0; i < n; i++) moved[newIndex[i]] = values[i];
+            values.swap(moved);
+        }
+        std::vector<int> parents(n);
+        for (int i = 0; i < n; i++) parents[newIndex[i]] = (store.parent[i] < 0) ? -1 : newIndex[store.parent[i]];
+        store.parent.swap(parents);
+    }
+    if (order) {
+        order->resize(n);
+        for (int i = 0; i < n; i++) (*order)[newIndex[i]] = i;
+    }
+    store.levelStart.swap(start);
+    return true;
+}
+
+// --- lane sin / cos ---
+// angle = k * (pi / 2) + r (|r| <= pi / 4)로 줄이고 (pi / 2는 세 조각으로 나눠 빼서 오차를 줄임)
+// r의 sin / cos 다항식(Cephes sinf / cosf 계수)을 k mod 4 사분면에 맞게 바꿔 끼움 (분기 없음)
+static inline void vSinCos(vfloat angle, vfloat& sinOut, vfloat& cosOut) {
+    const vfloat zero = vSet1(0.0f);
+    const vfloat half = vSet1(0.5f);
+    vfloat k = vFloor(vAdd(vMul(angle, vSet1(0.636619772f)), half));
+    vfloat r = vSub(angle, vMul(k, vSet1(1.5703125f)));
+    r = vSub(r, vMul(k, vSet1(4.837512969970703125e-4f)));
+    r = vSub(r, vMul(k, vSet1(7.54978995489188216e-8f)));
+
+    vfloat r2 = vMul(r, r);
+    vfloat sp = vFma(vFma(vSet1(-1.9515295891e-4f), r2, vSet1(8.3321608736e-3f)), r2, vSet1(-1.6666654611e-1f));
+    vfloat s = vFma(vMul(sp, r2), r, r);
+    vfloat cp = vFma(vFma(vSet1(2.443315711809948e-5f), r2, vSet1(-1.388731625493765e-3f)), r2, vSet1(4.166664568298827e-2f));
+    vfloat c = vFma(vMul(cp, r2), r2, vSub(vSet1(1.0f), vMul(r2, half)));
+
+    // q = k mod 4: 1, 3이면 sin / cos 맞바꿈, 2, 3이면 sin 부호, 1, 2면 cos 부호를 뒤집음
+    vfloat q = vSub(k, vMul(vFloor(vMul(k, vSet1(0.25f))), vSet1(4.0f)));
+    vfloat qHalf = vMul(q, half);
+    vmask swap = vGreater(vSub(qHalf, vFloor(qHalf)), vSet1(0.25f));
+    vmask sinNeg = vGreater(q, vSet1(1.5f));
+    vmask cosNeg = vLess(vAbs(vSub(q, vSet1(1.5f))), vSet1(1.0f));
+    vfloat sq = vSelect(swap, c, s);
+    vfloat cq = vSelect(swap, s, c);
+    sinOut = vSelect(sinNeg, vSub(zero, sq), sq);
+    cosOut = vSelect(cosNeg, vSub(zero, cq), cq);
+}
+
+void orbitSinCos(const float* angle, float* sinOut, float* cosOut, int count) {
+    const int W = RAY_BATCH_LANES;
+    alignas(64) float a[RAY_BATCH_LANES], s[RAY_BATCH_LANES], c[RAY_BATCH_LANES];
+    for (int i = 0; i < count; i += W) {
+        const int lanes = std::min(W, count - i);
+        for (int l = 0; l < W; l++) a[l] = angle[i + std::min(l, lanes - 1)];
+        vfloat vs, vc;
+        vSinCos(vLoad(a), vs, vc);
+        vStore(s, vs);
+        vStore(c, vc);
+        std::copy(s, s + lanes, sinOut + i);
+        std::copy(c, c + lanes, cosOut + i);
+    }
+}
+
+// --- 케플러 방정식 ---
+// KEPLER_ITERATIONS번 고정 Halley 반복 (lane마다 반복 횟수가 같아서 분기 없음)
+// M을 [-pi, pi]로 줄이고 Danby 시작값 E0 = M + 0.85 e sign(M)에서 시작하면 e <= 0.9는 3번, e <= ORBIT_MAX_ECCENTRICITY는 4번이면
+// float 정밀도까지 수렴 (e = 0.99에서 3번이면 근점 근처 오차가 약 3e-3)
+static const int KEPLER_ITERATIONS = 4;
+
+static inline vfloat vSolveKepler(vfloat meanAnomaly, vfloat e) {
+    const vfloat one = vSet1(1.0f);
+    const vfloat half = vSet1(0.5f);
+    vfloat k = vFloor(vAdd(vMul(meanAnomaly, vSet1(0.159154943f)), half));
+    vfloat m = vSub(meanAnomaly, vMul(k, vSet1(6.28125f)));
+    m = vSub(m, vMul(k, vSet1(1.9353071795864769e-3f)));
+
+    vfloat sign = vSelect(vLess(m, vSet1(0.0f)), vSet1(-1.0f), one);
+    vfloat E = vFma(vMul(e, vSet1(0.85f)), sign, m);
+    for (int it = 0; it < KEPLER_ITERATIONS; it++) {
+        vfloat s, c;
+        vSinCos(E, s, c);
+        vfloat es = vMul(e, s);
+        vfloat f = vSub(vSub(E, es), m);   // f(E) = E - e sin E - M
+        vfloat df = vSub(one, vMul(e, c)); // f'(E) = 1 - e cos E (>= 1 - e > 0)
+        // Halley: E -= f / (f' - f f'' / (2 f')), f'' = e sin E
+        vfloat denom = vSub(df, vDiv(vMul(vMul(f, es), half), df));
+        E = vSub(E, vDiv(f, denom));
+    }
+    return E;
+}
+
+void solveKepler(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, int count) {
+    const int W = RAY_BATCH_LANES;
+    alignas(64) float m[RAY_BATCH_LANES], e[RAY_BATCH_LANES], E[RAY_BATCH_LANES];
+    for (int i = 0; i < count; i += W) {
+        const int lanes = std::min(W, count - i);
+        for (int l = 0; l < W; l++) {
+            m[l] = meanAnomaly[i + std::min(l, lanes - 1)];
+            e[l] = eccentricity[i + std::min(l, lanes - 1)];
+        }
+        vStore(E, vSolveKepler(vLoad(m), vLoad(e)));
+        std::copy(E, E + lanes, eccentricAnomaly + i);
+    }
+}
+
+// --- 공전 위치 ---
+// 천체 W개: 위치 = 부모 위치(0단계는 원점) + 공전 중심 오프셋 + 궤도면 위의 점
+// 궤도면 위의 점 = a (cos E - e) P + a sin E Q (Q에 sqrt(1 - e^2)가 곱해져 있음)
+// 이심률이 0인 lane은 E = M을 그대로 써서 예전 원운동 식 (cos M * r, 0, sin M * r)과 같은 값 (FMA로 합치는 위치에 따라 마지막 비트는 다를 수 있음)
+enum OrbitInput {
+    ORBIT_SPEED, ORBIT_RADIUS,
+    ORBIT_CENTER_X, ORBIT_CENTER_Y, ORBIT_CENTER_Z,
+    ORBIT_ECCENTRICITY, ORBIT_MEAN_ANOMALY,
+    ORBIT_PX, ORBIT_PY, ORBIT_PZ,
+    ORBIT_QX, ORBIT_QY, ORBIT_QZ,
+    ORBIT_INPUT_COUNT
+};
+
+static std::vector<float> BodyStore::* const ORBIT_INPUT_COLUMNS[ORBIT_INPUT_COUNT] = {
+    &BodyStore::orbitSpeed, &BodyStore::orbitRadius,
+    &BodyStore::centerX, &BodyStore::centerY, &BodyStore::centerZ,
+    &BodyStore::eccentricity, &BodyStore::meanAnomaly,
+    &BodyStore::planePX, &BodyStore::planePY, &BodyStore::planePZ,
+    &BodyStore::planeQX, &BodyStore::planeQY, &BodyStore::planeQZ,
+};
+
+struct OrbitLanes {
+    const float* in[ORBIT_INPUT_COUNT];
+    const int* parent; // 0단계면 nullptr
+    float* x;
+    float* y;
+    float* z;
+};
+
+static inline void vUpdateOrbit(const BodyStore& store, const OrbitLanes& lanes, vfloat halfTime) {
+    const vfloat zero = vSet1(0.0f);
+    vfloat M = vAdd(vMul(halfTime, vLoadU(lanes.in[ORBIT_SPEED])), vLoadU(lanes.in[ORBIT_MEAN_ANOMALY]));
+    vfloat e = vLoadU(lanes.in[ORBIT_ECCENTRICITY]);
+    // 타원 궤도 천체가 하나도 없는 묶음은 케플러 풀이를 건너뜀
+    vmask elliptic = vGreater(e, zero);
+    vfloat E = (vBits(elliptic) != 0) ? vSelect(elliptic, vSolveKepler(M, e), M) : M;
+
+    vfloat s, c;
+    vSinCos(E, s, c);
+    vfloat r = vLoadU(lanes.in[ORBIT_RADIUS]);
+    vfloat u = vMul(vSub(c, e), r);
+    vfloat v = vMul(s, r);
+    vfloat px = zero, py = zero, pz = zero;
+    if (lanes.parent) {
+        px = vGather(store.x.data(), lanes.parent);
+        py = vGather(store.y.data(), lanes.parent);
+        pz = vGather(store.z.data(), lanes.parent);
+    }
+    vfloat ox = vFma(u, vLoadU(lanes.in[ORBIT_PX]), vMul(v, vLoadU(lanes.in[ORBIT_QX])));
+    vfloat oy = vFma(u, vLoadU(lanes.in[ORBIT_PY]), vMul(v, vLoadU(lanes.in[ORBIT_QY])));
+    vfloat oz = vFma(u, vLoadU(lanes.in[ORBIT_PZ]), vMul(v, vLoadU(lanes.in[ORBIT_QZ])));
+    vStoreU(lanes.x, vAdd(vAdd(px, vLoadU(lanes.in[ORBIT_CENTER_X])), ox));
+    vStoreU(lanes.y, vAdd(vAdd(py, vLoadU(lanes.in[ORBIT_CENTER_Y])), oy));
+    vStoreU(lanes.z, vAdd(vAdd(pz, vLoadU(lanes.in[ORBIT_CENTER_Z])), oz));
+}
+
+// 단계 안의 [begin, end) 천체 (끝에 W개가 안 되는 천체는 임시 lane에 채워서 같은 식으로)
+static void updateOrbitRange(BodyStore& store, float time, int begin, int end, bool hasParent) {
+    const int W = RAY_BATCH_LANES;
+    const vfloat halfTime = vSet1(time * 0.5f);
+    OrbitLanes lanes;
+    int i = begin;
+    for (; i + W <= end; i += W) {
+        for (int f = 0; f < ORBIT_INPUT_COUNT; f++) lanes.in[f] = &(store.*ORBIT_INPUT_COLUMNS[f])[i];
+        lanes.parent = hasParent ? &store.parent[i] : nullptr;
+        lanes.x = &store.x[i];
+        lanes.y = &store.y[i];
+        lanes.z = &store.z[i];
+        vUpdateOrbit(store, lanes, halfTime);
+    }
+    if (i == end) return;
+
+    alignas(64) float in[ORBIT_INPUT_COUNT][RAY_BATCH_LANES];
+    alignas(64) float x[RAY_BATCH_LANES], y[RAY_BATCH_LANES], z[RAY_BATCH_LANES];
+    alignas(64) int parent[RAY_BATCH_LANES];
+    const int count = end - i;
+    for (int l = 0; l < W; l++) {
+        const int b = i + std::min(l, count - 1); // 빈 lane은 마지막 천체를 한 번 더 계산하고 버림
+        for (int f = 0; f < ORBIT_INPUT_COUNT; f++) in[f][l] = (store.*ORBIT_INPUT_COLUMNS[f])[b];
+        parent[l] = hasParent ? store.parent[b] : 0;
+    }
+    for (int f = 0; f < ORBIT_INPUT_COUNT; f++) lanes.in[f] = in[f];
+    lanes.parent = hasParent ? parent : nullptr;
+    lanes.x = x;
+    lanes.y = y;
+    lanes.z = z;
+    vUpdateOrbit(store, lanes, halfTime);
+    std::copy(x, x + count, &store.x[i]);
+    std::copy(y, y + count, &store.y[i]);
+    std::copy(z, z + count, &store.z[i]);
+}
+
+void updateBodyPositions(BodyStore& store, float time) {
+    if (store.levelStart.empty() && !sortBodyLevels(store)) return;
+    // 단계마다 앞 단계 위치가 다 나온 뒤에 시작 (단계 안에서는 작업 순서와 상관없이 결과가 같음)
+    for (int l = 0; l < store.levels(); l++) {
+        const int first = store.levelStart[l];
+        const int count = store.levelStart[l + 1] - first;
+        parallelFor(count, BODY_UPDATE_TASK_BODIES, [&](int begin, int end) {
+            updateOrbitRange(store, time, first + begin, first + end, l > 0);
+        });
+    }
+}
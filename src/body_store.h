@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+// --- 천체 저장소 ---
+// 천체를 성분별 배열(SoA)로 저장하고 부모는 번호로 가리킴 (포인터 추적 / 천체마다 new 없음)
+// 배열은 계층 단계 순서로 정렬됨: 부모가 없는 천체가 0단계, 그 위성이 1단계, 위성의 위성이 2단계 ...
+// 단계 안의 천체끼리는 서로 독립이라 공전 위치를 단계마다 벡터 루프 한 번으로 계산 (부모 위치는 앞 단계에서 모아 읽음)
+// 궤도는 케플러 타원 (이심률 0, 기울기 0이면 예전 XZ 평면 원운동과 같은 값), 시각만으로 닫힌 식으로 계산하므로 적분하지 않고 아무 시각이나 바로 구함
+
+// 이심률 상한 (이보다 크면 고정 횟수 반복으로는 케플러 방정식이 float 정밀도까지 수렴하지 않음)
+const float ORBIT_MAX_ECCENTRICITY = 0.99f;
+
+// 천체 하나의 초기값 (장면 파일 / setupScene / 벤치마크 장면이 채워서 addBody로 넘김)
+struct Body {
+    float mass = 0.0f;
+    float radius = 1.0f;
+    glm::vec3 color = glm::vec3(1.0f);
+
+    // 궤도 정보
+    int parent = -1;        // 부모 천체 번호 (addBody가 돌려준 값, -1 = 없음)
+    glm::vec3 relativeOffset = glm::vec3(0.0f); // 부모 위치(부모가 없으면 원점)에서 공전 중심까지의 오프셋
+    float orbitRadius = 0.0f;   // 긴반지름 (원궤도면 반지름)
+    float orbitSpeed = 0.0f;    // 공전 속도 (평균 각속도 = orbitSpeed * 0.5)
+    float rotationSpeed = 0.0f; // 자전 속도
+
+    // 타원 궤도 요소 (각도는 라디안, 기준면은 XZ 평면이고 +Y가 북쪽)
+    float eccentricity = 0.0f;      // 0 이상 ORBIT_MAX_ECCENTRICITY 이하 (addBody가 자름)
+    float inclination = 0.0f;       // 기준면에 대한 궤도면 기울기
+    float ascendingNode = 0.0f;     // 승교점 경도 (+X에서 +Z 쪽으로)
+    float periapsisArgument = 0.0f; // 승교점에서 근점까지의 각
+    float meanAnomaly = 0.0f;       // t = 0의 평균 근점 이각
+};
+
+struct BodyStore {
+    int count = 0;
+    std::vector<float> x, y, z; // 현재 위치 (updateBodyPositions가 채움)
+    std::vector<float> mass;
+    std::vector<float> radius;
+    std::vector<float> colorR, colorG, colorB;
+    std::vector<float> centerX, centerY, centerZ; // Body::relativeOffset
+    std::vector<float> orbitRadius;
+    std::vector<float> orbitSpeed;
+    std::vector<float> rotationSpeed;
+    std::vector<float> eccentricity;
+    std::vector<float> meanAnomaly;
+    std::vector<float> planePX, planePY, planePZ; // 궤도면 근점 방향 단위 벡터
+    std::vector<float> planeQX, planeQY, planeQZ; // 궤도면 안에서 근점과 수직인 방향 * sqrt(1 - e^2) (단반지름 / 긴반지름)
+    std::vector<int> parent;     // 정렬 뒤에는 항상 앞 단계 천체 번호
+    std::vector<int> levelStart; // 단계 l의 천체는 [levelStart[l], levelStart[l + 1]), 비어 있으면 아직 정렬 전
+
+    int levels() const { return levelStart.empty() ? 0 : (int)levelStart.size() - 1; }
+    glm::vec3 position(int i) const { return glm::vec3(x[i], y[i], z[i]); }
+    glm::vec3 color(int i) const { return glm::vec3(colorR[i], colorG[i], colorB[i]); }
+};
+
+// 모든 천체를 지움 (용량은 유지)
+void clearBodies(BodyStore& store);
+void reserveBodies(BodyStore& store, int count);
+// 끝에 천체를 추가하고 번호를 돌려줌 (부모는 뒤에 추가해도 됨, 단계 정렬은 sortBodyLevels에서)
+int addBody(BodyStore& store, const Body& body);
+// 부모 깊이로 안정 정렬해서 단계를 나누고 parent를 새 번호로 바꿈 (이미 정렬돼 있으면 번호 그대로)
+// 범위 밖 부모나 순환이 있으면 false (store는 그대로), order가 있으면 order[새 번호] = 이전 번호
+bool sortBodyLevels(BodyStore& store, std::vector<int>* order = nullptr);
+// 시각 time의 공전 위치 (단계 순서대로, 단계마다 작업 풀로 나눔)
+// 정렬 전이면 먼저 sortBodyLevels (번호가 바뀔 수 있으므로 천체를 다 넣은 뒤 직접 부르는 것이 좋음)
+void updateBodyPositions(BodyStore& store, float time);
+
+// updateBodyPositions가 쓰는 lane sin / cos (|angle| < 1e5에서 std::sin / cos와의 차이 약 1e-7)
+void orbitSinCos(const float* angle, float* sinOut, float* cosOut, int count);
+// updateBodyPositions가 쓰는 lane 케플러 방정식 풀이: M = E - e sin E인 이심 근점 이각 E ([-pi, pi]로 줄인 값)
+void solveKepler(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, int count);
@@ -0,0 +1,177 @@
+﻿#include "frame_profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+const char* const PROFILE_STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+    "physics", "rays", "textures", "sky", "scene", "hud", "swap", "frame",
+};
+
+static const std::chrono::steady_clock::time_point profileStart = std::chrono::steady_clock::now();
+
+static ProfileFrame history[PROFILER_HISTORY_FRAMES];
+static long long frameCounter = -1;   // 진행 중인 프레임 번호 (-1: 아직 시작 안 함)
+static double stageOpenMs[PROFILE_STAGE_COUNT];
+
+double profileClockMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - profileStart).count();
+}
+
+static ProfileFrame* currentFrame() {
+    if (frameCounter < 0) return nullptr;
+    return &history[frameCounter % PROFILER_HISTORY_FRAMES];
+}
+
+static void addEvent(ProfileFrame& f, int stage, double startMs, double ms) {
+    f.cpuMs[stage] = (f.cpuMs[stage] < 0.0f ? 0.0f : f.cpuMs[stage]) + (float)ms;
+    if (f.eventCount < PROFILER_MAX_EVENTS) {
+        f.events[f.eventCount++] = { stage, startMs, (float)ms };
+    }
+}
+
+void beginProfileFrame() {
+    frameCounter++;
+    ProfileFrame& f = history[frameCounter % PROFILER_HISTORY_FRAMES];
+    f.frame = frameCounter;
+    f.startMs = profileClockMs();
+    f.eventCount = 0;
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+        f.cpuMs[i] = -1.0f;
+        f.gpuMs[i] = -1.0f;
+    }
+}
+
+void endProfileFrame() {
+    ProfileFrame* f = currentFrame();
+    if (!f) return;
+    addEvent(*f, PROFILE_FRAME, f->startMs, profileClockMs() - f->startMs);
+}
+
+long long currentProfileFrame() {
+    return frameCounter;
+}
+
+void beginProfileStage(ProfileStage stage) {
+    stageOpenMs[stage] = profileClockMs();
+}
+
+void endProfileStage(ProfileStage stage) {
+    ProfileFrame* f = currentFrame();
+    if (!f) return;
+    addEvent(*f, stage, stageOpenMs[stage], profileClockMs() - stageOpenMs[stage]);
+}
+
+void recordProfileStage(ProfileStage stage, double startMs, double ms) {
+    ProfileFrame* f = currentFrame();
+    if (!f) return;
+    addEvent(*f, stage, startMs, ms);
+}
+
+void recordProfileGpu(long long frame, ProfileStage stage, double ms) {
+    if (frame < 0 || frame > frameCounter || frameCounter - frame >= PROFILER_HISTORY_FRAMES) return;
+    ProfileFrame& f = history[frame % PROFILER_HISTORY_FRAMES];
+    if (f.frame != frame) return;
+    f.gpuMs[stage] = (f.gpuMs[stage] < 0.0f ? 0.0f : f.gpuMs[stage]) + (float)ms;
+}
+
+ProfileStats profileStageStats(ProfileStage stage, bool gpu, int frames) {
+    static std::vector<float> values; // 렌더 스레드 전용이라 매 프레임 재사용
+    values.clear();
+    frames = std::min(frames, PROFILER_HISTORY_FRAMES - 1);
+    for (long long n = frameCounter - 1; n >= 0 && n >= frameCounter - frames; n--) {
+        const ProfileFrame& f = history[n % PROFILER_HISTORY_FRAMES];
+        float v = gpu ? f.gpuMs[stage] : f.cpuMs[stage];
+        if (v >= 0.0f) values.push_back(v);
+    }
+
+    ProfileStats stats;
+    stats.samples = (int)values.size();
+    if (values.empty()) return stats;
+    // nearest-rank 백분위수
+    auto percentile = [&](double p) {
+        size_t k = std::min(values.size() - 1, (size_t)(p * values.size()));
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return values[k];
+    };
+    stats.p50 = percentile(0.50);
+    stats.p99 = percentile(0.99);
+    return stats;
+}
+
+float latestProfileMs(ProfileStage stage, bool gpu) {
+    for (long long n = frameCounter; n >= 0 && n > frameCounter - 8; n--) {
+        const ProfileFrame& f = history[n % PROFILER_HISTORY_FRAMES];
+        float v = gpu ? f.gpuMs[stage] : f.cpuMs[stage];
+        if (v >= 0.0f) return v;
+    }
+    return -1.0f;
+}
+
+// 링에 남은 완료된 프레임 범위 [first, last]
+static void storedFrames(long long& first, long long& last) {
+    last = frameCounter - 1;
+    first = std::max(0LL, frameCounter - (PROFILER_HISTORY_FRAMES - 1));
+}
+
+bool writeProfileCsv(const char* path) {
+    FILE* file = std::fopen(path, "w");
+    if (!file) return false;
+
+    std::fprintf(file, "frame,start_ms");
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) std::fprintf(file, ",cpu_%s", PROFILE_STAGE_NAMES[i]);
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) std::fprintf(file, ",gpu_%s", PROFILE_STAGE_NAMES[i]);
+    std::fprintf(file, "\n");
+
+    long long first, last;
+    storedFrames(first, last);
+    for (long long n = first; n <= last; n++) {
+        const ProfileFrame& f = history[n % PROFILER_HISTORY_FRAMES];
+        std::fprintf(file, "%lld,%.3f", f.frame, f.startMs);
+        // 측정하지 않은 단계는 빈 칸
+        for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+            if (f.cpuMs[i] >= 0.0f) std::fprintf(file, ",%.4f", f.cpuMs[i]);
+            else std::fprintf(file, ",");
+        }
+        for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+            if (f.gpuMs[i] >= 0.0f) std::fprintf(file, ",%.4f", f.gpuMs[i]);
+            else std::fprintf(file, ",");
+        }
+        std::fprintf(file, "\n");
+    }
+    return std::fclose(file) == 0;
+}
+
+// Chrome 트레이스 이벤트 형식 (단위 마이크로초)
+// tid 1: 렌더 스레드, tid 2: 시뮬레이션 스레드, tid 3: GPU
+// GL_TIME_ELAPSED는 길이만 주므로 GPU 구간은 같은 프레임의 CPU 단계 시작 시각에 맞춰 표시 (대략적인 위치)
+bool writeProfileTrace(const char* path) {
+    FILE* file = std::fopen(path, "w");
+    if (!file) return false;
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"render\"}},\n");
+    std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"simulation\"}},\n");
+    std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":3,\"args\":{\"name\":\"gpu\"}}");
+
+    long long first, last;
+    storedFrames(first, last);
+    for (long long n = first; n <= last; n++) {
+        const ProfileFrame& f = history[n % PROFILER_HISTORY_FRAMES];
+        bool gpuShown[PROFILE_STAGE_COUNT] = {};
+        for (int e = 0; e < f.eventCount; e++) {
+            const ProfileEvent& ev = f.events[e];
+            int tid = (ev.stage == PROFILE_PHYSICS || ev.stage == PROFILE_RAYS) ? 2 : 1;
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.1f,\"dur\":%.1f,\"args\":{\"frame\":%lld}}",
+                PROFILE_STAGE_NAMES[ev.stage], tid, ev.startMs * 1000.0, ev.ms * 1000.0, f.frame);
+
+            if (ev.stage != PROFILE_FRAME && f.gpuMs[ev.stage] >= 0.0f && !gpuShown[ev.stage]) {
+                gpuShown[ev.stage] = true;
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":3,\"ts\":%.1f,\"dur\":%.1f,\"args\":{\"frame\":%lld}}",
+                    PROFILE_STAGE_NAMES[ev.stage], ev.startMs * 1000.0, f.gpuMs[ev.stage] * 1000.0, f.frame);
+            }
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
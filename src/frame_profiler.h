@@ -0,0 +1,81 @@
+﻿#pragma once
+
+// --- 프레임 프로파일러 ---
+// 프레임을 단계별로 나눠 CPU 시간(스코프 타이머)과 GPU 시간(GL_TIME_ELAPSED, gpu_profiler에서 채움)을 기록
+// 최근 PROFILER_HISTORY_FRAMES 프레임을 링 버퍼에 보관해서 HUD용 p50/p99를 내고
+// 프레임별 CSV / Chrome 트레이스(chrome://tracing, Perfetto) JSON으로 저장
+// 배포 빌드에서도 항상 켜져 있음 (프레임당 시계 읽기 수십 번 수준)
+// 기록은 렌더 스레드 전용, 시뮬레이션 스레드는 profileClockMs로 잰 값을 SimFrame에 담아 넘김
+// GL 의존성 없음
+
+enum ProfileStage {
+    PROFILE_PHYSICS,  // updateBodyPhysics (시뮬레이션 스레드, 새 세대를 받은 프레임에만)
+    PROFILE_RAYS,     // simulateRay (시뮬레이션 스레드)
+    PROFILE_TEXTURES, // pumpTextureUploads
+    PROFILE_SKY,      // 스카이돔 / 스카이박스
+    PROFILE_SCENE,    // drawScene (스카이박스 제외)
+    PROFILE_HUD,      // drawInstructions + 프로파일러 HUD
+    PROFILE_SWAP,     // glutSwapBuffers
+    PROFILE_FRAME,    // display() 전체 (GPU는 단계 합)
+    PROFILE_STAGE_COUNT
+};
+
+extern const char* const PROFILE_STAGE_NAMES[PROFILE_STAGE_COUNT];
+
+const int PROFILER_HISTORY_FRAMES = 1024; // 60 FPS에서 약 17초
+const int PROFILER_STATS_FRAMES = 240;    // HUD 백분위수 구간 (약 4초)
+const int PROFILER_MAX_EVENTS = 32;       // 프레임당 구간 수 (한 단계를 여러 번 열 수 있음)
+
+// 트레이스용 구간 하나
+struct ProfileEvent {
+    int stage;
+    double startMs; // profileClockMs 기준
+    float ms;
+};
+
+struct ProfileFrame {
+    long long frame = -1;
+    double startMs = 0.0;
+    float cpuMs[PROFILE_STAGE_COUNT]; // 단계별 합, 측정하지 않았으면 -1
+    float gpuMs[PROFILE_STAGE_COUNT]; // GPU 결과는 몇 프레임 늦게 채워짐
+    ProfileEvent events[PROFILER_MAX_EVENTS];
+    int eventCount = 0;
+};
+
+struct ProfileStats {
+    float p50 = 0.0f;
+    float p99 = 0.0f;
+    int samples = 0;
+};
+
+// 프로그램 시작 기준 밀리초 (모든 스레드에서 사용 가능)
+double profileClockMs();
+
+void beginProfileFrame();
+void endProfileFrame();
+long long currentProfileFrame();
+
+// 같은 단계를 한 프레임에 여러 번 열면 시간이 더해짐 (단계끼리 겹치게 열지 말 것)
+void beginProfileStage(ProfileStage stage);
+void endProfileStage(ProfileStage stage);
+
+// 다른 스레드에서 잰 구간을 현재 프레임에 기록
+void recordProfileStage(ProfileStage stage, double startMs, double ms);
+// 지난 프레임의 GPU 시간 기록 (링에서 이미 밀려난 프레임이면 버림)
+void recordProfileGpu(long long frame, ProfileStage stage, double ms);
+
+struct ProfileScope {
+    ProfileStage stage;
+    explicit ProfileScope(ProfileStage s) : stage(s) { beginProfileStage(s); }
+    ~ProfileScope() { endProfileStage(stage); }
+};
+
+// 최근 frames 프레임(현재 프레임 제외) 중 측정된 값의 백분위수
+ProfileStats profileStageStats(ProfileStage stage, bool gpu, int frames = PROFILER_STATS_FRAMES);
+
+// 값이 있는 가장 최근 프레임의 단계 시간 (최근 8프레임 안에 없으면 -1, GPU 값은 몇 프레임 늦음)
+float latestProfileMs(ProfileStage stage, bool gpu);
+
+// 링에 남은 프레임 전체를 저장, 실패하면 false
+bool writeProfileCsv(const char* path);
+bool writeProfileTrace(const char* path);
@@ -0,0 +1,41 @@
+﻿#pragma once
+
+// 플랫폼별 OpenGL/GLUT 헤더 (렌더링 쪽 소스에서만 포함)
+// OpenGL 1.1 이후 함수(VBO, glMultiDrawArrays 등)는 윈도우에서는 GLEW로 불러오고
+// 리눅스에서는 libGL이 직접 내보내는 심볼을 GL_GLEXT_PROTOTYPES로 선언해서 사용
+#ifdef _WIN32
+#include <windows.h>
+#include <GL/glew.h> // gl.h보다 먼저 포함해야 함
+#include <GL/glut.h> 
+#elif defined(__APPLE__)
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+#include <OpenGL/glu.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glut.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glu.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+
+// GL_VERSION 문자열의 "주.부" 버전이 major.minor 이상인지 (컨텍스트가 있어야 함)
+inline bool hasGLVersion(int major, int minor) {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int maj = 0, min = 0;
+    if (!version || std::sscanf(version, "%d.%d", &maj, &min) != 2) return false;
+    return maj > major || (maj == major && min >= minor);
+}
+
+inline bool hasGLExtension(const char* name) {
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    return extensions && std::strstr(extensions, name) != nullptr;
+}
+
+#ifdef _MSC_VER
+#pragma comment(lib, "opengl32.lib")
+#pragma comment(lib, "glu32.lib")
+#endif
@@ -0,0 +1,106 @@
+﻿#include "gl_common.h"
+#include "gpu_profiler.h"
+
+// 애플 기본 GL(2.1)에는 GL_TIME_ELAPSED 코어 함수가 없음 (EXT 이름만 있음)
+#if defined(__APPLE__) || !defined(GL_TIME_ELAPSED)
+#define GPU_PROFILER_QUERIES 0
+#else
+#define GPU_PROFILER_QUERIES 1
+#endif
+
+#if GPU_PROFILER_QUERIES
+struct GpuQuerySlot {
+    long long frame = -1;
+    GLuint queries[PROFILER_MAX_EVENTS] = {};
+    int stages[PROFILER_MAX_EVENTS];
+    int used = 0;
+};
+
+static const double GPU_PROFILER_MAX_FRAME_MS = 10000.0;
+
+static GpuQuerySlot slots[GPU_PROFILER_LATENCY];
+static GpuQuerySlot* activeSlot = nullptr;
+static int openStage = -1; // 열려 있는 쿼리의 단계 (-1: 없음)
+#endif
+
+static bool timerQueries = false;
+
+bool initGpuProfiler() {
+#if GPU_PROFILER_QUERIES
+    timerQueries = hasGLVersion(3, 3) || hasGLExtension("GL_ARB_timer_query");
+    if (!timerQueries) return false;
+    for (auto& slot : slots) {
+        glGenQueries(PROFILER_MAX_EVENTS, slot.queries);
+        slot.frame = -1;
+        slot.used = 0;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void shutdownGpuProfiler() {
+#if GPU_PROFILER_QUERIES
+    if (timerQueries) {
+        for (auto& slot : slots) glDeleteQueries(PROFILER_MAX_EVENTS, slot.queries);
+    }
+    activeSlot = nullptr;
+#endif
+    timerQueries = false;
+}
+
+#if GPU_PROFILER_QUERIES
+// 슬롯의 쿼리 결과를 단계별로 더해서 넘김 (마지막 쿼리가 끝났으면 앞의 쿼리도 끝난 것)
+static void collectSlot(GpuQuerySlot& slot) {
+    if (slot.frame < 0 || slot.used == 0) return;
+    GLuint available = 0;
+    glGetQueryObjectuiv(slot.queries[slot.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+        double ms[PROFILER_MAX_EVENTS];
+        double total = 0.0;
+        for (int i = 0; i < slot.used; i++) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &ns);
+            ms[i] = ns * 1e-6;
+            total += ms[i];
+        }
+        // 드라이버에 따라 첫 쿼리가 엉뚱한 값(수천 초)을 줄 때가 있어서 그런 프레임은 통째로 버림
+        if (total < GPU_PROFILER_MAX_FRAME_MS) {
+            for (int i = 0; i < slot.used; i++) recordProfileGpu(slot.frame, (ProfileStage)slot.stages[i], ms[i]);
+            recordProfileGpu(slot.frame, PROFILE_FRAME, total);
+        }
+    }
+    slot.frame = -1;
+    slot.used = 0;
+}
+#endif
+
+void beginGpuProfileFrame() {
+#if GPU_PROFILER_QUERIES
+    if (!timerQueries) return;
+    long long frame = currentProfileFrame();
+    GpuQuerySlot& slot = slots[frame % GPU_PROFILER_LATENCY];
+    collectSlot(slot); // GPU_PROFILER_LATENCY 프레임 전 결과
+    slot.frame = frame;
+    activeSlot = &slot;
+#endif
+}
+
+void beginGpuProfileStage(ProfileStage stage) {
+#if GPU_PROFILER_QUERIES
+    if (!timerQueries || !activeSlot || openStage >= 0 || activeSlot->used >= PROFILER_MAX_EVENTS) return;
+    activeSlot->stages[activeSlot->used] = stage;
+    glBeginQuery(GL_TIME_ELAPSED, activeSlot->queries[activeSlot->used]);
+    openStage = stage;
+#endif
+}
+
+void endGpuProfileStage(ProfileStage stage) {
+#if GPU_PROFILER_QUERIES
+    if (openStage != stage) return; // 시작할 때 건너뛴 단계
+    glEndQuery(GL_TIME_ELAPSED);
+    activeSlot->used++;
+    openStage = -1;
+#endif
+}
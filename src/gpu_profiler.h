@@ -0,0 +1,36 @@
+﻿#pragma once
+#include "frame_profiler.h"
+
+// --- GPU 단계 시간 ---
+// 단계마다 GL_TIME_ELAPSED 쿼리를 감싸고, GPU_PROFILER_LATENCY 프레임 뒤에 결과를 읽어서
+// frame_profiler에 넘김 (결과가 아직 없으면 기다리지 않고 그 프레임 값은 버림)
+// GL 3.3 / GL_ARB_timer_query가 없으면 아무것도 하지 않음 (CPU 시간만 기록)
+
+// 결과를 읽기 전까지 쿼리를 보관하는 프레임 수
+const int GPU_PROFILER_LATENCY = 4;
+
+// GL 컨텍스트를 만든 뒤 호출, 타이머 쿼리를 못 쓰면 false
+bool initGpuProfiler();
+void shutdownGpuProfiler();
+
+// beginProfileFrame 직후 호출 (지난 프레임 결과 수거)
+void beginGpuProfileFrame();
+void beginGpuProfileStage(ProfileStage stage);
+void endGpuProfileStage(ProfileStage stage);
+
+// CPU + GPU 시간을 같이 잼 (렌더 스레드 전용, GL 쿼리는 중첩할 수 없으므로 단계끼리 겹치면 안 됨)
+inline void beginRenderProfileStage(ProfileStage stage) {
+    beginProfileStage(stage);
+    beginGpuProfileStage(stage);
+}
+
+inline void endRenderProfileStage(ProfileStage stage) {
+    endGpuProfileStage(stage);
+    endProfileStage(stage);
+}
+
+struct RenderProfileScope {
+    ProfileStage stage;
+    explicit RenderProfileScope(ProfileStage s) : stage(s) { beginRenderProfileStage(s); }
+    ~RenderProfileScope() { endRenderProfileStage(stage); }
+};
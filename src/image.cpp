@@ -0,0 +1,23 @@
+﻿#include "image.h"
+
+// 텍스쳐 매핑을 위한 라이브러리
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"  // PNG, JPG 등 픽셀 데이터 읽어오는 헤더
+
+bool loadImageFile(const char* filename, Image& image, int desiredChannels) {
+    image.pixels = stbi_load(filename, &image.width, &image.height, &image.channels, desiredChannels);
+    if (image.pixels && desiredChannels > 0) image.channels = desiredChannels;
+    return image.pixels != nullptr;
+}
+
+int imageFileChannels(const char* filename) {
+    int width, height, channels;
+    if (!stbi_info(filename, &width, &height, &channels)) return 0;
+    return channels;
+}
+
+void freeImage(Image& image) {
+    if (image.pixels) stbi_image_free(image.pixels);
+    image.pixels = nullptr;
+    image.width = image.height = image.channels = 0;
+}
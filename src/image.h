@@ -0,0 +1,18 @@
+﻿#pragma once
+
+// --- 이미지 디코딩 ---
+// stb_image로 파일을 픽셀 배열로 읽어옴 (GL 업로드는 호출하는 쪽에서 처리)
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    unsigned char* pixels = nullptr;
+};
+
+// 실패 시 false (image는 비어있는 상태 유지)
+// desiredChannels > 0이면 그 채널 수로 변환해서 읽음
+bool loadImageFile(const char* filename, Image& image, int desiredChannels = 0);
+// 디코딩 없이 헤더만 읽어서 원본 채널 수 반환 (실패 시 0)
+int imageFileChannels(const char* filename);
+void freeImage(Image& image);
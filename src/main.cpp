@@ -1,55 +1,26 @@
-﻿#ifdef _WIN32
-#include <windows.h>
-#include <GL/glut.h> 
-#else
-#include <GLUT/glut.h>
-#include <OpenGL/gl.h>
-#include <OpenGL/glu.h>
-#endif
-
-#ifdef _MSC_VER
-#pragma comment(lib, "opengl32.lib")
-#pragma comment(lib, "glu32.lib")
-#endif
+﻿#include "gl_common.h"
 #include <vector>
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <glm/glm.hpp>
 #include <glm/gtc/random.hpp>
 #include <glm/gtc/type_ptr.hpp>
-
-// 텍스쳐 매핑을 위한 라이브러리
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"  // PNG, JPG 등 픽셀 데이터 읽어오는 헤더
-#include <omp.h>
+#include "simulation.h"
+#include "sim_thread.h" // 궤도/광선 계산은 백그라운드 스레드에서
+#include "texture_loader.h" // 밉맵/BC1 텍스처 캐시
+#include "ray_renderer.h" // 광선 경로 VBO 스트리밍
+#include "sphere_mesh.h"  // 구체 LOD 메시 캐시
+#include "skybox.h"       // 큐브맵 스카이박스
+#include "gpu_profiler.h" // 단계별 CPU/GPU 프레임 시간
+#include "quality_governor.h" // 목표 프레임 시간에 맞춰 광선 수 / 스텝 / LOD 조절
+#include "task_pool.h"    // 광선/텍스처/스플라인 병렬 작업
+#include "scene_file.h"   // 텍스트 장면 -> 매핑한 바이너리
 
 // --- 설정 변수 ---
-const int numRays = 300; // 성능을 위해 1000 -> 300으로 조정
-static float Time = 0.0f; // 정밀한 회전을 위해 float 변경
-
-struct Body {
-    glm::vec3 position;     // 현재 월드 상의 위치
-    float mass;
-    float radius;
-    glm::vec3 color;
-
-    // 궤도 정보
-    Body* parent = nullptr; // 부모 천체 포인터
-    glm::vec3 relativeOffset; // 부모로부터의 거리 (초기 오프셋)
-    float orbitRadius;
-    float orbitSpeed;       // 공전 속도
-    float rotationSpeed;    // 자전 속도
-};
-
-// --- 전역 변수 ---
-std::vector<std::vector<glm::vec3>> rayPaths(numRays);
-std::vector<Body*> bodies;
-float lightSpeed = 30.0f;
-float dt = 0.01f; // 시뮬레이션 스텝 간격 조정
-
-std::vector<glm::vec3> initialVelocities(numRays);
-glm::vec4 lightPosition = { 0.0f, 0.0f, 0.0f, 1.0f };
+static float Time = 0.0f; // 이번 프레임에 그리는 시뮬레이션 시간 (마지막 두 세대 사이 보간, 자전 각도용)
 
 // 조명 파라미터
 GLfloat sunLightAmbient[] = { 0.12f, 0.12f, 0.12f, 1.0f };
@@ -71,7 +42,6 @@ GLfloat sunEmission[] = { 0.85f, 0.65f, 0.25f, 1.0f };
 // 태양 텍스쳐 매핑을 위한 변수 설정
 GLuint sunTexture = 0;
 bool sunTextureLoaded = false;
-GLUquadric* sunQuadric = nullptr;
 
 // 행성 텍스처(수성, 금성, 목성)와 쿼드릭
 GLuint mercuryTexture = 0;
@@ -80,12 +50,10 @@ GLuint jupiterTexture = 0;
 bool mercuryTextureLoaded = false;
 bool venusTextureLoaded = false;
 bool jupiterTextureLoaded = false;
-GLUquadric* planetQuadric = nullptr;
 
 // 스카이돔 텍스처
 GLuint skyDomeTexture = 0;
 bool skyDomeTextureLoaded = false;
-GLUquadric* skyDomeQuadric = nullptr;
 // 스카이돔 밝기 (1.0f = 원본, 0.0f = 완전 검정)
 float skyDomeBrightness = 0.35f;
 
@@ -104,6 +72,28 @@ int cameraTargetIndex = -1;
 // 이동 부드러움 정도
 float cameraSmoothSpeed = 0.1f;            
 
+// 키 입력으로 바꾸는 시뮬레이션 설정 (렌더 스레드 사본, 바꾸면 워커로 전달)
+SimControls simControls;
+// 이번 display()에서 그린 세대 (picking도 같은 위치로 판정)
+const SimFrame* shownFrame = nullptr;
+// shownFrame의 지난 세대 -> 이번 세대 위치를 이번 프레임 시각으로 보간한 천체 위치 (그리기 / 카메라 / 선택 공통)
+std::vector<glm::vec3> shownPositions;
+// 화면에 보여주는 시뮬레이션 시간 (세대가 오는 간격이 흔들려도 벽시계 속도로 흐름)
+SimPlayback playback;
+// 렌더 타이머 간격 (--max-fps, 시뮬레이션 세대 속도와 무관하게 이 속도로 다시 그림)
+int renderTimerMs = 7;
+// 프로파일러에 시뮬레이션 단계를 기록한 마지막 세대 (같은 세대를 여러 프레임 보여줄 때 중복 기록 방지)
+long long profiledGeneration = -1;
+bool showProfilerHud = false;
+
+// 품질 조절기 (G 키로 끄면 기본 단계로 고정, 목표는 --target-ms로 변경)
+QualityGovernor qualityGovernor;
+bool useQualityGovernor = true;
+double qualityTargetMs = 16.6;
+
+// 시작 장면 (--scene으로 변경, 읽지 못하면 setupScene의 기본 배치)
+const char* scenePath = "scene/default.ehscene";
+
 // Picking을 위한 행렬 저장소
 GLdouble savedModelview[16];
 GLdouble savedProjection[16];
@@ -111,48 +101,6 @@ GLint savedViewport[4];
 
 // --- 함수 정의 ---
 
-void setupScene() {
-    Body* sun = new Body();
-    sun->position = { lightPosition.x, lightPosition.y, lightPosition.z };
-
-
-
-    // 1. 블랙홀 (중심)
-    Body* blackhole = new Body();
-    blackhole->position = { 0,0,0 };
-    blackhole->mass = 800.0f; // 질량 키움
-    blackhole->radius = 4.0f;
-    blackhole->color = { 0.1f, 0.1f, 0.1f };
-    blackhole->orbitSpeed = 0.3f;
-    blackhole->rotationSpeed = 0.05f;
-    blackhole->parent = sun;
-    blackhole->orbitRadius = 50.0f;
-
-    // 2. 중성자별 (블랙홀 주위를 공전)
-    Body* neutronStar = new Body();
-    neutronStar->mass = 500.0f;
-    neutronStar->radius = 2.0f;
-    neutronStar->color = { 0.4f, 0.4f, 0.9f };
-    neutronStar->parent = blackhole;
-    neutronStar->orbitRadius = 15.0f; // 거리
-    neutronStar->orbitSpeed = 1.0f;   // 공전 속도
-    neutronStar->rotationSpeed = 2.0f;
-
-    // 3. 행성 (중성자별 주위를 공전)
-    Body* planet1 = new Body();
-    planet1->mass = 100.0f;
-    planet1->radius = 1.0f;
-    planet1->color = { 0.8f, 0.3f, 0.3f };
-    planet1->parent = neutronStar;
-    planet1->orbitRadius = 4.0f;
-    planet1->orbitSpeed = 3.0f;
-    planet1->rotationSpeed = 1.0f;
-
-    bodies.push_back(blackhole);
-    bodies.push_back(neutronStar);
-    bodies.push_back(planet1);
-}
-
 // 텍스트 출력을 위한 헬퍼 함수
 void renderBitmapString(float x, float y, void* font, const char* string) {
     const char* c;
@@ -162,6 +110,21 @@ void renderBitmapString(float x, float y, void* font, const char* string) {
     }
 }
 
+// 단계별 p50 / p99 (최근 PROFILER_STATS_FRAMES 프레임), 화면 왼쪽 위에서 아래로
+static void drawProfilerHud(int startX, int top, int lineHeight) {
+    char line[160];
+    renderBitmapString(startX, top, GLUT_BITMAP_HELVETICA_18, "[ Frame Profile ]  p50 / p99 ms");
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+        ProfileStats cpu = profileStageStats((ProfileStage)i, false);
+        ProfileStats gpu = profileStageStats((ProfileStage)i, true);
+        int n = std::snprintf(line, sizeof(line), "%-9s CPU %6.2f / %6.2f", PROFILE_STAGE_NAMES[i], cpu.p50, cpu.p99);
+        if (gpu.samples > 0) {
+            std::snprintf(line + n, sizeof(line) - n, "   GPU %6.2f / %6.2f", gpu.p50, gpu.p99);
+        }
+        renderBitmapString(startX, top - lineHeight * (i + 1), GLUT_BITMAP_HELVETICA_12, line);
+    }
+}
+
 // 화면 좌측 하단에 설명 출력 (HUD)
 void drawInstructions() {
     // 현재 뷰포트 크기 가져오기
@@ -193,12 +156,67 @@ void drawInstructions() {
     int startX = 20; // 왼쪽에서 띄울 간격
 
     // 설명 문구 출력 (아래에서 위로 쌓음)
-    renderBitmapString(startX, startY + lineHeight * 4, GLUT_BITMAP_HELVETICA_18, "[ Controls ]");
+    renderBitmapString(startX, startY + lineHeight * 17, GLUT_BITMAP_HELVETICA_18, "[ Controls ]");
+    char nbodyLine[96];
+    if (!simControls.useNBody) {
+        std::snprintf(nbodyLine, sizeof(nbodyLine), "N: N-Body (Off, Kepler Orbits)");
+    }
+    else if (shownFrame && shownFrame->nbody) {
+        std::snprintf(nbodyLine, sizeof(nbodyLine), "N: N-Body (%s, %s, drift %.1e)",
+            simControls.nbodyIntegrator == NBODY_YOSHIDA4 ? "Yoshida 4" : "Leapfrog",
+            shownFrame->nbodyStats.usedTree ? "Tree" : "Direct", shownFrame->nbodyStats.relativeDrift);
+    }
+    else {
+        std::snprintf(nbodyLine, sizeof(nbodyLine), "N: N-Body (%s)", simControls.nbodyIntegrator == NBODY_YOSHIDA4 ? "Yoshida 4" : "Leapfrog");
+    }
+    renderBitmapString(startX, startY + lineHeight * 16, GLUT_BITMAP_HELVETICA_12, nbodyLine);
+    char phaseLine[96];
+    if (!simControls.useRayPhaseCache) {
+        std::snprintf(phaseLine, sizeof(phaseLine), "C: Orbit Phase Cache (Off)");
+    }
+    else if (shownFrame && shownFrame->phaseCache.active) {
+        std::snprintf(phaseLine, sizeof(phaseLine), "C: Orbit Phase Cache (%d/%d phases, %d MB)",
+            shownFrame->phaseCache.filled, RAY_PHASE_SLOTS, (int)(shownFrame->phaseCache.bytes >> 20));
+    }
+    else {
+        std::snprintf(phaseLine, sizeof(phaseLine), "C: Orbit Phase Cache (No Period)");
+    }
+    renderBitmapString(startX, startY + lineHeight * 15, GLUT_BITMAP_HELVETICA_12, phaseLine);
+    char temporalLine[64];
+    if (simControls.useRayPhaseCache) {
+        std::snprintf(temporalLine, sizeof(temporalLine), "T: Temporal Rays (Off, Phase Cache On)");
+    }
+    else if (simControls.rayAmortizeStride > 1) {
+        std::snprintf(temporalLine, sizeof(temporalLine), "T: Temporal Rays (1/%d per frame)", simControls.rayAmortizeStride);
+    }
+    else {
+        std::snprintf(temporalLine, sizeof(temporalLine), "T: Temporal Rays (Off)");
+    }
+    renderBitmapString(startX, startY + lineHeight * 14, GLUT_BITMAP_HELVETICA_12, temporalLine);
+    char governorLine[96];
+    std::snprintf(governorLine, sizeof(governorLine), "G: Quality Governor (%s, %d rays, %d steps)",
+        useQualityGovernor ? "On" : "Off", simControls.numRays, simControls.maxSteps);
+    renderBitmapString(startX, startY + lineHeight * 13, GLUT_BITMAP_HELVETICA_12, governorLine);
+    renderBitmapString(startX, startY + lineHeight * 12, GLUT_BITMAP_HELVETICA_12, "O: Dump Profile (CSV + Trace)");
+    renderBitmapString(startX, startY + lineHeight * 11, GLUT_BITMAP_HELVETICA_12, showProfilerHud ? "P: Profiler HUD (On)" : "P: Profiler HUD (Off)");
+    renderBitmapString(startX, startY + lineHeight * 10, GLUT_BITMAP_HELVETICA_12, useSkybox ? "K: Sky (Cube Map)" : "K: Sky (Sky Dome)");
+    renderBitmapString(startX, startY + lineHeight * 9, GLUT_BITMAP_HELVETICA_12, useRayVbo ? "R: Ray Renderer (VBO)" : "R: Ray Renderer (Immediate)");
+    renderBitmapString(startX, startY + lineHeight * 8, GLUT_BITMAP_HELVETICA_12, simControls.useAccelField ? "F: Baked Accel Field (On)" : "F: Baked Accel Field (Off)");
+    renderBitmapString(startX, startY + lineHeight * 7, GLUT_BITMAP_HELVETICA_12, simControls.useOctree ? "B: Gravity (Octree)" : "B: Gravity (Direct)");
+    renderBitmapString(startX, startY + lineHeight * 6, GLUT_BITMAP_HELVETICA_12, simControls.escapeTolerance > 0.0f ? "E: Analytic Escape (On)" : "E: Analytic Escape (Off)");
+    renderBitmapString(startX, startY + lineHeight * 5, GLUT_BITMAP_HELVETICA_12, simControls.rayIntegrator == RAY_INTEGRATOR_RK45 ? "I: Integrator (RK45)" : "I: Integrator (Euler)");
+    const char* engineLine = "V: Ray Engine (Scalar)";
+    if (simControls.useSimdRays) engineLine = simControls.useWavefrontRays ? "V: Ray Engine (SIMD Wavefront)" : "V: Ray Engine (SIMD Batch)";
+    renderBitmapString(startX, startY + lineHeight * 4, GLUT_BITMAP_HELVETICA_12, engineLine);
     renderBitmapString(startX, startY + lineHeight * 3, GLUT_BITMAP_HELVETICA_12, "Mouse Left Click: Focus Object");
     renderBitmapString(startX, startY + lineHeight * 2, GLUT_BITMAP_HELVETICA_12, "Mouse Drag / Scroll: Rotate / Zoom");
     renderBitmapString(startX, startY + lineHeight * 1, GLUT_BITMAP_HELVETICA_12, "Arrow Up/Down: Change Mass");
     renderBitmapString(startX, startY + lineHeight * 0, GLUT_BITMAP_HELVETICA_12, "ESC: Reset View to Sun");
 
+    if (showProfilerHud) {
+        drawProfilerHud(startX, height - startY - lineHeight, lineHeight);
+    }
+
     // 상태 복구
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_LIGHTING);
@@ -210,157 +228,6 @@ void drawInstructions() {
 }
 
 
-// 공통 텍스처 로더
-GLuint loadTextureGeneric(const char* filename) {
-    int width, height, channels;
-    unsigned char* data = stbi_load(filename, &width, &height, &channels, 0);
-    if (!data) {
-        std::cerr << "Failed to load texture: " << filename << std::endl;
-        return 0;
-    }
-
-    GLuint texId = 0;
-    glGenTextures(1, &texId);
-    glBindTexture(GL_TEXTURE_2D, texId);
-
-    GLenum format = GL_RGB;
-    if (channels == 4) {
-        format = GL_RGBA;
-    }
-
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-
-    stbi_image_free(data);
-    return texId;
-}
-
-// 태양 텍스쳐 로드 함수
-bool loadSunTexture(const char* filename) {
-    sunTexture = loadTextureGeneric(filename);
-    if (sunTexture == 0) return false;
-    sunTextureLoaded = true;
-    return true;
-}
-
-bool loadMercuryTexture(const char* filename) {
-    mercuryTexture = loadTextureGeneric(filename);
-    if (mercuryTexture == 0) return false;
-    mercuryTextureLoaded = true;
-    return true;
-}
-
-bool loadVenusTexture(const char* filename) {
-    venusTexture = loadTextureGeneric(filename);
-    if (venusTexture == 0) return false;
-    venusTextureLoaded = true;
-    return true;
-}
-
-bool loadJupiterTexture(const char* filename) {
-    jupiterTexture = loadTextureGeneric(filename);
-    if (jupiterTexture == 0) return false;
-    jupiterTextureLoaded = true;
-    return true;
-}
-
-bool loadSkyDomeTexture(const char* filename) {
-    skyDomeTexture = loadTextureGeneric(filename);
-    if (skyDomeTexture == 0) return false;
-    skyDomeTextureLoaded = true;
-    return true;
-}
-
-void makeVelocities() {
-    for (int i = 0; i < numRays; i++) {
-        // 구면으로 랜덤하게 퍼지는 빛
-        initialVelocities[i] = glm::sphericalRand(1.0f) * lightSpeed;
-    }
-}
-
-// 순수 수학으로 위치 업데이트
-void updateBodyPhysics(float currentTime) {
-    for (auto& body : bodies) {
-        if (body->parent == nullptr) {
-            // 중심 천체는 원점에 고정 (원한다면 이동 가능)
-            body->position = glm::vec3(0.0f, 0.0f, 0.0f);
-        }
-        else {
-            // 부모 기준으로 공전 계산
-            float angle = currentTime * body->orbitSpeed * 0.5f; // 속도 조절
-            float x = cos(angle) * body->orbitRadius;
-            float z = sin(angle) * body->orbitRadius;
-
-            // 부모 위치 + 공전 위치
-            body->position = body->parent->position + glm::vec3(x, 0.0f, z);
-        }
-    }
-}
-
-void simulateRay(glm::vec3 startPos) {
-    // 성능 최적화를 위해 매 프레임 벡터 재할당 방지 (크기만 유지)
-    if (rayPaths.size() != numRays) rayPaths.resize(numRays);
-
-#pragma omp parallel for schedule(dynamic)
-    for (int i = 0; i < numRays; i++) {
-        glm::vec3 pos = startPos;
-        glm::vec3 vel = initialVelocities[i];
-
-        std::vector<glm::vec3>& path = rayPaths[i];
-        path.clear();
-        path.reserve(500); // 메모리 예약
-        path.push_back(pos);
-
-        // 최대 스텝 수 감소 (성능 타협점)
-        int maxSteps = 2000;
-
-        for (int step = 0; step < maxSteps; step++) {
-            glm::vec3 totalAccel = { 0, 0, 0 };
-            bool crashed = false;
-            float minDistSq = 1e9f;
-
-            for (const auto& body : bodies) {
-                glm::vec3 dir = body->position - pos;
-                float distSq = glm::dot(dir, dir);
-
-                if (distSq < body->radius * body->radius) {
-                    crashed = true;
-                    break;
-                }
-
-                if (distSq < minDistSq) minDistSq = distSq;
-
-                // 중력 가속도 F = G * M / r^2 (G=1로 가정, 방향 벡터 정규화 포함)
-                // a = M / r^2 * (dir / r) = M * dir / r^3
-                float dist = sqrt(distSq);
-                float accelMag = body->mass / (distSq * dist);
-                totalAccel += dir * accelMag * 5.0f; // * 5.0f는 중력 효과 과장을 위한 계수
-            }
-
-            if (crashed) break;
-
-            // 가변 dt (천체 근처에서는 정밀하게, 멀면 빠르게)
-            float currentDt = dt;
-            if (minDistSq > 500.0f) currentDt *= 2.0f;
-            if (minDistSq > 2000.0f) currentDt *= 4.0f;
-
-            vel += totalAccel * currentDt;
-            pos += vel * currentDt;
-
-            // 경계 체크
-            if (abs(pos.x) > 200.0f || abs(pos.y) > 200.0f || abs(pos.z) > 200.0f) break;
-
-            // 너무 촘촘하게 저장하면 그리기 느려짐, 일정 간격마다 저장
-            if (step % 10 == 0) path.push_back(pos);
-        }
-        // 마지막 위치 저장
-        path.push_back(pos);
-    }
-}
-
 void initLighting() {
     glEnable(GL_DEPTH_TEST);
 
@@ -422,19 +289,20 @@ void setSunMaterialEmission() {
 
 // 태양 코로나: 반투명 구체 3겹으로 빛 번짐 효과 표현
 void drawSunCorona(float sunRadius) {
+    const glm::vec3 sunCenter(lightPosition);
     glDisable(GL_LIGHTING);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE);   // 가산 블렌딩
     glDepthMask(GL_FALSE);              // 깊이 버퍼 기록 X
 
     glColor4f(1.0f, 0.75f, 0.25f, 0.18f);
-    glutSolidSphere(sunRadius * 1.08f, 32, 32);
+    drawSphereMesh(sphereLodLevel(sunCenter, sunRadius * 1.08f), sunRadius * 1.08f);
 
     glColor4f(1.0f, 0.65f, 0.20f, 0.10f);
-    glutSolidSphere(sunRadius * 1.18f, 32, 32);
+    drawSphereMesh(sphereLodLevel(sunCenter, sunRadius * 1.18f), sunRadius * 1.18f);
 
     glColor4f(1.0f, 0.55f, 0.15f, 0.06f);
-    glutSolidSphere(sunRadius * 1.30f, 32, 32);
+    drawSphereMesh(sphereLodLevel(sunCenter, sunRadius * 1.30f), sunRadius * 1.30f);
 
     glDepthMask(GL_TRUE);
     glDisable(GL_BLEND);
@@ -443,7 +311,7 @@ void drawSunCorona(float sunRadius) {
 
 // 태양 표면 오버레이 -> 회전시켜서 밋밋한 효과를 없앰
 void drawSunSurfaceOverlay(float sunRadius) {
-    if (!sunTextureLoaded || sunTexture == 0 || sunQuadric == nullptr) return;
+    if (!sunTextureLoaded || sunTexture == 0) return;
 
     glDisable(GL_LIGHTING);             // 오버레이는 자체 발광처럼
     glEnable(GL_TEXTURE_2D);
@@ -471,7 +339,7 @@ void drawSunSurfaceOverlay(float sunRadius) {
     glMatrixMode(GL_MODELVIEW);
 
     // 살짝 큰 구체를 한 번 더 그림
-    gluSphere(sunQuadric, sunRadius * 1.01f, 64, 64);
+    drawSphereMesh(sphereLodLevel(glm::vec3(lightPosition), sunRadius * 1.01f), sunRadius * 1.01f);
 
     // 텍스처 행렬 복구
     glMatrixMode(GL_TEXTURE);
@@ -485,7 +353,7 @@ void drawSunSurfaceOverlay(float sunRadius) {
 }
 
 void drawSkyDome() {
-    if (!skyDomeTextureLoaded || skyDomeQuadric == nullptr) return;
+    if (!skyDomeTextureLoaded) return;
 
     glDepthMask(GL_FALSE);      // 깊이 버퍼에는 쓰지 않음 (배경용)
     glDisable(GL_LIGHTING);
@@ -497,83 +365,84 @@ void drawSkyDome() {
     // 스카이돔을 위한 전체 배경 밝기 조절
     glColor3f(skyDomeBrightness, skyDomeBrightness, skyDomeBrightness);
 
-    // 카메라가 내부에 있도록 충분히 큰 반지름
-    gluSphere(skyDomeQuadric, 400.0, 64, 64);
+    // 카메라가 내부에 있도록 충분히 큰 반지름 (항상 화면을 덮으므로 최고 단계)
+    drawSphereMesh(SPHERE_LOD_LEVELS - 1, 400.0f);
 
     glPopMatrix();
     glEnable(GL_LIGHTING);
     glDepthMask(GL_TRUE);
 }
 
+// 품질 단계를 시뮬레이션 스레드(광선 수, 스텝 예산)와 구체 LOD에 반영
+void applyQualityLevel() {
+    const QualityLevel& q = currentQualityLevel(qualityGovernor);
+    // 단계의 광선 수는 세대당 적분 예산이므로 시간 분할 중에는 k배 많은 광선을 보여줌
+    // 위상 캐시가 켜져 있으면 시간 분할을 쓰지 않으므로 곱하지 않음 (모든 광선을 매번 적분)
+    const int stride = simControls.useRayPhaseCache ? 1 : simControls.rayAmortizeStride;
+    simControls.numRays = q.numRays * stride;
+    simControls.maxSteps = q.maxSteps;
+    submitSimControls(simControls);
+    setSphereLodMaxError(q.sphereLodErrorPx);
+}
+
 void init() {
     glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
     glEnable(GL_DEPTH_TEST);
     initLighting();
-    setupScene();
-    makeVelocities();
-
-    // 태양 텍스처 및 쿼드릭 초기화
-    if (!sunQuadric) {
-        sunQuadric = gluNewQuadric();
-        gluQuadricTexture(sunQuadric, GL_TRUE);
-        gluQuadricNormals(sunQuadric, GLU_SMOOTH);
+    std::string sceneError;
+    if (!loadSceneFile(scenePath, &sceneError)) {
+        std::cerr << "Scene " << scenePath << " not loaded (" << sceneError << "), using built-in scene" << std::endl;
+        setupScene();
     }
-    if (!planetQuadric) {
-        planetQuadric = gluNewQuadric();
-        gluQuadricTexture(planetQuadric, GL_TRUE);
-        gluQuadricNormals(planetQuadric, GLU_SMOOTH);
+    makeVelocities();
+    simControls = currentSimControls();
+    QualityGovernorConfig governorConfig;
+    governorConfig.targetMs = qualityTargetMs;
+    initQualityGovernor(qualityGovernor, governorConfig);
+    if (!initRayRenderer()) {
+        std::cerr << "VBO not supported, drawing rays in immediate mode" << std::endl;
     }
 
-    if (!skyDomeQuadric) {
-        skyDomeQuadric = gluNewQuadric();
-        gluQuadricTexture(skyDomeQuadric, GL_TRUE);
-        gluQuadricNormals(skyDomeQuadric, GLU_SMOOTH);
+    if (!initGpuProfiler()) {
+        std::cerr << "GL timer queries not supported, profiling CPU time only" << std::endl;
     }
 
-    // 텍스쳐 파일 로드
-    glEnable(GL_TEXTURE_2D);
-    if (!sunTextureLoaded) {
-        if (!loadSunTexture(".\\texture\\8k_sun.jpg")) {
-            std::cerr << "Failed to load 8k_sun texture" << std::endl;
-        }
-    }
-    if (!mercuryTextureLoaded) {
-        if (!loadMercuryTexture(".\\texture\\8k_mercury.jpg")) {
-            std::cerr << "Failed to load 8k_mercury texture" << std::endl;
-        }
-    }
-    if (!venusTextureLoaded) {
-        if (!loadVenusTexture(".\\texture\\8k_venus.jpg")) {
-            std::cerr << "Failed to load 8k_venus texture" << std::endl;
-        }
+    // 태양/행성/스카이돔이 같이 쓰는 구체 메시 (단계별로 한 번만 만들어 둠)
+    initSphereMeshes();
+
+    // 텍스쳐 파일 로드 요청 (디코딩은 작업 스레드들이 동시에 하고, 올라오기 전까지는 천체 색(SimFrame.bodyColors) 재질로 그림)
+    // 업로드는 display()의 pumpTextureUploads가 여러 프레임에 나눠서 함
+    requestTextureAsync("texture/8k_sun.jpg", &sunTexture, &sunTextureLoaded);
+    requestTextureAsync("texture/8k_mercury.jpg", &mercuryTexture, &mercuryTextureLoaded);
+    requestTextureAsync("texture/8k_venus.jpg", &venusTexture, &venusTextureLoaded);
+    requestTextureAsync("texture/8k_jupiter.jpg", &jupiterTexture, &jupiterTextureLoaded);
+
+    // 배경은 저장소에 있는 큐브맵 여섯 면 (작은 PNG라 바로 읽음)
+    const char* skyFaces[SKYBOX_FACES] = {
+        "texture/px.png", "texture/nx.png", "texture/py.png",
+        "texture/ny.png", "texture/pz.png", "texture/nz.png",
+    };
+    if (!initSkybox(skyFaces)) {
+        std::cerr << "Cube map sky not available, using sky dome" << std::endl;
     }
-    if (!jupiterTextureLoaded) {
-        if (!loadJupiterTexture(".\\texture\\8k_jupiter.jpg")) {
-            std::cerr << "Failed to load 8k_jupiter texture" << std::endl;
-        }
-    }
-    if (!skyDomeTextureLoaded) {
-        // 실제 파일 경로/이름에 맞게 수정해서 사용
-        if (!loadSkyDomeTexture(".\\texture\\NightSkyHDRI009_8K_TONEMAPPED.jpg"))
-        {
-            std::cerr << "Failed to load sky dome textures" << std::endl;
-        }
-    }
-    glDisable(GL_TEXTURE_2D);
+    // 큐브맵을 못 쓸 때 / K키로 비교할 때만 쓰는 등장방형 스카이돔 (실제 파일 경로/이름에 맞게 수정해서 사용)
+    requestTextureAsync("texture/NightSkyHDRI009_8K_TONEMAPPED.jpg", &skyDomeTexture, &skyDomeTextureLoaded);
 }
 
-void drawScene() {
-    // 1. 천체 그리기
-    for (int i = 0; i < bodies.size(); ++i) {
-        Body* b = bodies[i];
+void drawScene(const SimFrame& frame) {
+    beginRenderProfileStage(PROFILE_SCENE);
+    // 1. 천체 그리기 (위치는 보간한 값, 광선은 최신 세대 그대로, 반지름/자전/색도 같은 세대 값)
+    for (int i = 0; i < (int)shownPositions.size(); ++i) {
+        const glm::vec3& position = shownPositions[i];
+        const float radius = frame.bodyRadii[i];
         glPushMatrix();
-        glTranslatef(b->position.x, b->position.y, b->position.z);
+        glTranslatef(position.x, position.y, position.z);
 
         // 텍스처가 90도 누워 있어서 X축 기준으로 세워줌
         glRotatef(-90.0f, 1.0f, 0.0f, 0.0f);
 
         // 자전 시각화
-        glRotatef(Time * b->rotationSpeed * 50.0f, 0, 0, 1);
+        glRotatef(Time * frame.bodySpins[i] * 50.0f, 0, 0, 1);
 
         // 인덱스 기준으로 각 구체에 텍스처 매핑
         GLuint texId = 0;
@@ -591,57 +460,70 @@ void drawScene() {
             useTexture = true;
         }
 
-        if (useTexture && planetQuadric != nullptr) {
+        // 화면에 작게 보이는 천체는 낮은 단계 메시
+        int lod = sphereLodLevel(position, radius);
+        if (useTexture) {
             glEnable(GL_TEXTURE_2D);
             glBindTexture(GL_TEXTURE_2D, texId);
             setPlanetMaterial(glm::vec3(1.0f, 1.0f, 1.0f));
-            gluSphere(planetQuadric, b->radius, 32, 32);
+            drawSphereMesh(lod, radius);
             glDisable(GL_TEXTURE_2D);
         }
         else {
-            setPlanetMaterial(b->color);
-            glutSolidSphere(b->radius, 32, 32);
+            setPlanetMaterial(frame.bodyColors[i]);
+            drawSphereMesh(lod, radius);
         }
 
         glPopMatrix();
     }
 
-    // 2. 광선 그리기
-    glDisable(GL_LIGHTING);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive Blending (빛 효과)
-    glLineWidth(1.2f);
-
-    for (const auto& path : rayPaths) {
-        glBegin(GL_LINE_STRIP);
-        glColor4f(1.0f, 0.8f, 0.4f, 0.3f); // 반투명한 노란색
-        for (const auto& p : path) {
-            glVertex3f(p.x, p.y, p.z);
-        }
-        glEnd();
-    }
-    glDisable(GL_BLEND);
-    glEnable(GL_LIGHTING);
-
-    // 3. 태양(광원) 구체 표시 - numRays가 뿜어져 나오는 중심
+    // 태양(광원) 본체 - numRays가 뿜어져 나오는 중심
+    // 불투명이라 배경보다 먼저 그림 (화면에서 가장 큰 천체라 뒤쪽 배경 픽셀을 깊이 테스트로 가장 많이 걸러냄)
+    const float sunRadius = 10.0f;
     glPushMatrix();
     glTranslatef(lightPosition.x, lightPosition.y, lightPosition.z);
     // 텍스처가 90도 누워 있어서 X축 기준으로 세워줌
     glRotatef(-90.0f, 1.0f, 0.0f, 0.0f);
 
-    const float sunRadius = 10.0f;
+    // 화면을 거의 채울 때만 최고 단계 (64x64)
+    int sunLod = sphereLodLevel(glm::vec3(lightPosition), sunRadius);
 
     // 태양 본체(발광 재질)
     setSunMaterialEmission();
-    if (sunTextureLoaded && sunTexture != 0 && sunQuadric != nullptr) {
+    if (sunTextureLoaded && sunTexture != 0) {
         glEnable(GL_TEXTURE_2D);
         glBindTexture(GL_TEXTURE_2D, sunTexture);
-        gluSphere(sunQuadric, sunRadius, 64, 64);
+        drawSphereMesh(sunLod, sunRadius);
         glDisable(GL_TEXTURE_2D);
     }
     else {
-        glutSolidSphere(sunRadius, 64, 64);
+        drawSphereMesh(sunLod, sunRadius);
     }
+    glPopMatrix();
+
+    // 배경: 천체(태양 포함)에 가려진 픽셀은 깊이 테스트로 건너뜀 (가산 블렌딩인 광선/코로나보다 먼저 그려야 덮어쓰지 않음)
+    // GPU 쿼리는 겹칠 수 없으므로 scene 구간을 잠시 닫고 sky로 잼
+    endRenderProfileStage(PROFILE_SCENE);
+    beginRenderProfileStage(PROFILE_SKY);
+    drawSkybox(skyDomeBrightness);
+    endRenderProfileStage(PROFILE_SKY);
+    beginRenderProfileStage(PROFILE_SCENE);
+
+    // 2. 광선 그리기
+    glDisable(GL_LIGHTING);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive Blending (빛 효과)
+    glLineWidth(1.2f);
+
+    glColor4f(1.0f, 0.8f, 0.4f, 0.3f); // 반투명한 노란색
+    drawRayPaths(frame.rayPaths, frame.generation);
+    glDisable(GL_BLEND);
+    glEnable(GL_LIGHTING);
+
+    // 3. 태양 효과 (가산 블렌딩이라 본체 / 배경 다음)
+    glPushMatrix();
+    glTranslatef(lightPosition.x, lightPosition.y, lightPosition.z);
+    glRotatef(-90.0f, 1.0f, 0.0f, 0.0f);
 
     // (2) 표면 애니메이션 오버레이
     drawSunSurfaceOverlay(sunRadius);
@@ -651,38 +533,56 @@ void drawScene() {
 
     glPopMatrix();
 
-    if (selectedBodyIndex != -1) {
-        Body* b = bodies[selectedBodyIndex];
+    if (selectedBodyIndex >= 0 && selectedBodyIndex < (int)shownPositions.size()) {
+        const glm::vec3& position = shownPositions[selectedBodyIndex];
         glPushMatrix();
-        glTranslatef(b->position.x, b->position.y, b->position.z);
+        glTranslatef(position.x, position.y, position.z);
 
         glRotatef(-90.0f, 1.0f, 0.0f, 0.0f);
-        glRotatef(Time * b->rotationSpeed * 50.0f, 0, 0, 1);
+        glRotatef(Time * frame.bodySpins[selectedBodyIndex] * 50.0f, 0, 0, 1);
 
         glDisable(GL_LIGHTING);
 
         glColor3f(0.0f, 1.0f, 0.0f); // 선명한 초록색
-        glutWireSphere(b->radius * 1.2f, 16, 16);
+        glutWireSphere(frame.bodyRadii[selectedBodyIndex] * 1.2f, 16, 16);
 
         glEnable(GL_LIGHTING);
         glPopMatrix();
     }
+    endRenderProfileStage(PROFILE_SCENE);
 }
 
 void display() {
-    // 1. 물리 업데이트 (CPU)
-    Time += 0.02f;
-    updateBodyPhysics(Time);
-    simulateRay(glm::vec3(lightPosition));
+    beginProfileFrame();
+    beginGpuProfileFrame();
+
+    // 1. 물리 업데이트는 워커 스레드가 하고 여기서는 가장 최근에 완성된 세대만 가져옴
+    // (적분이 느려도 카메라/입력은 디스플레이 속도로 움직임)
+    // 천체는 지난 세대와 이번 세대 사이를 화면 시각에 맞춰 보간 (시뮬레이션이 30Hz여도 144Hz에서 부드럽게)
+    const SimFrame& frame = acquireSimFrame();
+    shownFrame = &frame;
+    Time = interpolateSimFrame(frame, advanceSimPlayback(playback, frame, profileClockMs()), shownPositions);
+    if (frame.generation != profiledGeneration) {
+        // 워커가 잰 구간은 그 세대를 처음 보여주는 프레임에 기록
+        recordProfileStage(PROFILE_PHYSICS, frame.physicsStartMs, frame.physicsMs);
+        recordProfileStage(PROFILE_RAYS, frame.raysStartMs, frame.raysMs);
+        profiledGeneration = frame.generation;
+    }
+
+    // 디코딩이 끝난 텍스처를 이번 프레임 예산만큼 GL에 올림
+    {
+        RenderProfileScope scope(PROFILE_TEXTURES);
+        pumpTextureUploads();
+    }
 
     // 2. 렌더링 준비
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
 
     glm::vec3 targetPos(0.0f, 0.0f, 0.0f); // 기본은 원점
-    if (cameraTargetIndex >= 0 && cameraTargetIndex < bodies.size()) {
+    if (cameraTargetIndex >= 0 && cameraTargetIndex < (int)shownPositions.size()) {
         // 해당 천체의 현재 위치를 목표로 설정
-        targetPos = bodies[cameraTargetIndex]->position;
+        targetPos = shownPositions[cameraTargetIndex];
     }
 
     // 공식: Current = Current + (Target - Current) * Speed
@@ -701,43 +601,69 @@ void display() {
     applySunLightInView();
 
     // 스카이돔: 카메라 위치 제거(회전만 유지)
-    glPushMatrix();
-    GLfloat mv[16];
-    glGetFloatv(GL_MODELVIEW_MATRIX, mv);
-    mv[12] = mv[13] = mv[14] = 0.0f; // translation 제거
-    glLoadMatrixf(mv);
-    drawSkyDome();
-    glPopMatrix();
+    // 큐브맵 스카이박스는 drawScene에서 불투명 천체 다음에 그림
+    if (!skyboxReady()) {
+        RenderProfileScope scope(PROFILE_SKY);
+        glPushMatrix();
+        GLfloat mv[16];
+        glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+        mv[12] = mv[13] = mv[14] = 0.0f; // translation 제거
+        glLoadMatrixf(mv);
+        drawSkyDome();
+        glPopMatrix();
+    }
 
     // 3. Picking을 위해 현재 행렬 상태 저장
     glGetDoublev(GL_MODELVIEW_MATRIX, savedModelview);
     glGetDoublev(GL_PROJECTION_MATRIX, savedProjection);
     glGetIntegerv(GL_VIEWPORT, savedViewport);
+    // 구체 LOD 기준 (투영 행렬 [1][1] = 1 / tan(fovy / 2))
+    setSphereLodView(glm::vec3(camX, camY, camZ), (float)(savedProjection[5] * savedViewport[3] * 0.5));
 
     // 4. 그리기
-    drawScene();
+    drawScene(frame);
 
-	drawInstructions();
+    {
+        RenderProfileScope scope(PROFILE_HUD);
+        drawInstructions();
+    }
 
-    glutSwapBuffers();
+    {
+        RenderProfileScope scope(PROFILE_SWAP);
+        glutSwapBuffers();
+    }
+    endProfileFrame();
+
+    // 품질 조절: vsync 대기(swap)는 빼고 CPU 렌더 / GPU / 시뮬레이션 세대 중 가장 느린 쪽 기준
+    if (useQualityGovernor) {
+        double cpuMs = latestProfileMs(PROFILE_FRAME, false) - std::max(0.0f, latestProfileMs(PROFILE_SWAP, false));
+        double frameMs = std::max({ cpuMs, (double)latestProfileMs(PROFILE_FRAME, true), frame.solveMs });
+        if (updateQualityGovernor(qualityGovernor, frameMs)) {
+            applyQualityLevel();
+            std::cout << "Quality Level " << qualityGovernor.level << ": " << simControls.numRays << " rays, "
+                << simControls.maxSteps << " steps (p90 " << qualityGovernor.lastWindowMs << " ms)" << std::endl;
+        }
+    }
 }
 
 void pickBody(int mouseX, int mouseY) {
     selectedBodyIndex = -1;
     double minDepth = 1.0;
+    if (!shownFrame) return;
 
-    // 저장해둔 행렬 사용
-    for (int i = 0; i < bodies.size(); ++i) {
+    // 저장해둔 행렬 사용 (위치도 마지막으로 그린 세대 기준)
+    for (int i = 0; i < (int)shownPositions.size(); ++i) {
         double winX, winY, winZ;
+        const glm::vec3& position = shownPositions[i];
 
         // 천체 중심 투영
-        gluProject(bodies[i]->position.x, bodies[i]->position.y, bodies[i]->position.z,
+        gluProject(position.x, position.y, position.z,
             savedModelview, savedProjection, savedViewport,
             &winX, &winY, &winZ);
 
         // 천체 표면(반지름) 투영하여 화면상 크기 계산
         double edgeX, edgeY, edgeZ;
-        gluProject(bodies[i]->position.x + bodies[i]->radius, bodies[i]->position.y, bodies[i]->position.z,
+        gluProject(position.x + shownFrame->bodyRadii[i], position.y, position.z,
             savedModelview, savedProjection, savedViewport,
             &edgeX, &edgeY, &edgeZ);
 
@@ -754,7 +680,7 @@ void pickBody(int mouseX, int mouseY) {
     }
 
     if (selectedBodyIndex != -1) {
-        std::cout << "Selected Body: " << selectedBodyIndex << " (Mass: " << bodies[selectedBodyIndex]->mass << ")" << std::endl;
+        std::cout << "Selected Body: " << selectedBodyIndex << " (Mass: " << shownFrame->bodyMasses[selectedBodyIndex] << ")" << std::endl;
         cameraTargetIndex = selectedBodyIndex;
     }
 }
@@ -796,12 +722,14 @@ void motionFunc(int x, int y) {
 
 void specialKeyFunc(int key, int x, int y) {
     if (selectedBodyIndex != -1) {
-        if (key == GLUT_KEY_UP) bodies[selectedBodyIndex]->mass += 50.0f;
-        if (key == GLUT_KEY_DOWN) {
-            bodies[selectedBodyIndex]->mass -= 50.0f;
-            if (bodies[selectedBodyIndex]->mass < 0) bodies[selectedBodyIndex]->mass = 0;
-        }
-        std::cout << "Body " << selectedBodyIndex << " Mass: " << bodies[selectedBodyIndex]->mass << std::endl;
+        // 질량은 워커 스레드가 다음 세대 시작 때 반영 (0 미만으로는 내려가지 않음, 범위 밖 번호는 워커가 무시)
+        float delta = 0.0f;
+        if (key == GLUT_KEY_UP) delta = 50.0f;
+        if (key == GLUT_KEY_DOWN) delta = -50.0f;
+        if (delta == 0.0f) return;
+        submitMassChange(selectedBodyIndex, delta);
+        float shownMass = (shownFrame && selectedBodyIndex < (int)shownFrame->bodyMasses.size()) ? shownFrame->bodyMasses[selectedBodyIndex] : 0.0f;
+        std::cout << "Body " << selectedBodyIndex << " Mass: " << shownMass << (delta > 0 ? " + " : " - ") << std::fabs(delta) << std::endl;
     }
 }
 
@@ -810,11 +738,104 @@ void keyboardFunc(unsigned char key, int x, int y) {
         cameraTargetIndex = -1; // 타겟 해제 (태양/원점 바라보기)
         std::cout << "View Reset to Origin" << std::endl;
     }
+    // 아래 설정은 simControls 사본을 바꾸고 워커 스레드에 넘김
+    SimControls& c = simControls;
+    if (key == 'v' || key == 'V') {
+        // 스칼라 -> SIMD 묶음 -> SIMD 웨이브프런트 순서로 순환
+        if (!c.useSimdRays) {
+            c.useSimdRays = true;
+            c.useWavefrontRays = false;
+        }
+        else if (!c.useWavefrontRays) {
+            c.useWavefrontRays = true;
+        }
+        else {
+            c.useSimdRays = false;
+        }
+        std::cout << "Ray Engine: " << (c.useSimdRays ? rayBatchInstructionSet() : "Scalar")
+            << (c.useSimdRays ? (c.useWavefrontRays ? " Wavefront" : " Batch") : "") << std::endl;
+    }
+    if (key == 'i' || key == 'I') {
+        // RK45는 스칼라 경로로만 동작 (SIMD 엔진은 오일러 전용)
+        c.rayIntegrator = (c.rayIntegrator == RAY_INTEGRATOR_EULER) ? RAY_INTEGRATOR_RK45 : RAY_INTEGRATOR_EULER;
+        std::cout << "Ray Integrator: " << (c.rayIntegrator == RAY_INTEGRATOR_RK45 ? "RK45" : "Euler") << std::endl;
+    }
+    if (key == 'e' || key == 'E') {
+        c.escapeTolerance = (c.escapeTolerance > 0.0f) ? 0.0f : 0.25f;
+        std::cout << "Analytic Escape: " << (c.escapeTolerance > 0.0f ? "On" : "Off") << std::endl;
+    }
+    if (key == 'b' || key == 'B') {
+        // 천체가 OCTREE_MIN_BODIES 미만이면 켜져 있어도 직접 합산
+        c.useOctree = !c.useOctree;
+        std::cout << "Gravity: " << (c.useOctree ? "Barnes-Hut Octree" : "Direct Sum") << std::endl;
+    }
+    if (key == 'r' || key == 'R') {
+        // 렌더 스레드 설정이라 워커에 넘기지 않음
+        useRayVbo = !useRayVbo;
+        std::cout << "Ray Renderer: " << (useRayVbo ? "VBO" : "Immediate") << std::endl;
+    }
+    if (key == 'k' || key == 'K') {
+        useSkybox = !useSkybox;
+        std::cout << "Sky: " << (useSkybox ? "Cube Map" : "Sky Dome") << std::endl;
+    }
+    if (key == 'g' || key == 'G') {
+        // 끄면 기존 고정 품질로 돌아감
+        useQualityGovernor = !useQualityGovernor;
+        QualityGovernorConfig config = qualityGovernor.config;
+        initQualityGovernor(qualityGovernor, config);
+        applyQualityLevel();
+        std::cout << "Quality Governor: " << (useQualityGovernor ? "On" : "Off") << std::endl;
+    }
+    if (key == 't' || key == 'T') {
+        // 1 -> 2 -> 4 -> 8 -> 1, 위상 캐시와 같이 쓸 수 없으므로 시간 분할을 켜면 캐시를 끔
+        c.rayAmortizeStride = (c.rayAmortizeStride >= 8) ? 1 : c.rayAmortizeStride * 2;
+        if (c.rayAmortizeStride > 1 && c.useRayPhaseCache) {
+            c.useRayPhaseCache = false;
+            std::cout << "Orbit Phase Cache: Off" << std::endl;
+        }
+        applyQualityLevel();
+        std::cout << "Temporal Rays: 1/" << c.rayAmortizeStride << " per frame, " << c.numRays << " rays" << std::endl;
+    }
+    if (key == 'c' || key == 'C') {
+        // 끄면 저장한 경로를 버림 (다시 켜면 처음부터 채움), 켜면 시간 분할을 끄고 광선 수를 단계 값으로 되돌림
+        c.useRayPhaseCache = !c.useRayPhaseCache;
+        if (c.useRayPhaseCache) c.rayAmortizeStride = 1;
+        applyQualityLevel();
+        std::cout << "Orbit Phase Cache: " << (c.useRayPhaseCache ? "On" : "Off") << std::endl;
+    }
+    if (key == 'n' || key == 'N') {
+        // 끔 -> Leapfrog -> Yoshida 4차 -> 끔 (켤 때마다 그 시각의 궤도에서 다시 시작)
+        if (!c.useNBody) {
+            c.useNBody = true;
+            c.nbodyIntegrator = NBODY_LEAPFROG;
+        }
+        else if (c.nbodyIntegrator == NBODY_LEAPFROG) {
+            c.nbodyIntegrator = NBODY_YOSHIDA4;
+        }
+        else {
+            c.useNBody = false;
+        }
+        std::cout << "N-Body: " << (c.useNBody ? (c.nbodyIntegrator == NBODY_YOSHIDA4 ? "Yoshida 4th Order" : "Leapfrog") : "Off (Kepler Orbits)") << std::endl;
+    }
+    if (key == 'p' || key == 'P') {
+        showProfilerHud = !showProfilerHud;
+    }
+    if (key == 'o' || key == 'O') {
+        // 고객 PC에서 프레임 끊김을 볼 때: CSV는 표 계산용, JSON은 chrome://tracing / Perfetto에서 열기
+        bool ok = writeProfileCsv("frame_profile.csv") && writeProfileTrace("frame_profile.json");
+        std::cout << (ok ? "Profile written: frame_profile.csv, frame_profile.json" : "Failed to write frame profile") << std::endl;
+    }
+    if (key == 'f' || key == 'F') {
+        // 천체가 움직이는 동안에는 매 프레임 다시 구우므로 정지한 장면에서만 이득
+        c.useAccelField = !c.useAccelField;
+        std::cout << "Baked Accel Field: " << (c.useAccelField ? "On" : "Off") << std::endl;
+    }
+    submitSimControls(c);
 }
 
 void MyTimer(int Value) {
     glutPostRedisplay();
-    glutTimerFunc(16, MyTimer, 1); // 약 60 FPS 목표
+    glutTimerFunc(renderTimerMs, MyTimer, 1); // 기본 약 144 FPS 상한 (vsync가 켜져 있으면 모니터 주사율)
 }
 
 void reshape(int w, int h) {
@@ -827,9 +848,24 @@ void reshape(int w, int h) {
 
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
+    // glutInit이 GLUT 인자를 지운 뒤 남은 인자
+    TaskPoolConfig poolConfig;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (!std::strcmp(argv[i], "--target-ms")) qualityTargetMs = std::max(1.0, std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--scene")) scenePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--threads")) poolConfig.threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--pin-threads")) poolConfig.pinThreads = std::atoi(argv[++i]) != 0;
+        else if (!std::strcmp(argv[i], "--max-fps")) renderTimerMs = std::max(1, (int)(1000.0 / std::max(1.0, std::atof(argv[++i]))));
+    }
+    // 작업 스레드는 다른 종료 처리(텍스처 디코딩, 시뮬레이션 스레드)가 끝난 뒤 마지막에 멈춤
+    configureTaskPool(poolConfig);
+    std::atexit(stopTaskPool);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(1280, 720);
     glutCreateWindow("Gravitational Lensing Fixed");
+#ifdef _WIN32
+    glewInit(); // 컨텍스트가 생긴 뒤 GL 1.1 이후 함수 주소를 불러옴
+#endif
 
     init();
 
@@ -839,7 +875,12 @@ int main(int argc, char** argv) {
     glutMotionFunc(motionFunc);
 	glutKeyboardFunc(keyboardFunc);
     glutSpecialFunc(specialKeyFunc);
-    glutTimerFunc(16, MyTimer, 1);
+    glutTimerFunc(renderTimerMs, MyTimer, 1);
+
+    // 궤도/광선 계산 스레드 시작 (종료 시 join)
+    startSimulationThread();
+    std::atexit(stopSimulationThread);
+    std::atexit(shutdownTextureLoader);
 
     glutMainLoop();
     return 0;
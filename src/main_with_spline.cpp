@@ -18,7 +18,6 @@ struct Body {
     float mass;
     float radius;
     glm::vec3 color;
-    std::vector<Body*> satellites = {};
     
     Body* parent = nullptr;
     glm::vec3 relativeOffset;
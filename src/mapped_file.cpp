@@ -0,0 +1,61 @@
+﻿#include "mapped_file.h"
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool mapFileReadOnly(const char* path, MappedFile& file) {
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) { CloseHandle(handle); return false; }
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) { CloseHandle(handle); return false; }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) { CloseHandle(mapping); CloseHandle(handle); return false; }
+    file.fileHandle = handle;
+    file.mapHandle = mapping;
+    file.data = (const unsigned char*)view;
+    file.size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return false; }
+    void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // 매핑은 파일을 닫아도 유지됨
+    if (view == MAP_FAILED) return false;
+    file.data = (const unsigned char*)view;
+    file.size = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void unmapFile(MappedFile& file) {
+    if (file.data) {
+#ifdef _WIN32
+        UnmapViewOfFile(file.data);
+        if (file.mapHandle) CloseHandle((HANDLE)file.mapHandle);
+        if (file.fileHandle) CloseHandle((HANDLE)file.fileHandle);
+#else
+        munmap((void*)file.data, file.size);
+#endif
+    }
+    file = MappedFile();
+}
+
+bool fileStamp(const char* path, uint64_t& size, int64_t& time) {
+    std::error_code ec;
+    std::filesystem::path p(path);
+    size = (uint64_t)std::filesystem::file_size(p, ec);
+    if (ec) return false;
+    time = (int64_t)std::filesystem::last_write_time(p, ec).time_since_epoch().count();
+    return !ec;
+}
@@ -0,0 +1,20 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// --- 읽기 전용 파일 매핑 ---
+// 텍스처 캐시(.ehtx)와 장면 바이너리(.ehsb)가 같이 씀 (윈도우: CreateFileMapping, 그 외: mmap)
+
+struct MappedFile {
+    const unsigned char* data = nullptr; // 매핑 시작 주소
+    size_t size = 0;
+    void* fileHandle = nullptr; // 윈도우 전용 (파일/매핑 핸들)
+    void* mapHandle = nullptr;
+};
+
+// 빈 파일이거나 열 수 없으면 false (file은 비어있는 상태 유지)
+bool mapFileReadOnly(const char* path, MappedFile& file);
+void unmapFile(MappedFile& file);
+
+// 원본 파일 크기와 수정 시각 (file_time_type 틱), 캐시가 최신인지 비교할 때 씀
+bool fileStamp(const char* path, uint64_t& size, int64_t& time);
@@ -0,0 +1,446 @@
+﻿#include "nbody.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "simulation.h"
+#include "task_pool.h"
+#include "simd_lanes.h"
+
+bool useNBody = false;
+int nbodyIntegrator = NBODY_LEAPFROG;
+int nbodyForce = NBODY_FORCE_AUTO;
+float nbodyTimeStep = 0.005f;
+float nbodySoftening = 0.1f;
+float nbodyTheta = 0.5f;
+int nbodyEnergyInterval = 64;
+
+NBodyStats nbodyStats;
+
+// 힘 계산을 작업 풀로 나눌 때 작업 하나가 맡는 i 천체 수 (RAY_BATCH_LANES의 배수)
+static const int NBODY_TASK_BODIES = 256;
+
+// 적분 상태 (위치는 매 advanceNBody 끝에 bodies로 복사)
+// 위치 / 속도는 double로 누적 (작은 스텝의 변위를 float에 더하면 긴 적분에서 반올림이 쌓임)
+// 힘 커널은 질량중심 기준 float 사본(fx / fy / fz)으로 계산 (전체 운동량이 0이라 질량중심이 움직이지 않음, 원점에서 먼 장면도 반올림이 커지지 않게)
+struct NBodyState {
+    bool valid = false;
+    int count = 0;
+    double time = 0.0;
+    double centerX = 0.0, centerY = 0.0, centerZ = 0.0;
+    std::vector<double> x, y, z;
+    std::vector<double> vx, vy, vz;
+    std::vector<float> fx, fy, fz, mass;
+    std::vector<float> ax, ay, az; // 현재 위치의 가속도 (accelValid일 때만)
+    std::vector<float> potential;
+    bool accelValid = false;
+};
+
+static NBodyState state;
+static BodySoA treeInput;
+static BodyOctree tree;
+
+static double nowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// --- 직접 합산 ---
+// rsqrt 근사 + 뉴턴 한 번 (AVX2 rsqrt의 12비트 -> 약 23비트)
+static inline vfloat vInvSqrt(vfloat r2) {
+    vfloat inv = vRsqrt(r2);
+    return vMul(inv, vSub(vSet1(1.5f), vMul(vMul(vSet1(0.5f), r2), vMul(inv, inv))));
+}
+
+// i 천체 W개에 j 천체 [j0, j1)의 부드럽게 만든 중력을 더함 (자기 자신은 거리 0이라 힘이 0)
+// 위치 에너지는 거리 0인 항을 lane 마스크로 뺌 (다 더한 뒤 -m / eps를 빼면 무거운 천체에서 float 자릿수가 날아감)
+template <bool WITH_POTENTIAL>
+static inline void vAccumulateTile(const float* x, const float* y, const float* z, const float* mass, int j0, int j1,
+    vfloat xi, vfloat yi, vfloat zi, vfloat eps2, vfloat& ax, vfloat& ay, vfloat& az, vfloat& phi) {
+    for (int j = j0; j < j1; j++) {
+        vfloat dx = vSub(vSet1(x[j]), xi);
+        vfloat dy = vSub(vSet1(y[j]), yi);
+        vfloat dz = vSub(vSet1(z[j]), zi);
+        vfloat r2 = vFma(dx, dx, vFma(dy, dy, vFma(dz, dz, eps2)));
+        vfloat inv = vInvSqrt(r2);
+        vfloat mInv = vMul(vSet1(mass[j] * NBODY_G), inv);
+        vfloat s = vMul(mInv, vMul(inv, inv));
+        ax = vFma(dx, s, ax);
+        ay = vFma(dy, s, ay);
+        az = vFma(dz, s, az);
+        if (WITH_POTENTIAL) phi = vSub(phi, vSelect(vGreater(r2, eps2), mInv, vSet1(0.0f)));
+    }
+}
+
+// i 천체 [begin, end)가 j 천체 n개에게 받는 가속도 (j를 NBODY_TILE_BODIES개씩 나눠 캐시에 둔 채 i 묶음을 모두 돌고 다음 타일로)
+// 끝에 W개가 안 되는 i 천체는 마지막 천체를 채운 임시 lane으로 계산하고 필요한 만큼만 씀
+template <bool WITH_POTENTIAL>
+static void accumulateRange(const float* x, const float* y, const float* z, int begin, int end,
+    const float* jx, const float* jy, const float* jz, const float* jmass, int n,
+    float* ax, float* ay, float* az, float* potential) {
+    const int W = RAY_BATCH_LANES;
+    const vfloat zero = vSet1(0.0f);
+    const vfloat eps2 = vSet1(nbodySoftening * nbodySoftening);
+    alignas(64) float lane[4][RAY_BATCH_LANES];
+    for (int i = begin; i < end; i++) {
+        ax[i] = ay[i] = az[i] = 0.0f;
+        if (WITH_POTENTIAL) potential[i] = 0.0f;
+    }
+
+    for (int j0 = 0; j0 < n; j0 += NBODY_TILE_BODIES) {
+        const int j1 = std::min(n, j0 + NBODY_TILE_BODIES);
+        for (int i = begin; i < end; i += W) {
+            const int lanes = std::min(W, end - i);
+            vfloat xi, yi, zi, vax, vay, vaz, phi = zero;
+            if (lanes == W) {
+                xi = vLoadU(&x[i]); yi = vLoadU(&y[i]); zi = vLoadU(&z[i]);
+                vax = vLoadU(&ax[i]); vay = vLoadU(&ay[i]); vaz = vLoadU(&az[i]);
+                if (WITH_POTENTIAL) phi = vLoadU(&potential[i]);
+            }
+            else {
+                for (int l = 0; l < W; l++) {
+                    const int b = i + std::min(l, lanes - 1);
+                    lane[0][l] = x[b]; lane[1][l] = y[b]; lane[2][l] = z[b];
+                }
+                xi = vLoad(lane[0]); yi = vLoad(lane[1]); zi = vLoad(lane[2]);
+                for (int l = 0; l < W; l++) {
+                    const int b = i + std::min(l, lanes - 1);
+                    lane[0][l] = ax[b]; lane[1][l] = ay[b]; lane[2][l] = az[b];
+                    lane[3][l] = WITH_POTENTIAL ? potential[b] : 0.0f;
+                }
+                vax = vLoad(lane[0]); vay = vLoad(lane[1]); vaz = vLoad(lane[2]); phi = vLoad(lane[3]);
+            }
+
+            vAccumulateTile<WITH_POTENTIAL>(jx, jy, jz, jmass, j0, j1, xi, yi, zi, eps2, vax, vay, vaz, phi);
+
+            if (lanes == W) {
+                vStoreU(&ax[i], vax); vStoreU(&ay[i], vay); vStoreU(&az[i], vaz);
+                if (WITH_POTENTIAL) vStoreU(&potential[i], phi);
+            }
+            else {
+                vStore(lane[0], vax); vStore(lane[1], vay); vStore(lane[2], vaz); vStore(lane[3], phi);
+                for (int l = 0; l < lanes; l++) {
+                    ax[i + l] = lane[0][l]; ay[i + l] = lane[1][l]; az[i + l] = lane[2][l];
+                    if (WITH_POTENTIAL) potential[i + l] = lane[3][l];
+                }
+            }
+        }
+    }
+}
+
+// --- 트리 ---
+// 천체 하나씩 트리를 내려가지 않고 가까운 천체 묶음(트리 노드 하나, NBODY_TREE_GROUP_BODIES개 이하)마다 한 번 내려가서
+// 묶음 전체에 쓸 상호작용 목록(멀리 있는 노드의 질량중심 + 열어야 하는 리프의 천체)을 만든 뒤 직접 합산 커널로 계산
+// 노드 열기 판정은 노드 경계 상자와 묶음 경계 상자 사이 거리 기준이라 묶음 안 모든 천체에 대해 크기 / 거리 < theta가 성립
+// (묶음 천체를 담은 노드는 거리가 0이라 항상 열림, 질량중심의 float 반올림 때문에 자기 자신을 끌어당기는 일이 없음)
+// (광선용 octreeAcceleration과 달리 충돌 판정 없이 부드럽게 만든 중력)
+struct TreeInteractions {
+    std::vector<float> x, y, z, mass;
+    void clear() { x.clear(); y.clear(); z.clear(); mass.clear(); }
+    void add(float px, float py, float pz, float m) { x.push_back(px); y.push_back(py); z.push_back(pz); mass.push_back(m); }
+};
+
+static std::vector<int> treeGroups;
+static std::vector<float> treeAx, treeAy, treeAz, treePotential; // tree.bodies 순서
+
+static void collectTreeGroups(int nodeIndex) {
+    const OctreeNode& node = tree.nodes[nodeIndex];
+    if (node.count == 0) return;
+    if (node.firstChild < 0 || node.count <= NBODY_TREE_GROUP_BODIES) {
+        treeGroups.push_back(nodeIndex);
+        return;
+    }
+    for (int c = 0; c < node.childCount; c++) collectTreeGroups(node.firstChild + c);
+}
+
+static void buildInteractions(const OctreeNode& group, float thetaSq, TreeInteractions& list) {
+    const BodySoA& soa = tree.bodies;
+    list.clear();
+    int stack[OCTREE_STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const OctreeNode& node = tree.nodes[stack[--top]];
+        if (node.count == 0) continue;
+        glm::vec3 d = glm::max(glm::max(group.boxMin - node.boxMax, node.boxMin - group.boxMax), glm::vec3(0.0f));
+        if (node.size * node.size < thetaSq * glm::dot(d, d)) {
+            list.add(node.centerOfMass.x, node.centerOfMass.y, node.centerOfMass.z, node.mass);
+            continue;
+        }
+        if (node.firstChild >= 0) {
+            for (int c = 0; c < node.childCount; c++) stack[top++] = node.firstChild + c;
+            continue;
+        }
+        for (int b = node.first; b < node.first + node.count; b++) list.add(soa.x[b], soa.y[b], soa.z[b], soa.mass[b]);
+    }
+}
+
+void computeNBodyAccelerations(const float* x, const float* y, const float* z, const float* mass, int n, bool useTree,
+    float* ax, float* ay, float* az, float* potential) {
+    if (n <= 0) return;
+    if (!useTree) {
+        parallelFor(n, NBODY_TASK_BODIES, [&](int begin, int end) {
+            if (potential) accumulateRange<true>(x, y, z, begin, end, x, y, z, mass, n, ax, ay, az, potential);
+            else accumulateRange<false>(x, y, z, begin, end, x, y, z, mass, n, ax, ay, az, nullptr);
+        });
+        return;
+    }
+
+    // 반지름은 쓰지 않음
+    treeInput.count = n;
+    treeInput.x.assign(x, x + n);
+    treeInput.y.assign(y, y + n);
+    treeInput.z.assign(z, z + n);
+    treeInput.mass.assign(mass, mass + n);
+    treeInput.radiusSq.assign(n, 0.0f);
+    buildBodyOctree(tree, treeInput);
+    treeGroups.clear();
+    collectTreeGroups(0);
+    for (auto column : { &treeAx, &treeAy, &treeAz, &treePotential }) column->resize(n);
+
+    const float thetaSq = nbodyTheta * nbodyTheta;
+    const BodySoA& soa = tree.bodies;
+    parallelFor((int)treeGroups.size(), 1, [&](int begin, int end) {
+        static thread_local TreeInteractions list;
+        for (int g = begin; g < end; g++) {
+            const OctreeNode& group = tree.nodes[treeGroups[g]];
+            buildInteractions(group, thetaSq, list);
+            const int first = group.first, last = group.first + group.count, count = (int)list.x.size();
+            if (potential) {
+                accumulateRange<true>(soa.x.data(), soa.y.data(), soa.z.data(), first, last, list.x.data(), list.y.data(), list.z.data(), list.mass.data(), count,
+                    treeAx.data(), treeAy.data(), treeAz.data(), treePotential.data());
+            }
+            else {
+                accumulateRange<false>(soa.x.data(), soa.y.data(), soa.z.data(), first, last, list.x.data(), list.y.data(), list.z.data(), list.mass.data(), count,
+                    treeAx.data(), treeAy.data(), treeAz.data(), nullptr);
+            }
+        }
+    });
+
+    // 원래 순서로 되돌림
+    for (int k = 0; k < n; k++) {
+        const int i = tree.order[k];
+        ax[i] = treeAx[k];
+        ay[i] = treeAy[k];
+        az[i] = treeAz[k];
+        if (potential) potential[i] = treePotential[k];
+    }
+}
+
+static bool useTreeForces(int n) {
+    return nbodyForce == NBODY_FORCE_TREE || (nbodyForce == NBODY_FORCE_AUTO && n >= NBODY_TREE_MIN_BODIES);
+}
+
+static void computeForces(bool withPotential) {
+    const int n = state.count;
+    double t0 = nowMs();
+    for (int i = 0; i < n; i++) {
+        state.fx[i] = (float)(state.x[i] - state.centerX);
+        state.fy[i] = (float)(state.y[i] - state.centerY);
+        state.fz[i] = (float)(state.z[i] - state.centerZ);
+    }
+    nbodyStats.usedTree = useTreeForces(n);
+    computeNBodyAccelerations(state.fx.data(), state.fy.data(), state.fz.data(), state.mass.data(), n, nbodyStats.usedTree,
+        state.ax.data(), state.ay.data(), state.az.data(), withPotential ? state.potential.data() : nullptr);
+    nbodyStats.forceMs = nowMs() - t0;
+    state.accelValid = true;
+}
+
+// --- 적분 ---
+static void drift(double h) {
+    for (int i = 0; i < state.count; i++) {
+        state.x[i] += state.vx[i] * h;
+        state.y[i] += state.vy[i] * h;
+        state.z[i] += state.vz[i] * h;
+    }
+}
+
+static void kick(double h) {
+    for (int i = 0; i < state.count; i++) {
+        state.vx[i] += state.ax[i] * h;
+        state.vy[i] += state.ay[i] * h;
+        state.vz[i] += state.az[i] * h;
+    }
+}
+
+// leapfrog KDK: 끝 위치의 가속도가 다음 스텝 첫 킥에 그대로 쓰임
+static void stepLeapfrog(double h) {
+    if (!state.accelValid) computeForces(false);
+    kick(0.5 * h);
+    drift(h);
+    computeForces(false);
+    kick(0.5 * h);
+}
+
+// Yoshida 4차 (leapfrog 세 번을 w1, w0, w1 비율로 합성한 drift-kick 형태)
+static void stepYoshida4(double h) {
+    const double cbrt2 = std::cbrt(2.0);
+    const double w1 = 1.0 / (2.0 - cbrt2);
+    const double w0 = -cbrt2 / (2.0 - cbrt2);
+    const double c[4] = { 0.5 * w1, 0.5 * (w0 + w1), 0.5 * (w0 + w1), 0.5 * w1 };
+    const double d[3] = { w1, w0, w1 };
+    for (int k = 0; k < 3; k++) {
+        drift(c[k] * h);
+        computeForces(false);
+        kick(d[k] * h);
+    }
+    drift(c[3] * h);
+    state.accelValid = false; // 마지막 가속도는 중간 위치 값
+}
+
+void measureNBodyEnergy() {
+    if (!state.valid || state.count == 0) return;
+    computeForces(true);
+    double kinetic = 0.0, potential = 0.0;
+    for (int i = 0; i < state.count; i++) {
+        double v2 = state.vx[i] * state.vx[i] + state.vy[i] * state.vy[i] + state.vz[i] * state.vz[i];
+        kinetic += 0.5 * state.mass[i] * v2;
+        potential += 0.5 * state.mass[i] * state.potential[i]; // 쌍마다 두 번 세므로 절반
+    }
+    nbodyStats.kinetic = kinetic;
+    nbodyStats.potential = potential;
+    nbodyStats.energy = kinetic + potential;
+    double scale = std::fabs(nbodyStats.initialEnergy);
+    nbodyStats.relativeDrift = (scale > 0.0) ? std::fabs(nbodyStats.energy - nbodyStats.initialEnergy) / scale : 0.0;
+    nbodyStats.maxRelativeDrift = std::max(nbodyStats.maxRelativeDrift, nbodyStats.relativeDrift);
+}
+
+// 에너지 기준을 지금 상태로 다시 잡음
+static void resetEnergyBaseline() {
+    nbodyStats.initialEnergy = 0.0;
+    measureNBodyEnergy();
+    nbodyStats.initialEnergy = nbodyStats.energy;
+    nbodyStats.relativeDrift = 0.0;
+    nbodyStats.maxRelativeDrift = 0.0;
+}
+
+// 시각 time의 궤도 위치에서 시작
+// 궤도 모양 / 방향은 궤도 요소 그대로, 속도 크기는 부모와 자식 계층 전체 질량의 케플러 궤도 (vis-viva)
+// 자식 계층은 부모 천체를 상대 속도로 돌고, 부모 천체는 그만큼 반대로 움직여서 계층 질량중심이 부모의 궤도를 따라감
+// (부모를 그대로 두면 행성이 항성에 주는 운동량 때문에 항성의 궤도가 크게 찌그러짐)
+// 전체 운동량이 0이 되도록 질량중심 속도를 뺌
+static void initState(float time) {
+    updateBodyPositions(bodies, time);
+    const int n = bodies.count;
+    state.count = n;
+    state.time = time;
+    state.x.assign(bodies.x.begin(), bodies.x.end());
+    state.y.assign(bodies.y.begin(), bodies.y.end());
+    state.z.assign(bodies.z.begin(), bodies.z.end());
+    state.fx.resize(n);
+    state.fy.resize(n);
+    state.fz.resize(n);
+    state.mass = bodies.mass;
+    state.vx.assign(n, 0.0);
+    state.vy.assign(n, 0.0);
+    state.vz.assign(n, 0.0);
+    for (auto column : { &state.ax, &state.ay, &state.az, &state.potential }) column->assign(n, 0.0f);
+
+    // 계층 질량 (단계 순서라 뒤에서부터 부모에 더하면 됨)
+    std::vector<double> subtreeMass(bodies.mass.begin(), bodies.mass.end());
+    for (int i = n - 1; i >= 0; i--) {
+        if (bodies.parent[i] >= 0) subtreeMass[bodies.parent[i]] += subtreeMass[i];
+    }
+
+    // 부모 기준 상대 속도 (state.v에 잠시 둠)와 부모 천체가 반대로 받는 몫 (ax에 잠시 둠)
+    std::vector<float> meanAnomaly(n), eccentricAnomaly(n);
+    for (int i = 0; i < n; i++) meanAnomaly[i] = time * 0.5f * bodies.orbitSpeed[i] + bodies.meanAnomaly[i];
+    solveKepler(meanAnomaly.data(), bodies.eccentricity.data(), eccentricAnomaly.data(), n);
+    std::vector<double> recoilX(n, 0.0), recoilY(n, 0.0), recoilZ(n, 0.0);
+    for (int i = 0; i < n; i++) {
+        const int p = bodies.parent[i];
+        const double a = bodies.orbitRadius[i];
+        if (p < 0 || a <= 0.0 || bodies.orbitSpeed[i] == 0.0f) continue;
+        const double e = bodies.eccentricity[i];
+        const double E = eccentricAnomaly[i];
+        const double mu = NBODY_G * (bodies.mass[p] + subtreeMass[i]);
+        const double r = a * (1.0 - e * std::cos(E));
+        const double speed = std::sqrt(mu * a) / r * (bodies.orbitSpeed[i] > 0.0f ? 1.0 : -1.0);
+        const double u = -std::sin(E) * speed, v = std::cos(E) * speed;
+        state.vx[i] = u * bodies.planePX[i] + v * bodies.planeQX[i];
+        state.vy[i] = u * bodies.planePY[i] + v * bodies.planeQY[i];
+        state.vz[i] = u * bodies.planePZ[i] + v * bodies.planeQZ[i];
+        const double share = subtreeMass[i] / subtreeMass[p];
+        recoilX[p] -= share * state.vx[i];
+        recoilY[p] -= share * state.vy[i];
+        recoilZ[p] -= share * state.vz[i];
+    }
+
+    // 천체 속도 = 부모 천체 속도 + 상대 속도 + 자식들에게 받는 반동 (단계 순서라 부모는 이미 계산됨)
+    double momentum[3] = { 0.0, 0.0, 0.0 }, center[3] = { 0.0, 0.0, 0.0 }, totalMass = 0.0;
+    for (int i = 0; i < n; i++) {
+        const int p = bodies.parent[i];
+        if (p >= 0) {
+            state.vx[i] += state.vx[p];
+            state.vy[i] += state.vy[p];
+            state.vz[i] += state.vz[p];
+        }
+        state.vx[i] += recoilX[i];
+        state.vy[i] += recoilY[i];
+        state.vz[i] += recoilZ[i];
+        momentum[0] += bodies.mass[i] * state.vx[i];
+        momentum[1] += bodies.mass[i] * state.vy[i];
+        momentum[2] += bodies.mass[i] * state.vz[i];
+        center[0] += bodies.mass[i] * state.x[i];
+        center[1] += bodies.mass[i] * state.y[i];
+        center[2] += bodies.mass[i] * state.z[i];
+        totalMass += bodies.mass[i];
+    }
+    if (totalMass > 0.0) {
+        for (int i = 0; i < n; i++) {
+            state.vx[i] -= momentum[0] / totalMass;
+            state.vy[i] -= momentum[1] / totalMass;
+            state.vz[i] -= momentum[2] / totalMass;
+        }
+    }
+    state.centerX = (totalMass > 0.0) ? center[0] / totalMass : 0.0;
+    state.centerY = (totalMass > 0.0) ? center[1] / totalMass : 0.0;
+    state.centerZ = (totalMass > 0.0) ? center[2] / totalMass : 0.0;
+
+    state.valid = true;
+    state.accelValid = false;
+    nbodyStats = NBodyStats();
+    nbodyStats.time = time;
+    resetEnergyBaseline();
+}
+
+void resetNBody() {
+    state.valid = false;
+}
+
+int advanceNBody(float time) {
+    if (!state.valid || state.count != bodies.count) {
+        initState(time);
+        return 0;
+    }
+
+    // 질량 편집: 가속도가 달라지고 에너지도 바뀌므로 기준을 새로 잡음
+    if (!std::equal(state.mass.begin(), state.mass.end(), bodies.mass.begin())) {
+        state.mass = bodies.mass;
+        state.accelValid = false;
+        resetEnergyBaseline();
+    }
+
+    const double h = nbodyTimeStep;
+    long long steps = (long long)std::floor((time - state.time) / h);
+    if (steps <= 0) return 0;
+    if (steps > NBODY_MAX_STEPS_PER_UPDATE) {
+        double skipped = (double)(steps - NBODY_MAX_STEPS_PER_UPDATE) * h;
+        state.time += skipped;
+        nbodyStats.droppedTime += skipped;
+        steps = NBODY_MAX_STEPS_PER_UPDATE;
+    }
+    for (long long s = 0; s < steps; s++) {
+        if (nbodyIntegrator == NBODY_YOSHIDA4) stepYoshida4(h);
+        else stepLeapfrog(h);
+        state.time += h;
+        nbodyStats.steps++;
+        if (nbodyEnergyInterval > 0 && nbodyStats.steps % nbodyEnergyInterval == 0) measureNBodyEnergy();
+    }
+    nbodyStats.time = state.time;
+
+    for (int i = 0; i < state.count; i++) {
+        bodies.x[i] = (float)state.x[i];
+        bodies.y[i] = (float)state.y[i];
+        bodies.z[i] = (float)state.z[i];
+    }
+    return (int)steps;
+}
@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <vector>
+#include "body_store.h"
+
+// --- N체 동역학 ---
+// 켜면 천체가 궤도 요소를 따라가지 않고 서로의 중력으로 움직임 (광선만 천체 질량을 느끼던 것과 달리 천체끼리도 끌어당김)
+// 고정 스텝 심플렉틱 적분 (leapfrog KDK 또는 Yoshida 4차), 에너지가 한쪽으로 새지 않고 스텝 크기에 맞는 범위에서 흔들림
+// 힘: 직접 합산 O(N^2) (j 천체를 타일로 나눠 캐시에 두고 i 천체 lane 묶음에 더함) 또는 천체가 많으면 Barnes-Hut 트리
+//     (트리는 가까운 천체 묶음마다 상호작용 목록을 만들어 같은 lane 커널로 합산)
+// 중력은 부드럽게 만든 1 / (r^2 + eps^2) (천체끼리 겹쳐도 발산하지 않음, 충돌 / 합체는 없음)
+// 켤 때의 위치 / 속도는 그 시각의 케플러 궤도 (부모 주위 속도는 두 천체 질량으로 다시 계산해서 실제로 묶인 궤도가 됨)
+// 시뮬레이션 스레드 전용 (bodies.x / y / z를 직접 바꿈)
+
+enum NBodyIntegrator {
+    NBODY_LEAPFROG = 0, // 2차, 스텝당 힘 계산 1번
+    NBODY_YOSHIDA4 = 1, // 4차, 스텝당 힘 계산 3번
+};
+
+enum NBodyForce {
+    NBODY_FORCE_AUTO = 0,   // 천체 수가 NBODY_TREE_MIN_BODIES 이상이면 트리
+    NBODY_FORCE_DIRECT = 1,
+    NBODY_FORCE_TREE = 2,
+};
+
+const float NBODY_G = 1.0f;
+// 자동 선택에서 트리로 바꾸는 천체 수 (SIMD 직접 합산이 이 아래에서 더 빠름, nbody 벤치마크 기준)
+const int NBODY_TREE_MIN_BODIES = 4096;
+// 직접 합산에서 캐시에 두는 j 천체 수 (x, y, z, 질량 4 x 4바이트 -> 8KB)
+const int NBODY_TILE_BODIES = 512;
+// 트리 모드에서 상호작용 목록 하나를 같이 쓰는 천체 묶음의 최대 크기 (트리 노드 단위)
+const int NBODY_TREE_GROUP_BODIES = 256;
+// updateBodyPhysics 한 번에 적분하는 최대 스텝 수 (넘으면 남은 시간은 버림, 느린 프레임이 다음 프레임을 더 느리게 만들지 않게)
+const int NBODY_MAX_STEPS_PER_UPDATE = 8;
+
+struct NBodyStats {
+    long long steps = 0;       // 마지막 초기화 뒤 적분한 스텝 수
+    double time = 0.0;         // 적분한 시뮬레이션 시각
+    double droppedTime = 0.0;  // NBODY_MAX_STEPS_PER_UPDATE에 걸려 적분하지 않고 넘긴 시간 합
+    bool usedTree = false;     // 마지막 힘 계산에 트리를 썼는지
+    double forceMs = 0.0;      // 마지막 힘 계산 한 번의 시간
+
+    // 에너지 (measureNBodyEnergy가 채움, 트리 모드의 위치 에너지는 트리 근사값)
+    double kinetic = 0.0;
+    double potential = 0.0;
+    double energy = 0.0;
+    double initialEnergy = 0.0;  // 초기화 / 질량 편집 직후 에너지
+    double relativeDrift = 0.0;  // |E - E0| / |E0|
+    double maxRelativeDrift = 0.0;
+};
+
+// --- 설정 변수 ---
+extern bool useNBody;
+extern int nbodyIntegrator;  // NBodyIntegrator
+extern int nbodyForce;       // NBodyForce
+extern float nbodyTimeStep;  // 고정 스텝 (시뮬레이션 시간 단위)
+extern float nbodySoftening; // eps (0보다 커야 함)
+extern float nbodyTheta;     // 트리 열림 각도
+extern int nbodyEnergyInterval; // 이 스텝마다 에너지를 다시 잼 (0이면 measureNBodyEnergy를 직접 부를 때만)
+
+extern NBodyStats nbodyStats;
+
+// 다음 advanceNBody에서 그 시각의 궤도로 다시 시작 (켤 때 / 장면을 바꿨을 때)
+void resetNBody();
+// 시각 time까지 고정 스텝으로 적분하고 bodies 위치를 바꿈 (time이 적분한 시각보다 앞이면 그대로), 적분한 스텝 수를 돌려줌
+// bodies.mass가 바뀌었으면 (질량 편집) 가속도를 다시 계산하고 에너지 기준을 새로 잡음
+int advanceNBody(float time);
+// 현재 상태의 운동 / 위치 에너지와 드리프트를 nbodyStats에 (힘 계산 한 번과 비용이 같음)
+void measureNBodyEnergy();
+
+// 위치 / 질량 배열 n개의 부드럽게 만든 중력 가속도 (벤치마크 / 검증용, 적분과 같은 커널)
+// potential이 있으면 천체별 위치 에너지 / 질량(자기 자신 제외)도 채움
+void computeNBodyAccelerations(const float* x, const float* y, const float* z, const float* mass, int n, bool useTree,
+    float* ax, float* ay, float* az, float* potential = nullptr);
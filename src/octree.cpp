@@ -0,0 +1,160 @@
+﻿#include "octree.h"
+#include <cmath>
+#include <algorithm>
+
+// order[first, first + count) 범위의 천체로 노드를 채우고 필요하면 8등분
+static void buildNode(BodyOctree& tree, const BodySoA& soa, int nodeIndex, int first, int count, int depth) {
+    glm::vec3 lo(1e30f), hi(-1e30f), weighted(0.0f);
+    float mass = 0.0f, maxRadiusSq = 0.0f;
+    for (int i = first; i < first + count; i++) {
+        int b = tree.order[i];
+        glm::vec3 p(soa.x[b], soa.y[b], soa.z[b]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+        weighted += p * soa.mass[b];
+        mass += soa.mass[b];
+        maxRadiusSq = std::max(maxRadiusSq, soa.radiusSq[b]);
+    }
+
+    OctreeNode& node = tree.nodes[nodeIndex];
+    node.centerOfMass = (mass > 0.0f) ? weighted / mass : (lo + hi) * 0.5f;
+    node.mass = mass;
+    node.boxMin = lo;
+    node.boxMax = hi;
+    node.size = std::max(hi.x - lo.x, std::max(hi.y - lo.y, hi.z - lo.z));
+    node.maxRadius = std::sqrt(maxRadiusSq);
+    node.firstChild = -1;
+    node.childCount = 0;
+    node.first = first;
+    node.count = count;
+    if (count <= OCTREE_LEAF_SIZE || depth >= OCTREE_MAX_DEPTH || node.size <= 0.0f) return;
+
+    // 경계 상자 중심 기준 8분면으로 계수 정렬
+    glm::vec3 mid = (lo + hi) * 0.5f;
+    int octantCount[8] = { 0 };
+    for (int i = first; i < first + count; i++) {
+        int b = tree.order[i];
+        int o = (soa.x[b] > mid.x ? 1 : 0) | (soa.y[b] > mid.y ? 2 : 0) | (soa.z[b] > mid.z ? 4 : 0);
+        octantCount[o]++;
+    }
+    int octantStart[8];
+    int offset = first, children = 0;
+    for (int o = 0; o < 8; o++) {
+        octantStart[o] = offset;
+        offset += octantCount[o];
+        if (octantCount[o] > 0) children++;
+    }
+    int cursor[8];
+    std::copy(octantStart, octantStart + 8, cursor);
+    for (int i = first; i < first + count; i++) {
+        int b = tree.order[i];
+        int o = (soa.x[b] > mid.x ? 1 : 0) | (soa.y[b] > mid.y ? 2 : 0) | (soa.z[b] > mid.z ? 4 : 0);
+        tree.scratch[cursor[o]++] = b;
+    }
+    std::copy(tree.scratch.begin() + first, tree.scratch.begin() + first + count, tree.order.begin() + first);
+
+    // 자식은 연속된 인덱스로 먼저 자리를 잡고 (push_back으로 node 참조가 무효화되므로 인덱스로 접근)
+    int firstChild = (int)tree.nodes.size();
+    tree.nodes.resize(firstChild + children);
+    tree.nodes[nodeIndex].firstChild = firstChild;
+    tree.nodes[nodeIndex].childCount = children;
+
+    int child = firstChild;
+    for (int o = 0; o < 8; o++) {
+        if (octantCount[o] == 0) continue;
+        buildNode(tree, soa, child++, octantStart[o], octantCount[o], depth + 1);
+    }
+}
+
+void buildBodyOctree(BodyOctree& tree, const BodySoA& soa) {
+    int n = soa.count;
+    tree.nodes.clear();
+    tree.order.resize(n);
+    tree.scratch.resize(n);
+    for (int i = 0; i < n; i++) tree.order[i] = i;
+
+    tree.nodes.resize(1);
+    if (n > 0) {
+        buildNode(tree, soa, 0, 0, n, 0);
+    }
+    else {
+        tree.nodes[0] = OctreeNode();
+        tree.nodes[0].firstChild = -1;
+        tree.nodes[0].count = 0;
+    }
+
+    // 리프 범위가 연속되도록 천체를 노드 순서로 복사
+    BodySoA& out = tree.bodies;
+    out.x.resize(n); out.y.resize(n); out.z.resize(n);
+    out.mass.resize(n); out.radiusSq.resize(n);
+    for (int i = 0; i < n; i++) {
+        int b = tree.order[i];
+        out.x[i] = soa.x[b];
+        out.y[i] = soa.y[b];
+        out.z[i] = soa.z[b];
+        out.mass[i] = soa.mass[b];
+        out.radiusSq[i] = soa.radiusSq[b];
+    }
+    out.count = n;
+    out.boundCenter = soa.boundCenter;
+    out.boundRadius = soa.boundRadius;
+    out.totalMass = soa.totalMass;
+}
+
+// 점에서 경계 상자까지 거리 제곱 (안쪽이면 0)
+static inline float boxDistSq(const OctreeNode& node, const glm::vec3& pos) {
+    glm::vec3 d = glm::max(glm::max(node.boxMin - pos, pos - node.boxMax), glm::vec3(0.0f));
+    return glm::dot(d, d);
+}
+
+glm::vec3 octreeAcceleration(const BodyOctree& tree, const glm::vec3& pos, float theta,
+    float& minDistSq, bool& crashed) {
+    glm::vec3 totalAccel = { 0, 0, 0 };
+    crashed = false;
+    minDistSq = 1e9f;
+
+    const float thetaSq = theta * theta;
+    const BodySoA& soa = tree.bodies;
+
+    int stack[OCTREE_STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const OctreeNode& node = tree.nodes[stack[--top]];
+        if (node.count == 0) continue;
+
+        glm::vec3 dir = node.centerOfMass - pos;
+        float distSq = glm::dot(dir, dir);
+
+        if (node.firstChild >= 0) {
+            // 멀리 있는 노드는 질량중심 하나로 근사
+            // 단, 상자 + 최대 반지름 안쪽이면 충돌 가능성이 있으므로 반드시 연다
+            float clearSq = boxDistSq(node, pos);
+            if (node.size * node.size < thetaSq * distSq && clearSq > node.maxRadius * node.maxRadius) {
+                if (clearSq < minDistSq) minDistSq = clearSq;
+                float dist = std::sqrt(distSq);
+                totalAccel += dir * (node.mass / (distSq * dist) * 5.0f);
+                continue;
+            }
+            for (int c = 0; c < node.childCount; c++) stack[top++] = node.firstChild + c;
+            continue;
+        }
+
+        // 리프: 직접 합산 (computeAcceleration과 같은 식)
+        for (int b = node.first; b < node.first + node.count; b++) {
+            glm::vec3 d = glm::vec3(soa.x[b], soa.y[b], soa.z[b]) - pos;
+            float dSq = glm::dot(d, d);
+
+            if (dSq < soa.radiusSq[b]) {
+                crashed = true;
+                return totalAccel;
+            }
+            if (dSq < minDistSq) minDistSq = dSq;
+
+            float dist = std::sqrt(dSq);
+            totalAccel += d * (soa.mass[b] / (dSq * dist) * 5.0f);
+        }
+    }
+    return totalAccel;
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "ray_batch.h"
+
+// --- Barnes-Hut 옥트리 ---
+// 천체가 수천 개일 때 광선 한 스텝의 중력 합산을 O(log N)으로 줄이기 위한 트리
+// 매 프레임 updateBodyPhysics 뒤에 BodySoA로부터 다시 만듦 (용량은 유지하므로 재할당 없음)
+
+struct OctreeNode {
+    glm::vec3 centerOfMass;
+    float mass;
+    glm::vec3 boxMin, boxMax; // 노드 안 천체 중심들의 경계 상자
+    float size;               // 경계 상자의 가장 긴 변 (열림 각도 판정용)
+    float maxRadius;          // 노드 안 천체 중 가장 큰 반지름 (충돌 판정용)
+    int firstChild;           // 자식 노드 시작 인덱스 (-1이면 리프)
+    int childCount;
+    int first, count;         // tree.bodies 안의 천체 범위 (리프는 이 범위를 직접 합산)
+};
+
+struct BodyOctree {
+    std::vector<OctreeNode> nodes; // nodes[0]이 루트
+    BodySoA bodies;                // 노드 순서로 재배치한 천체 (리프 범위가 연속)
+    std::vector<int> order, scratch; // 빌드용 임시 배열
+};
+
+// 천체 수가 이보다 적으면 트리보다 직접 합산이 빠름
+// SIMD 엔진의 직접 합산은 훨씬 빨라서 수천 개부터 트리가 이김 (cluster 벤치마크 기준)
+const int OCTREE_MIN_BODIES = 32;
+const int OCTREE_MIN_BODIES_SIMD = 2048;
+
+// 리프 하나에 담을 최대 천체 수, 같은 위치에 천체가 겹쳐도 끝나도록 깊이 제한
+const int OCTREE_LEAF_SIZE = 8;
+const int OCTREE_MAX_DEPTH = 24;
+// 깊이 우선 순회 스택 크기 (단계마다 자식을 최대 8개 쌓음)
+const int OCTREE_STACK_SIZE = OCTREE_MAX_DEPTH * 8 + 1;
+
+void buildBodyOctree(BodyOctree& tree, const BodySoA& soa);
+
+// 한 위치에서의 중력 가속도 (computeAcceleration의 트리 버전)
+// 노드 크기 / 질량중심까지 거리 < theta 이고 노드 안 천체와 충돌할 수 없을 만큼 멀면 질량중심 하나로 근사
+// minDistSq: 근사한 노드는 경계 상자까지 거리를 씀 (실제 값 이하라서 dt가 보수적으로 작아짐)
+glm::vec3 octreeAcceleration(const BodyOctree& tree, const glm::vec3& pos, float theta,
+    float& minDistSq, bool& crashed);
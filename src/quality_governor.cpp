@@ -0,0 +1,75 @@
+﻿#include "quality_governor.h"
+#include <algorithm>
+
+// 광선 수 x 스텝 예산이 단계마다 약 1.5배씩 늘도록 잡음
+// (한 단계 올리면 시간이 약 1.5배 -> upscaleRatio 0.7에서 올려도 1.05배라 downscaleRatio 1.1에 걸리지 않음)
+const QualityLevel QUALITY_LADDER[QUALITY_LEVELS] = {
+    {   60,  900, 2.0f },
+    {   80, 1000, 1.5f },
+    {  100, 1200, 1.25f },
+    {  140, 1300, 1.0f },
+    {  180, 1500, 0.75f },
+    {  250, 1600, 0.6f },
+    {  300, 2000, 0.5f },
+    {  450, 2000, 0.5f },
+    {  600, 2250, 0.4f },
+    {  800, 2500, 0.35f },
+    { 1000, 3000, 0.25f },
+};
+
+void initQualityGovernor(QualityGovernor& governor, const QualityGovernorConfig& config, int level) {
+    governor = QualityGovernor();
+    governor.config = config;
+    governor.config.windowFrames = std::max(1, config.windowFrames);
+    governor.level = std::max(0, std::min(level, QUALITY_LEVELS - 1));
+    governor.window.reserve(governor.config.windowFrames);
+}
+
+static void changeLevel(QualityGovernor& governor, int level) {
+    governor.level = level;
+    governor.discardWindow = true;
+    governor.calmWindows = 0;
+    governor.changes++;
+}
+
+bool updateQualityGovernor(QualityGovernor& governor, double frameMs) {
+    const QualityGovernorConfig& c = governor.config;
+    governor.window.push_back((float)frameMs);
+    if ((int)governor.window.size() < c.windowFrames) return false;
+
+    // 창 p90
+    size_t k = governor.window.size() * 9 / 10;
+    std::nth_element(governor.window.begin(), governor.window.begin() + k, governor.window.end());
+    float p90 = governor.window[k];
+    governor.window.clear();
+    governor.lastWindowMs = p90;
+
+    if (governor.discardWindow) {
+        governor.discardWindow = false;
+        return false;
+    }
+
+    if (p90 > c.targetMs * c.downscaleRatio) {
+        governor.calmWindows = 0;
+        if (governor.level == 0) return false;
+        // 이 단계는 버티지 못했으므로 다음에 올라올 때 더 오래 기다림
+        governor.failures[governor.level] = std::min(governor.failures[governor.level] + 1, c.maxBackoffShift);
+        changeLevel(governor, governor.level - 1);
+        return true;
+    }
+
+    if (p90 < c.targetMs * c.upscaleRatio) {
+        governor.calmWindows++;
+        if (governor.level + 1 >= QUALITY_LEVELS) return false;
+        int needed = c.upscaleWindows << governor.failures[governor.level + 1];
+        if (governor.calmWindows >= needed) {
+            changeLevel(governor, governor.level + 1);
+            return true;
+        }
+        return false;
+    }
+
+    // 목표 근처: 지금 단계 유지
+    governor.calmWindows = 0;
+    return false;
+}
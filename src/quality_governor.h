@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <vector>
+
+// --- 품질 조절기 ---
+// 프레임 시간을 재서 목표(예: 16.6ms)를 지키도록 품질 단계를 올리고 내림
+// 단계마다 활성 광선 수, 광선당 스텝 예산, 구체 LOD 허용 오차를 함께 바꿈
+// 흔들리지 않게 하는 장치 (히스테리시스):
+// - 판정은 windowFrames 프레임 창의 p90으로 함 (한 프레임 튐에는 반응하지 않음)
+// - 내릴 때는 창 하나로 바로, 올릴 때는 여유 있는 창이 upscaleWindows번 연속이어야 함
+// - 올렸다가 목표를 넘긴 단계는 다시 올리기 전 기다리는 창 수를 두 배씩 늘림
+// - 단계를 바꾼 직후 창은 버림 (바뀐 설정이 반영되기 전 값)
+// GL 의존성 없음
+
+struct QualityLevel {
+    int numRays;
+    int maxSteps;
+    float sphereLodErrorPx;
+};
+
+const int QUALITY_LEVELS = 11;
+// 낮은 단계부터 (QUALITY_DEFAULT_LEVEL이 기존 고정값 300 광선 / 2000 스텝 / 0.5px)
+extern const QualityLevel QUALITY_LADDER[QUALITY_LEVELS];
+const int QUALITY_DEFAULT_LEVEL = 6;
+
+struct QualityGovernorConfig {
+    double targetMs = 16.6;
+    double downscaleRatio = 1.10; // 창 p90 > 목표 x 이 값이면 한 단계 내림
+    double upscaleRatio = 0.70;   // 창 p90 < 목표 x 이 값이면 여유 있는 창
+    int windowFrames = 30;
+    int upscaleWindows = 4;
+    int maxBackoffShift = 4;      // 실패한 단계의 대기 창 수는 최대 upscaleWindows << 4
+};
+
+struct QualityGovernor {
+    QualityGovernorConfig config;
+    int level = QUALITY_DEFAULT_LEVEL;
+    std::vector<float> window;    // 이번 창의 프레임 시간
+    bool discardWindow = false;   // 단계를 바꾼 직후 창
+    int calmWindows = 0;          // 연속으로 여유가 있었던 창 수
+    int failures[QUALITY_LEVELS] = {}; // 단계별로 목표를 넘겨서 내려온 횟수
+    int changes = 0;              // 지금까지 단계를 바꾼 횟수
+    float lastWindowMs = 0.0f;    // 마지막 창의 p90
+};
+
+void initQualityGovernor(QualityGovernor& governor, const QualityGovernorConfig& config, int level = QUALITY_DEFAULT_LEVEL);
+
+// 프레임마다 호출 (frameMs: 그 프레임에서 가장 느린 쪽 시간), 단계가 바뀌면 true
+bool updateQualityGovernor(QualityGovernor& governor, double frameMs);
+
+inline const QualityLevel& currentQualityLevel(const QualityGovernor& governor) {
+    return QUALITY_LADDER[governor.level];
+}
@@ -0,0 +1,480 @@
+﻿#include "ray_batch.h"
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include "task_pool.h"
+#include "simd_lanes.h"
+
+const char* rayBatchInstructionSet() {
+#if defined(__AVX512F__)
+    return "AVX-512";
+#elif defined(__AVX2__)
+    return "AVX2";
+#else
+    return "Scalar";
+#endif
+}
+
+// 박스 경계를 확실히 넘기기 위한 추가 진행 시간 (광속 30 기준 약 0.003)
+static const float ESCAPE_OVERSHOOT = 1e-4f;
+
+static inline int popCount(unsigned bits) {
+    int n = 0;
+    for (; bits != 0; bits &= bits - 1) n++;
+    return n;
+}
+
+void computeBodyBounds(BodySoA& soa) {
+    soa.boundCenter = glm::vec3(0.0f);
+    soa.boundRadius = 0.0f;
+    soa.totalMass = 0.0f;
+    if (soa.count == 0) return;
+
+    glm::vec3 lo(soa.x[0], soa.y[0], soa.z[0]), hi = lo;
+    for (int b = 0; b < soa.count; b++) {
+        glm::vec3 p(soa.x[b], soa.y[b], soa.z[b]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+        soa.totalMass += soa.mass[b];
+    }
+    soa.boundCenter = (lo + hi) * 0.5f;
+    for (int b = 0; b < soa.count; b++) {
+        glm::vec3 d = glm::vec3(soa.x[b], soa.y[b], soa.z[b]) - soa.boundCenter;
+        soa.boundRadius = std::max(soa.boundRadius, glm::length(d));
+    }
+}
+
+bool tryAnalyticEscape(const BodySoA& soa, glm::vec3& pos, const glm::vec3& vel, float tolerance) {
+    glm::vec3 rel = pos - soa.boundCenter;
+    float d = glm::length(rel);
+    float s = d - soa.boundRadius; // 어느 천체 중심까지도 최소 이 거리 이상 떨어져 있음
+    if (s <= 0.0f) return false;
+
+    float vr = glm::dot(rel, vel) / d; // 경계 구에서 멀어지는 속도
+    if (vr <= 0.0f) return false;
+
+    // 직선으로 갔을 때 박스를 벗어나기까지 걸리는 시간
+    float T = 1e30f;
+    for (int k = 0; k < 3; k++) {
+        if (vel[k] > 0.0f) T = std::min(T, (200.0f - pos[k]) / vel[k]);
+        if (vel[k] < 0.0f) T = std::min(T, (-200.0f - pos[k]) / vel[k]);
+    }
+    T = std::max(T, 0.0f);
+
+    // 거리가 s + vr * t 이상으로 멀어진다고 보면 가속도 상한은 5M / (s + vr * t)^2
+    // 두 번 적분한 직선 대비 변위 상한은 5M / vr^2 * (q - ln(1 + q)), q = vr * T / s
+    // ln(1 + q) >= 2q / (2 + q) 로 로그를 없애면 5M * T^2 / (s * (2s + vr * T))
+    float bound = 5.0f * soa.totalMass * T * T / (s * (2.0f * s + vr * T));
+    if (bound > tolerance) return false;
+
+    // 경계에 딱 멈추면 박스 안으로 판정되므로 살짝 넘어가게 함
+    pos += vel * (T + ESCAPE_OVERSHOOT);
+    return true;
+}
+
+// 1/sqrt(x): 근사 rsqrt + 뉴턴 반복 1회 (y = y * (1.5 - 0.5 * x * y^2))
+static inline vfloat vRsqrtNewton(vfloat x) {
+    vfloat y = vRsqrt(x);
+    vfloat halfX = vMul(x, vSet1(0.5f));
+    vfloat yy = vMul(y, y);
+    return vMul(y, vSub(vSet1(1.5f), vMul(halfX, yy)));
+}
+
+// tryAnalyticEscape의 lane 버전 (같은 상한식, 함수 호출/로그 없이 레지스터 안에서 처리)
+// 탈출 가능한 lane 마스크를 돌려주고 그 lane의 x/y/z를 박스 밖 지점으로 옮김
+static inline vmask vTryAnalyticEscape(const BodySoA& soa, vfloat& x, vfloat& y, vfloat& z,
+    vfloat vx, vfloat vy, vfloat vz, vmask active, float tolerance) {
+    const vfloat zero = vSet1(0.0f);
+    vfloat rx = vSub(x, vSet1(soa.boundCenter.x));
+    vfloat ry = vSub(y, vSet1(soa.boundCenter.y));
+    vfloat rz = vSub(z, vSet1(soa.boundCenter.z));
+    vfloat d = vSqrt(vFma(rx, rx, vFma(ry, ry, vMul(rz, rz))));
+    vfloat s = vSub(d, vSet1(soa.boundRadius));
+    vfloat vr = vDiv(vFma(rx, vx, vFma(ry, vy, vMul(rz, vz))), d);
+
+    // 축별 탈출 시간 (200 - sign(v) * p) / |v|, 속도 0인 축은 아주 큰 값
+    const vfloat limit = vSet1(200.0f);
+    const vfloat tiny = vSet1(1e-20f);
+    vfloat avx = vMax(vAbs(vx), tiny), avy = vMax(vAbs(vy), tiny), avz = vMax(vAbs(vz), tiny);
+    vfloat tx = vDiv(vSub(limit, vDiv(vMul(x, vx), avx)), avx);
+    vfloat ty = vDiv(vSub(limit, vDiv(vMul(y, vy), avy)), avy);
+    vfloat tz = vDiv(vSub(limit, vDiv(vMul(z, vz), avz)), avz);
+    vfloat T = vMax(vMin(tx, vMin(ty, tz)), zero);
+
+    vfloat bound = vDiv(vMul(vSet1(5.0f * soa.totalMass), vMul(T, T)), vMul(s, vFma(vSet1(2.0f), s, vMul(vr, T))));
+    vmask ok = vAnd(vAnd(vGreater(s, zero), vGreater(vr, zero)), vLess(bound, vSet1(tolerance)));
+    ok = vAnd(ok, active);
+
+    vfloat t = vAdd(T, vSet1(ESCAPE_OVERSHOOT));
+    x = vSelect(ok, vFma(vx, t, x), x);
+    y = vSelect(ok, vFma(vy, t, y), y);
+    z = vSelect(ok, vFma(vz, t, z), z);
+    return ok;
+}
+
+// lane 묶음을 한 스텝 진행 (simulateRayBatch와 웨이브프런트 엔진이 같이 씀)
+// 충돌하거나 박스를 벗어난 lane은 active에서 빠지고 그 자리에 위치/속도가 고정됨
+static inline void vStepLanes(const BodySoA& soa, float dt, vfloat& x, vfloat& y, vfloat& z,
+    vfloat& vx, vfloat& vy, vfloat& vz, vmask& active) {
+    const vfloat boxLimit = vSet1(200.0f);
+    const vfloat nearDist = vSet1(500.0f);
+    const vfloat farDist = vSet1(2000.0f);
+
+    vfloat ax = vSet1(0.0f), ay = vSet1(0.0f), az = vSet1(0.0f);
+    vfloat minDistSq = vSet1(1e9f);
+    vmask crashed = vMaskFromBits(0);
+
+    for (int b = 0; b < soa.count; b++) {
+        vfloat dx = vSub(vSet1(soa.x[b]), x);
+        vfloat dy = vSub(vSet1(soa.y[b]), y);
+        vfloat dz = vSub(vSet1(soa.z[b]), z);
+        vfloat distSq = vFma(dx, dx, vFma(dy, dy, vMul(dz, dz)));
+
+        crashed = vOr(crashed, vLess(distSq, vSet1(soa.radiusSq[b])));
+        minDistSq = vMin(minDistSq, distSq);
+
+        // a = M * dir / r^3 (* 5.0f 중력 과장 계수는 스칼라 버전과 동일)
+        vfloat invDist = vRsqrtNewton(distSq);
+        vfloat s = vMul(vSet1(soa.mass[b] * 5.0f), vMul(invDist, vMul(invDist, invDist)));
+        ax = vFma(dx, s, ax);
+        ay = vFma(dy, s, ay);
+        az = vFma(dz, s, az);
+    }
+
+    // 충돌한 lane은 이번 스텝 위치 그대로 종료
+    active = vAndNot(active, crashed);
+
+    // 가변 dt (스칼라 버전과 같은 규칙: 500 초과 x2, 2000 초과 추가로 x4)
+    vfloat currentDt = vSet1(dt);
+    currentDt = vSelect(vGreater(minDistSq, nearDist), vMul(currentDt, vSet1(2.0f)), currentDt);
+    currentDt = vSelect(vGreater(minDistSq, farDist), vMul(currentDt, vSet1(4.0f)), currentDt);
+
+    // 꺼진 lane은 위치/속도를 고정
+    vfloat nvx = vFma(ax, currentDt, vx);
+    vfloat nvy = vFma(ay, currentDt, vy);
+    vfloat nvz = vFma(az, currentDt, vz);
+    vx = vSelect(active, nvx, vx);
+    vy = vSelect(active, nvy, vy);
+    vz = vSelect(active, nvz, vz);
+    x = vSelect(active, vFma(vx, currentDt, x), x);
+    y = vSelect(active, vFma(vy, currentDt, y), y);
+    z = vSelect(active, vFma(vz, currentDt, z), z);
+
+    // 경계 체크: 박스를 벗어난 lane은 벗어난 위치에서 종료
+    vmask outside = vOr(vGreater(vAbs(x), boxLimit), vOr(vGreater(vAbs(y), boxLimit), vGreater(vAbs(z), boxLimit)));
+    active = vAndNot(active, outside);
+}
+
+long long simulateRayBatch(const BodySoA& soa, glm::vec3 startPos,
+    const std::vector<glm::vec3>& initialVelocities, int numRays,
+    int maxSteps, float dt, float escapeTolerance,
+    RayPathWriter& paths, long long& escapes) {
+    const int W = RAY_BATCH_LANES;
+    const int numBatches = (numRays + W - 1) / W;
+    const int maxPoints = paths.maxPointsPerRay;
+    RayPathArena& arena = *paths.arena;
+
+    std::atomic<long long> totalSteps(0), totalEscapes(0);
+    bool retry = false;
+    do {
+        // 묶음 하나가 작업 하나 (묶음마다 스텝 수가 크게 달라서 작업 훔치기로 나눔)
+        parallelFor(numBatches, 1, [&](int batch, int) {
+            const int first = batch * W;
+            const int lanes = std::min(W, numRays - first);
+            long long batchSteps = 0, batchEscapes = 0;
+            // 묶음 단위로 미뤄지므로 첫 광선만 보면 됨
+            if (retry && arena.count[first] >= 0) return;
+
+            // lane마다 최악의 경우 크기만큼 자리를 잡고 (lane l은 base + l * maxPoints), 끝나면 앞으로 당겨 붙임
+            const int base = claimRayPath(paths, lanes * maxPoints);
+            if (base < 0) {
+                for (int l = 0; l < lanes; l++) deferRayPath(paths, first + l);
+                return;
+            }
+            glm::vec3* out = arena.points.data() + base;
+            int laneCount[RAY_BATCH_LANES] = { 0 };
+
+            alignas(64) float px[RAY_BATCH_LANES], py[RAY_BATCH_LANES], pz[RAY_BATCH_LANES];
+            alignas(64) float vx0[RAY_BATCH_LANES], vy0[RAY_BATCH_LANES], vz0[RAY_BATCH_LANES];
+            for (int l = 0; l < W; l++) {
+                // 남는 lane은 시작점 그대로 두고 처음부터 꺼둠
+                const glm::vec3 v = (l < lanes) ? initialVelocities[first + l] : glm::vec3(0.0f);
+                px[l] = startPos.x; py[l] = startPos.y; pz[l] = startPos.z;
+                vx0[l] = v.x; vy0[l] = v.y; vz0[l] = v.z;
+
+                if (l < lanes) out[l * maxPoints + laneCount[l]++] = startPos;
+            }
+
+            vfloat x = vLoad(px), y = vLoad(py), z = vLoad(pz);
+            vfloat vx = vLoad(vx0), vy = vLoad(vy0), vz = vLoad(vz0);
+            vmask active = vMaskFromBits((1u << lanes) - 1u);
+
+            for (int step = 0; step < maxSteps && vBits(active) != 0; step++) {
+                batchSteps += popCount(vBits(active));
+                vStepLanes(soa, dt, x, y, z, vx, vy, vz, active);
+
+                // 10 스텝마다 살아있는 lane만 경로 저장
+                if (step % 10 == 0) {
+                    unsigned bits = vBits(active);
+                    if (bits != 0) {
+                        vStore(px, x); vStore(py, y); vStore(pz, z);
+                        for (int l = 0; l < lanes; l++) {
+                            if (bits & (1u << l)) out[l * maxPoints + laneCount[l]++] = glm::vec3(px[l], py[l], pz[l]);
+                        }
+                    }
+                }
+
+                // 8 스텝마다 해석적 탈출 검사
+                if (escapeTolerance > 0.0f && (step & 7) == 7 && vBits(active) != 0) {
+                    vmask escaped = vTryAnalyticEscape(soa, x, y, z, vx, vy, vz, active, escapeTolerance);
+                    unsigned bits = vBits(escaped);
+                    if (bits != 0) {
+                        active = vAndNot(active, escaped);
+                        batchEscapes += popCount(bits);
+                    }
+                }
+            }
+
+            // 마지막 위치 저장 (종료된 lane은 종료 시점 위치가 고정되어 있음)
+            vStore(px, x); vStore(py, y); vStore(pz, z);
+            int packed = 0;
+            for (int l = 0; l < lanes; l++) {
+                glm::vec3* lane = out + l * maxPoints;
+                lane[laneCount[l]++] = glm::vec3(px[l], py[l], pz[l]);
+                // 앞쪽 lane이 다 안 채운 만큼 당김 (목적지가 항상 앞이라 순방향 복사로 충분)
+                if (packed != l * maxPoints) std::copy(lane, lane + laneCount[l], out + packed);
+                arena.first[first + l] = base + packed;
+                arena.count[first + l] = laneCount[l];
+                packed += laneCount[l];
+            }
+            commitRayPath(paths, first + lanes - 1, base + packed - laneCount[lanes - 1], laneCount[lanes - 1]);
+            totalSteps += batchSteps;
+            totalEscapes += batchEscapes;
+        });
+        retry = true;
+    } while (finishRayPaths(paths));
+    escapes = totalEscapes;
+    return totalSteps;
+}
+
+// --- 웨이브프런트 엔진 ---
+
+// 살아있는 광선 상태 (SoA, 길이는 lane 폭의 배수로 올리고 남는 칸은 꺼진 lane)
+// 압축할 때 다른 쪽 배열로 옮기고 맞바꿈 (프레임 사이 용량 유지)
+struct WavefrontLanes {
+    std::vector<float> storage[7]; // x, y, z, vx, vy, vz, alive (정렬 여유 포함)
+    float* x = nullptr;
+    float* y = nullptr;
+    float* z = nullptr;
+    float* vx = nullptr;
+    float* vy = nullptr;
+    float* vz = nullptr;
+    float* alive = nullptr;   // 1이면 진행 중
+    std::vector<int> ray;     // lane j가 맡은 광선 번호
+    int capacity = 0;
+};
+
+static WavefrontLanes wavefrontLanes[2];
+static std::vector<int> compactIndex;          // 압축 후 자리 (-1이면 이번 구간에서 끝남)
+// 구간 기록: 구간마다 살아있던 lane j가 segmentPoints에 WAVEFRONT_SEGMENT_POINTS칸씩 가짐
+static std::vector<glm::vec3> segmentPoints;
+static std::vector<int> segmentRay, segmentCount, segmentSource, segmentOffset;
+static std::vector<int> rayPointCount;
+
+// 구간 하나에서 광선 하나가 남기는 점 수 상한 (10 스텝마다 저장 + 끝난 위치)
+static const int WAVEFRONT_SEGMENT_POINTS = WAVEFRONT_COMPACT_STEPS / 10 + 1;
+
+// vector 안에서 lane 폭에 맞춘 시작 주소 (용량이 충분하면 재할당 없음)
+static float* alignedLanes(std::vector<float>& buffer, size_t count) {
+    buffer.resize(count + RAY_BATCH_LANES);
+    const uintptr_t align = RAY_BATCH_LANES * sizeof(float);
+    return (float*)(((uintptr_t)buffer.data() + align - 1) & ~(align - 1));
+}
+
+static void reserveLanes(WavefrontLanes& s, int live, glm::vec3 startPos) {
+    const int W = RAY_BATCH_LANES;
+    s.capacity = (live + W - 1) / W * W;
+    float** fields[7] = { &s.x, &s.y, &s.z, &s.vx, &s.vy, &s.vz, &s.alive };
+    for (int f = 0; f < 7; f++) *fields[f] = alignedLanes(s.storage[f], s.capacity);
+    s.ray.resize(s.capacity);
+
+    // 남는 lane은 묶음 엔진처럼 시작점에 멈춘 채로 둠
+    for (int j = live; j < s.capacity; j++) {
+        s.x[j] = startPos.x; s.y[j] = startPos.y; s.z[j] = startPos.z;
+        s.vx[j] = s.vy[j] = s.vz[j] = 0.0f;
+        s.alive[j] = 0.0f;
+        s.ray[j] = -1;
+    }
+}
+
+// lane o부터 한 묶음을 [stepBegin, stepEnd) 스텝 진행하고 상태를 배열에 되돌려 씀
+// 경로 점은 이번 구간 기록(segment, counts)의 lane 자리에 저장
+static void advanceWavefrontLanes(const BodySoA& soa, WavefrontLanes& s, int o, int stepBegin, int stepEnd,
+    float dt, float escapeTolerance, glm::vec3* segment, int* counts,
+    long long& steps, long long& escapes) {
+    const int W = RAY_BATCH_LANES;
+    vfloat x = vLoad(s.x + o), y = vLoad(s.y + o), z = vLoad(s.z + o);
+    vfloat vx = vLoad(s.vx + o), vy = vLoad(s.vy + o), vz = vLoad(s.vz + o);
+    vmask active = vGreater(vLoad(s.alive + o), vSet1(0.0f));
+    alignas(64) float px[RAY_BATCH_LANES], py[RAY_BATCH_LANES], pz[RAY_BATCH_LANES];
+
+    for (int step = stepBegin; step < stepEnd && vBits(active) != 0; step++) {
+        steps += popCount(vBits(active));
+        vStepLanes(soa, dt, x, y, z, vx, vy, vz, active);
+
+        // 묶음 엔진과 같은 전역 스텝 번호로 저장 / 탈출 검사
+        if (step % 10 == 0) {
+            unsigned bits = vBits(active);
+            if (bits != 0) {
+                vStore(px, x); vStore(py, y); vStore(pz, z);
+                for (int l = 0; l < W; l++) {
+                    if (bits & (1u << l)) {
+                        const int j = o + l;
+                        segment[(size_t)j * WAVEFRONT_SEGMENT_POINTS + counts[j]++] = glm::vec3(px[l], py[l], pz[l]);
+                    }
+                }
+            }
+        }
+
+        if (escapeTolerance > 0.0f && (step & 7) == 7 && vBits(active) != 0) {
+            vmask escaped = vTryAnalyticEscape(soa, x, y, z, vx, vy, vz, active, escapeTolerance);
+            unsigned bits = vBits(escaped);
+            if (bits != 0) {
+                active = vAndNot(active, escaped);
+                escapes += popCount(bits);
+            }
+        }
+    }
+
+    vStore(s.x + o, x); vStore(s.y + o, y); vStore(s.z + o, z);
+    vStore(s.vx + o, vx); vStore(s.vy + o, vy); vStore(s.vz + o, vz);
+    vStore(s.alive + o, vSelect(active, vSet1(1.0f), vSet1(0.0f)));
+}
+
+long long simulateRayWavefront(const BodySoA& soa, glm::vec3 startPos,
+    const std::vector<glm::vec3>& initialVelocities, int numRays,
+    int maxSteps, float dt, float escapeTolerance,
+    RayPathWriter& paths, long long& escapes) {
+    const int SEG = WAVEFRONT_SEGMENT_POINTS;
+
+    WavefrontLanes* cur = &wavefrontLanes[0];
+    WavefrontLanes* next = &wavefrontLanes[1];
+    int live = numRays;
+    reserveLanes(*cur, live, startPos);
+    for (int j = 0; j < live; j++) {
+        const glm::vec3 v = initialVelocities[j];
+        cur->x[j] = startPos.x; cur->y[j] = startPos.y; cur->z[j] = startPos.z;
+        cur->vx[j] = v.x; cur->vy[j] = v.y; cur->vz[j] = v.z;
+        cur->alive[j] = 1.0f;
+        cur->ray[j] = j;
+    }
+    segmentPoints.clear();
+    segmentRay.clear();
+    segmentCount.clear();
+    segmentSource.clear();
+
+    std::atomic<long long> totalSteps(0), totalEscapes(0);
+    for (int stepBegin = 0; live > 0; stepBegin += WAVEFRONT_COMPACT_STEPS) {
+        const int stepEnd = std::min(stepBegin + WAVEFRONT_COMPACT_STEPS, maxSteps);
+        const bool last = stepEnd >= maxSteps;
+        const int cap = cur->capacity;
+
+        // 이번 구간 기록 자리 (살아있는 광선 수만큼)
+        const int roundSegment = (int)segmentRay.size();
+        const int roundPoints = (int)segmentPoints.size();
+        segmentRay.resize(roundSegment + live);
+        segmentCount.resize(roundSegment + live);
+        segmentSource.resize(roundSegment + live);
+        segmentPoints.resize((size_t)roundPoints + (size_t)live * SEG);
+        glm::vec3* segment = segmentPoints.data() + roundPoints;
+        int* counts = segmentCount.data() + roundSegment;
+        std::fill(counts, counts + live, 0);
+
+        // 고정 크기 조각 하나가 작업 하나 (살아있는 광선이 앞에 모여 있으므로 마지막 조각 빼고 lane이 다 참)
+        // 조각이 하나만 남으면 풀을 깨우지 않고 바로 실행
+        parallelFor(cap, WAVEFRONT_CHUNK_RAYS, [&](int begin, int end) {
+            long long chunkSteps = 0, chunkEscapes = 0;
+            for (int o = begin; o < end; o += RAY_BATCH_LANES) {
+                advanceWavefrontLanes(soa, *cur, o, stepBegin, stepEnd, dt, escapeTolerance,
+                    segment, counts, chunkSteps, chunkEscapes);
+            }
+            totalSteps += chunkSteps;
+            totalEscapes += chunkEscapes;
+        });
+
+        // 압축: 끝난 광선(충돌 / 탈출 / 박스 밖 / 스텝 예산 소진)은 마지막 위치를 기록하고 빼고 나머지는 앞으로 당김
+        int survivors = 0;
+        compactIndex.resize(live);
+        for (int j = 0; j < live; j++) {
+            segmentRay[roundSegment + j] = cur->ray[j];
+            segmentSource[roundSegment + j] = roundPoints + j * SEG;
+            compactIndex[j] = (!last && cur->alive[j] > 0.0f) ? survivors++ : -1;
+        }
+        reserveLanes(*next, survivors, startPos);
+        parallelFor(live, WAVEFRONT_CHUNK_RAYS, [&](int begin, int end) {
+            for (int j = begin; j < end; j++) {
+                const int d = compactIndex[j];
+                if (d < 0) {
+                    segment[(size_t)j * SEG + counts[j]++] = glm::vec3(cur->x[j], cur->y[j], cur->z[j]);
+                    continue;
+                }
+                next->x[d] = cur->x[j]; next->y[d] = cur->y[j]; next->z[d] = cur->z[j];
+                next->vx[d] = cur->vx[j]; next->vy[d] = cur->vy[j]; next->vz[d] = cur->vz[j];
+                next->alive[d] = 1.0f;
+                next->ray[d] = cur->ray[j];
+            }
+        });
+        std::swap(cur, next);
+        live = survivors;
+    }
+
+    // 광선별 점 개수 (시작점 + 구간별 기록), 구간은 시간 순서로 쌓였으므로 앞에서부터 이어 붙임
+    const int segments = (int)segmentRay.size();
+    segmentOffset.resize(segments);
+    rayPointCount.assign(numRays, 1);
+    for (int k = 0; k < segments; k++) {
+        const int ray = segmentRay[k];
+        segmentOffset[k] = rayPointCount[ray];
+        rayPointCount[ray] += segmentCount[k];
+    }
+
+    // 조각 단위로 아레나 자리를 잡음 (모자라면 용량을 늘리고 미뤄진 조각만 다시 잡음, 적분은 다시 하지 않음)
+    RayPathArena& arena = *paths.arena;
+    bool retry = false;
+    do {
+        parallelFor(numRays, WAVEFRONT_CHUNK_RAYS, [&](int first, int end) {
+            if (retry && arena.count[first] >= 0) return;
+
+            int total = 0;
+            for (int i = first; i < end; i++) total += rayPointCount[i];
+            const int base = claimRayPath(paths, total);
+            if (base < 0) {
+                for (int i = first; i < end; i++) deferRayPath(paths, i);
+                return;
+            }
+            int offset = base;
+            for (int i = first; i < end; i++) {
+                arena.first[i] = offset;
+                arena.count[i] = rayPointCount[i];
+                offset += rayPointCount[i];
+            }
+            commitRayPath(paths, end - 1, arena.first[end - 1], arena.count[end - 1]);
+        });
+        retry = true;
+    } while (finishRayPaths(paths));
+
+    glm::vec3* out = arena.points.data();
+    parallelFor(numRays, WAVEFRONT_CHUNK_RAYS, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) out[arena.first[i]] = startPos;
+    });
+    parallelFor(segments, 256, [&](int begin, int end) {
+        for (int k = begin; k < end; k++) {
+            const glm::vec3* src = segmentPoints.data() + segmentSource[k];
+            std::copy(src, src + segmentCount[k], out + arena.first[segmentRay[k]] + segmentOffset[k]);
+        }
+    });
+
+    escapes = totalEscapes;
+    return totalSteps;
+}
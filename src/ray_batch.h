@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "ray_path_arena.h"
+
+// --- SoA 광선 배치 엔진 ---
+// 광선 8개(AVX2) 또는 16개(AVX-512)를 한 묶음(lane)으로 묶어서 동시에 적분함
+// 천체 정보도 포인터를 따라가지 않도록 배열(SoA)로 펼쳐서 넘겨줌
+
+#if defined(__AVX512F__)
+#define RAY_BATCH_LANES 16
+#else
+#define RAY_BATCH_LANES 8 // AVX2 또는 스칼라 폴백(컴파일러 자동 벡터화)
+#endif
+
+// 천체 정보를 성분별 배열로 저장 (Body* 포인터 추적 방지)
+struct BodySoA {
+    std::vector<float> x, y, z;
+    std::vector<float> mass;
+    std::vector<float> radiusSq; // 충돌 판정용 반지름 제곱
+    int count = 0;
+
+    // 탈출 판정용 경계 구 (computeBodyBounds에서 계산)
+    glm::vec3 boundCenter = glm::vec3(0.0f); // 천체 중심들의 중점
+    float boundRadius = 0.0f; // boundCenter에서 가장 먼 천체 중심까지 거리
+    float totalMass = 0.0f;
+};
+
+// x/y/z/mass가 채워진 뒤 경계 구와 총 질량을 계산
+void computeBodyBounds(BodySoA& soa);
+
+// --- 해석적 탈출 ---
+// 광선이 모든 천체에서 멀어지는 중이고, 앞으로 받을 중력에 의한 궤적 변위가
+// tolerance(월드 단위) 이하로 보장되면 박스 경계까지 직선으로 한 번에 보냄
+// 성공하면 pos를 박스 탈출 지점으로 옮기고 true
+bool tryAnalyticEscape(const BodySoA& soa, glm::vec3& pos, const glm::vec3& vel, float tolerance);
+
+// 현재 빌드에서 사용하는 SIMD 종류 ("AVX-512", "AVX2", "Scalar")
+const char* rayBatchInstructionSet();
+
+// initialVelocities[0..numRays) 광선을 묶음 단위로 적분하여 paths(beginRayPaths 호출 후)에 기록
+// 아레나가 모자라면 용량을 늘리고 미뤄진 묶음만 다시 적분한 뒤 finishRayPaths까지 마침
+// 결과는 기존 simulateRay(스칼라 오일러)와 같은 규칙으로 경로를 저장함
+// escapeTolerance > 0이면 8 스텝마다 해석적 탈출을 시도
+// 반환값: 모든 광선이 진행한 스텝 수 합, escapes: 해석적으로 끝낸 광선 수
+long long simulateRayBatch(const BodySoA& soa, glm::vec3 startPos,
+    const std::vector<glm::vec3>& initialVelocities, int numRays,
+    int maxSteps, float dt, float escapeTolerance,
+    RayPathWriter& paths, long long& escapes);
+
+// --- 웨이브프런트 엔진 ---
+// 묶음 엔진은 묶음 안 광선이 하나라도 살아있으면 끝날 때까지 그 묶음을 돌리므로 일찍 끝난 lane이 놀게 됨
+// 웨이브프런트는 살아있는 광선 전체를 SoA 배열 하나에 모아 WAVEFRONT_COMPACT_STEPS 스텝씩 같이 진행하고
+// 그 사이 끝난 광선을 빼서 앞으로 당김 (다음 구간은 살아있는 광선만으로 lane이 꽉 참)
+// 스레드는 WAVEFRONT_CHUNK_RAYS 광선 단위 조각을 나눠 가짐
+// 스텝 계산은 묶음 엔진과 같은 함수라 결과(경로, 스텝 수)가 비트 단위로 같음
+const int WAVEFRONT_COMPACT_STEPS = 40; // 10의 배수 (경로를 10 스텝마다 저장하므로 구간당 저장 횟수가 고정)
+const int WAVEFRONT_CHUNK_RAYS = 64;    // RAY_BATCH_LANES의 배수
+
+// simulateRayBatch와 같은 인자 / 결과
+long long simulateRayWavefront(const BodySoA& soa, glm::vec3 startPos,
+    const std::vector<glm::vec3>& initialVelocities, int numRays,
+    int maxSteps, float dt, float escapeTolerance,
+    RayPathWriter& paths, long long& escapes);
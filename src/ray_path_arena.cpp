@@ -0,0 +1,76 @@
+﻿#include "ray_path_arena.h"
+#include <algorithm>
+#include "task_pool.h"
+
+void beginRayPaths(RayPathWriter& writer, RayPathArena& arena, int numRays, int maxPointsPerRay) {
+    writer.arena = &arena;
+    writer.maxPointsPerRay = maxPointsPerRay;
+    writer.top.store(0, std::memory_order_relaxed);
+    writer.deferred = 0;
+
+    // 크기가 같으면 재할당 없음 (스레드 수가 바뀔 때만 regions가 커짐)
+    int threads = taskPoolThreads();
+    writer.regions.assign(threads, RayPathRegion());
+
+    arena.numPaths = numRays;
+    arena.used = 0;
+    arena.first.resize(numRays);
+    arena.count.assign(numRays, 0);
+
+    // 첫 프레임 용량 추정: 광선당 64점 + 스레드별 구역 하나 (모자라면 finishRayPaths에서 늘어남)
+    size_t chunk = (size_t)std::max(RAY_PATH_CHUNK_POINTS, maxPointsPerRay);
+    size_t minCapacity = (size_t)numRays * std::min(maxPointsPerRay, 64) + (size_t)threads * chunk;
+    if (arena.points.size() < minCapacity) arena.points.resize(minCapacity);
+}
+
+int claimRayPath(RayPathWriter& writer, int points) {
+    RayPathRegion& region = writer.regions[taskSlot()];
+    if (region.end - region.cursor < points) {
+        // 남은 구역이 모자라면 새 구역을 받음 (이전 구역의 남은 부분은 빈칸으로 남음)
+        int size = std::max(RAY_PATH_CHUNK_POINTS, points);
+        int start = writer.top.fetch_add(size, std::memory_order_relaxed);
+        if ((size_t)start + size > writer.arena->points.size()) return -1;
+        region.cursor = start;
+        region.end = start + size;
+    }
+    return region.cursor;
+}
+
+void commitRayPath(RayPathWriter& writer, int ray, int offset, int count) {
+    writer.arena->first[ray] = offset;
+    writer.arena->count[ray] = count;
+    writer.regions[taskSlot()].cursor = offset + count;
+}
+
+void deferRayPath(RayPathWriter& writer, int ray) {
+    writer.arena->first[ray] = 0;
+    writer.arena->count[ray] = -1;
+}
+
+bool finishRayPaths(RayPathWriter& writer) {
+    RayPathArena& arena = *writer.arena;
+    int capacity = (int)arena.points.size();
+
+    int deferred = 0;
+    for (int i = 0; i < arena.numPaths; i++) {
+        if (arena.count[i] < 0) deferred++;
+    }
+    writer.deferred = deferred;
+    if (deferred == 0) {
+        // 가장 위쪽 구역은 어떤 스레드의 현재 구역이므로 그 커서가 실제로 쓴 끝 (구역 남은 부분은 올리지 않음)
+        int used = 0;
+        for (const auto& region : writer.regions) used = std::max(used, region.cursor);
+        arena.used = std::min(used, capacity);
+        return false;
+    }
+
+    // 실패한 요청 이후로는 모든 요청이 실패하므로 기존 용량 아래쪽은 전부 사용 중으로 보고 그 뒤부터 이어서 씀
+    // 미뤄진 광선이 최악의 경우에도 들어가도록 늘림 (이후 프레임은 늘어난 용량을 재사용)
+    int threads = (int)writer.regions.size();
+    size_t chunk = (size_t)std::max(RAY_PATH_CHUNK_POINTS, writer.maxPointsPerRay);
+    size_t needed = (size_t)capacity + (size_t)deferred * writer.maxPointsPerRay + (size_t)threads * chunk;
+    arena.points.resize(std::max(needed, (size_t)capacity + capacity / 2));
+    writer.top.store(capacity, std::memory_order_relaxed);
+    for (auto& region : writer.regions) region = RayPathRegion();
+    return true;
+}
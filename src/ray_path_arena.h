@@ -0,0 +1,65 @@
+﻿#pragma once
+#include <atomic>
+#include <vector>
+#include <glm/glm.hpp>
+
+// --- 광선 경로 아레나 ---
+// 모든 광선의 경로 점을 연속된 배열 하나에 저장하고 광선별 (시작, 개수) 표로 구분함
+// 광선마다 vector를 따로 두지 않으므로 프레임마다 힙 할당이 없고 (용량은 프레임 사이에 유지)
+// points[0, used)를 그대로 GPU 버퍼에 올린 뒤 first/count로 glMultiDrawArrays 호출 가능
+// 스레드 구역 사이에는 빈칸이 있을 수 있음 (그리기는 first/count만 보므로 상관없음)
+
+// 광선 하나의 경로 (아레나 안을 가리키는 읽기 전용 구간)
+struct RayPathView {
+    const glm::vec3* data;
+    int count;
+
+    const glm::vec3* begin() const { return data; }
+    const glm::vec3* end() const { return data + count; }
+    size_t size() const { return (size_t)count; }
+    const glm::vec3& operator[](size_t i) const { return data[i]; }
+    const glm::vec3& back() const { return data[count - 1]; }
+};
+
+struct RayPathArena {
+    std::vector<glm::vec3> points; // 모든 광선 경로 (크기 = 용량, 실제로 쓴 범위는 used까지)
+    std::vector<int> first;        // 광선별 시작 인덱스 (GLint)
+    std::vector<int> count;        // 광선별 점 개수 (GLsizei), 기록 중 -1은 공간 부족으로 미뤄진 광선
+    int numPaths = 0;
+    int used = 0;                  // 업로드가 필요한 points 범위 끝
+
+    RayPathView path(int ray) const { return { points.data() + first[ray], count[ray] }; }
+};
+
+// 스레드 하나가 쓰는 구역 (다른 스레드와 캐시 라인을 공유하지 않도록 정렬)
+struct alignas(64) RayPathRegion {
+    int cursor = 0; // 다음 경로를 쓸 위치
+    int end = 0;    // 구역 끝
+};
+
+// 스레드별 구역을 한 번에 받아가는 단위 (점 개수)
+const int RAY_PATH_CHUNK_POINTS = 16384;
+
+// simulateRay 한 번 동안 아레나에 경로를 나눠 쓰는 상태
+// 각 스레드는 자기 구역 안에서 커서만 증가시키고, 구역이 모자랄 때만 top을 원자적으로 늘림
+// 용량이 모자라면 광선을 미뤄두었다가 (count = -1) 용량을 늘린 뒤 그 광선만 다시 적분함
+struct RayPathWriter {
+    RayPathArena* arena = nullptr;
+    int maxPointsPerRay = 0;
+    std::atomic<int> top{ 0 };
+    std::vector<RayPathRegion> regions; // 작업 풀 슬롯별 (taskSlot)
+    int deferred = 0;                   // 마지막 finishRayPaths에서 센 미뤄진 광선 수
+};
+
+// numRays개 광선을 쓸 준비 (maxPointsPerRay: 광선 하나가 남길 수 있는 최대 점 수)
+void beginRayPaths(RayPathWriter& writer, RayPathArena& arena, int numRays, int maxPointsPerRay);
+
+// 현재 스레드 구역에서 points개를 쓸 자리를 잡음 (공간 부족이면 -1)
+// 같은 스레드에서 commitRayPath로 실제 사용한 개수를 알려줘야 다음 광선이 이어서 씀
+int claimRayPath(RayPathWriter& writer, int points);
+void commitRayPath(RayPathWriter& writer, int ray, int offset, int count);
+// 자리를 못 잡은 광선 표시 (다음 패스에서 다시 적분)
+void deferRayPath(RayPathWriter& writer, int ray);
+
+// 쓴 범위를 정리하고, 미뤄진 광선이 있으면 용량을 늘린 뒤 true (호출한 쪽이 그 광선만 다시 적분)
+bool finishRayPaths(RayPathWriter& writer);
@@ -0,0 +1,288 @@
+﻿#include "ray_phase_cache.h"
+#include "simulation.h"
+#include "frame_profiler.h"
+#include "nbody.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+bool useRayPhaseCache = false;
+
+// 위상 하나의 경로 (RayPathArena에서 쓴 범위만 빈칸 없이 복사)
+struct RayPhaseSlot {
+    bool filled = false;
+    RayPathArena paths;
+    std::vector<float> drift; // 질량 편집 뒤 다시 적분하지 않고 둔 광선들의 끝점 변위 추정 (편집 전에는 비어 있음)
+    int edits = 0;            // massEdits 중 반영한 개수 (적으면 재생 전에 민감한 광선을 다시 적분)
+    size_t bytes = 0;
+};
+
+// 경로 모양을 바꾸는 설정 (하나라도 다르면 저장된 경로를 쓸 수 없음)
+struct RayPhaseKey {
+    int numRays;
+    int maxSteps;
+    int rayIntegrator;
+    bool useSimdRays;
+    bool useOctree;
+    bool useAccelField;
+    float escapeTolerance;
+    float octreeTheta;
+    float rk45Tolerance;
+    float dt;
+    float lightSpeed;
+    int bodyCount;
+    glm::vec3 startPos;
+};
+
+static std::vector<RayPhaseSlot> slots;
+static RayPhaseKey cachedKey;
+static bool keyValid = false;
+static double period = 0.0;
+static int filledSlots = 0;
+static int pendingSlots = 0; // 채웠지만 아직 반영하지 않은 질량 편집이 있는 위상 수
+static size_t cacheBytes = 0;
+// 캐시를 채운 뒤의 질량 편집 (천체, 질량 변화), 위상마다 재생하거나 미리 채울 때 몰아서 반영
+static std::vector<std::pair<int, float>> massEdits;
+static RayInfluence slotInfluence;
+static std::vector<int> editRays, staleRays, mergedRays;
+static bool lastHit = false;
+
+static RayPhaseKey currentKey(glm::vec3 startPos) {
+    RayPhaseKey k;
+    k.numRays = numRays;
+    k.maxSteps = maxSteps;
+    k.rayIntegrator = rayIntegrator;
+    k.useSimdRays = useSimdRays;
+    k.useOctree = useOctree;
+    k.useAccelField = useAccelField;
+    k.escapeTolerance = escapeTolerance;
+    k.octreeTheta = octreeTheta;
+    k.rk45Tolerance = rk45Tolerance;
+    k.dt = dt;
+    k.lightSpeed = lightSpeed;
+    k.bodyCount = bodies.count;
+    k.startPos = startPos;
+    return k;
+}
+
+static bool sameKey(const RayPhaseKey& a, const RayPhaseKey& b) {
+    return a.numRays == b.numRays && a.maxSteps == b.maxSteps && a.rayIntegrator == b.rayIntegrator &&
+        a.useSimdRays == b.useSimdRays && a.useOctree == b.useOctree && a.useAccelField == b.useAccelField &&
+        a.escapeTolerance == b.escapeTolerance && a.octreeTheta == b.octreeTheta && a.rk45Tolerance == b.rk45Tolerance &&
+        a.dt == b.dt && a.lightSpeed == b.lightSpeed && a.bodyCount == b.bodyCount && a.startPos == b.startPos;
+}
+
+static long long gcd(long long a, long long b) {
+    while (b != 0) {
+        long long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+double computeOrbitalPeriod() {
+    // 각속도(updateBodyPhysics의 orbitSpeed * 0.5)를 1/1000 단위 정수로 맞춰서 최대공약수를 구함
+    // 정수에서 많이 벗어나면 공통 주기가 없다고 봄 (float로 저장된 0.3 같은 값의 오차는 허용)
+    const double scale = 1000.0;
+    long long g = 0;
+    for (int b = 0; b < bodies.count; b++) {
+        if (bodies.orbitRadius[b] == 0.0f) continue; // 제자리 천체
+        double rate = std::fabs((double)bodies.orbitSpeed[b] * 0.5) * scale;
+        double rounded = std::floor(rate + 0.5);
+        if (std::fabs(rate - rounded) > 1e-4 * std::max(1.0, rate)) return 0.0;
+        if (rounded == 0.0) continue;
+        g = gcd(g, (long long)rounded);
+    }
+    if (g == 0) return 0.0; // 움직이는 천체가 없음 (가속도장 모드가 이미 재사용함)
+    double p = 2.0 * 3.14159265358979323846 * scale / (double)g;
+    return (p <= RAY_PHASE_MAX_PERIOD) ? p : 0.0;
+}
+
+static void clearSlots() {
+    std::vector<RayPhaseSlot>().swap(slots);
+    filledSlots = 0;
+    pendingSlots = 0;
+    cacheBytes = 0;
+    massEdits.clear();
+}
+
+void invalidateRayPhaseCache() {
+    clearSlots();
+    keyValid = false;
+}
+
+// 설정이 바뀌었으면 비우고, 캐시를 쓸 수 있는 장면인지 돌려줌
+// N체 모드에서는 배치가 주기로 반복되지 않으므로 꺼진 것과 같음
+static bool prepareCache(glm::vec3 startPos) {
+    if (!useRayPhaseCache || useNBody) {
+        if (keyValid) invalidateRayPhaseCache();
+        return false;
+    }
+    RayPhaseKey key = currentKey(startPos);
+    if (!keyValid || !sameKey(key, cachedKey)) {
+        clearSlots();
+        cachedKey = key;
+        keyValid = true;
+        period = computeOrbitalPeriod();
+    }
+    if (period <= 0.0) return false;
+    if (slots.empty()) slots.resize(RAY_PHASE_SLOTS);
+    return true;
+}
+
+static int phaseSlot(float time) {
+    double phase = std::fmod((double)time, period);
+    if (phase < 0.0) phase += period;
+    int slot = (int)std::floor(phase / period * RAY_PHASE_SLOTS + 0.5);
+    return slot % RAY_PHASE_SLOTS;
+}
+
+static float slotTime(int slot) {
+    return (float)(period * slot / RAY_PHASE_SLOTS);
+}
+
+static void replaySlot(const RayPhaseSlot& s) {
+    // 아레나 용량은 유지되므로 보통 재할당 없이 memcpy 세 번
+    const RayPathArena& src = s.paths;
+    if (rayPaths.points.size() < src.points.size()) rayPaths.points.resize(src.points.size());
+    std::copy(src.points.begin(), src.points.end(), rayPaths.points.begin());
+    rayPaths.first.assign(src.first.begin(), src.first.end());
+    rayPaths.count.assign(src.count.begin(), src.count.end());
+    rayPaths.numPaths = src.numPaths;
+    rayPaths.used = src.used;
+}
+
+// 방금 계산한 rayPaths를 위상에 저장 (예산을 넘으면 false, 이미 채운 위상이면 크기 차이만 셈)
+static bool storeSlot(RayPhaseSlot& s, const std::vector<float>& drift) {
+    size_t bytes = (size_t)rayPaths.used * sizeof(glm::vec3) + (size_t)rayPaths.numPaths * 2 * sizeof(int) +
+        drift.size() * sizeof(float);
+    size_t others = cacheBytes - (s.filled ? s.bytes : 0);
+    if (others + bytes > RAY_PHASE_CACHE_MAX_BYTES) {
+        if (s.filled) {
+            filledSlots--;
+            s = RayPhaseSlot();
+        }
+        cacheBytes = others;
+        return false;
+    }
+    RayPathArena& dst = s.paths;
+    dst.points.assign(rayPaths.points.begin(), rayPaths.points.begin() + rayPaths.used);
+    dst.first.assign(rayPaths.first.begin(), rayPaths.first.begin() + rayPaths.numPaths);
+    dst.count.assign(rayPaths.count.begin(), rayPaths.count.begin() + rayPaths.numPaths);
+    dst.numPaths = rayPaths.numPaths;
+    dst.used = rayPaths.used;
+    s.drift.assign(drift.begin(), drift.end());
+    s.edits = (int)massEdits.size();
+    if (!s.filled) filledSlots++;
+    s.filled = true;
+    s.bytes = bytes;
+    cacheBytes = others + bytes;
+    return true;
+}
+
+// 위상 시각으로 천체를 옮기고 모든 광선을 적분한 뒤 저장 (예산을 넘으면 저장만 건너뜀)
+static void integrateSlot(int slot, glm::vec3 startPos) {
+    updateBodyPhysics(slotTime(slot));
+    simulateRay(startPos, false);
+    storeSlot(slots[slot], std::vector<float>());
+}
+
+// 채운 뒤 들어온 질량 편집을 반영: 위상 시각 배치로 광선별 영향을 다시 재서 민감한 광선만 다시 적분
+// 반영한 결과는 rayPaths에도 들어 있음
+static void refreshSlot(int slot, glm::vec3 startPos) {
+    RayPhaseSlot& s = slots[slot];
+    pendingSlots--;
+    updateBodyPhysics(slotTime(slot));
+    packBodies(bodySoA);
+    recordRayInfluence(bodySoA, s.paths, slotInfluence);
+    if (s.drift.size() == slotInfluence.drift.size()) slotInfluence.drift.assign(s.drift.begin(), s.drift.end());
+
+    staleRays.clear();
+    bool recorded = true;
+    for (size_t e = s.edits; e < massEdits.size() && recorded; e++) {
+        recorded = selectMassEditRays(slotInfluence, massEdits[e].first, massEdits[e].second, editRays);
+        mergedRays.clear();
+        std::set_union(staleRays.begin(), staleRays.end(), editRays.begin(), editRays.end(), std::back_inserter(mergedRays));
+        staleRays.swap(mergedRays);
+    }
+    if (!recorded || (int)staleRays.size() >= s.paths.numPaths) {
+        // 기록이 없거나 (천체가 너무 많음) 모든 광선이 민감하면 골라서 합치는 비용 없이 전체를 다시 적분
+        simulateRay(startPos, false);
+        storeSlot(s, std::vector<float>());
+        return;
+    }
+    if (staleRays.empty()) {
+        replaySlot(s);
+        lastRayStats = RayStats();
+    }
+    else {
+        resimulateRays(startPos, staleRays, s.paths, slotInfluence);
+    }
+    storeSlot(s, slotInfluence.drift);
+}
+
+void simulateRayPhase(float time, glm::vec3 startPos) {
+    lastHit = false;
+    if (!prepareCache(startPos)) {
+        simulateRay(startPos);
+        return;
+    }
+
+    int slot = phaseSlot(time);
+    RayPhaseSlot& s = slots[slot];
+    if (s.filled && s.edits == (int)massEdits.size()) {
+        replaySlot(s);
+        lastRayStats = RayStats();
+        lastHit = true;
+        return;
+    }
+    if (s.filled) refreshSlot(slot, startPos);
+    else integrateSlot(slot, startPos);
+    updateBodyPhysics(time);
+}
+
+int fillRayPhaseCache(float time, glm::vec3 startPos, double budgetMs) {
+    if (budgetMs <= 0.0 || !prepareCache(startPos)) return 0;
+    if (filledSlots >= RAY_PHASE_SLOTS && pendingSlots == 0) return 0;
+    // 채우는 동안 bodies가 위상 시각으로 움직이므로 끝나면 time으로 되돌림
+    double deadline = profileClockMs() + budgetMs;
+    int current = phaseSlot(time);
+    int filled = 0;
+    // 재생 순서대로 다음 위상부터 (질량 편집을 아직 반영하지 않은 위상도 같이 갱신)
+    for (int i = 1; i <= RAY_PHASE_SLOTS; i++) {
+        int slot = (current + i) % RAY_PHASE_SLOTS;
+        RayPhaseSlot& s = slots[slot];
+        if (s.filled && s.edits == (int)massEdits.size()) continue;
+        if (profileClockMs() >= deadline) break;
+        if (s.filled) {
+            refreshSlot(slot, startPos);
+        }
+        else {
+            integrateSlot(slot, startPos);
+            if (!s.filled) break; // 예산 초과
+        }
+        filled++;
+    }
+    updateBodyPhysics(time);
+    return filled;
+}
+
+void applyMassEditToRayPhaseCache(int body, float deltaMass) {
+    if (filledSlots == 0) return;
+    massEdits.push_back(std::make_pair(body, deltaMass));
+    pendingSlots = filledSlots;
+}
+
+RayPhaseCacheStats rayPhaseCacheStats() {
+    RayPhaseCacheStats s;
+    s.active = useRayPhaseCache && keyValid && period > 0.0;
+    s.period = period;
+    s.filled = filledSlots;
+    s.pending = pendingSlots;
+    s.bytes = cacheBytes;
+    s.hit = lastHit;
+    return s;
+}
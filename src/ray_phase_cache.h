@@ -0,0 +1,50 @@
+﻿#pragma once
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// --- 궤도 위상 광선 캐시 ---
+// updateBodyPhysics의 궤도는 시간과 orbitSpeed만으로 정해지는 케플러 궤도(원 / 타원)라 천체 배치 전체가 한 주기마다 반복됨
+// 주기를 RAY_PHASE_SLOTS개 위상으로 나눠 위상별 광선 경로를 저장해두고 같은 위상이 다시 오면 적분 없이 복사
+// 광선은 항상 가장 가까운 위상 시각의 천체 배치로 계산함 (천체는 정확한 시각으로 그림, 어긋남은 위상 간격의 절반 이하)
+// (기본 장면에서 위상 간격은 시뮬레이션 시간 약 0.031 = 1.5스텝이라 광선이 그린 천체보다 최대 약 0.77스텝 앞서거나 뒤짐,
+//  rayPhaseCache 벤치마크의 phaseBodyOffsetMax가 그 사이 천체가 움직이는 최대 거리)
+// 주기 하나를 다 채우면 수백 MB를 쓰므로 기본은 꺼짐 (C키 / useRayPhaseCache로 켬)
+// 캐시를 켜면 시간 분할(rayAmortizeStride)은 쓰지 않음 (위상마다 완전한 경로 집합을 저장해야 하므로)
+// 적분 설정 / 광선 수가 바뀌면 전부 버림
+// 질량이 바뀌면 위상마다 다음 재생(또는 미리 채우기) 때 위상 시각 배치로 광선별 영향을 재서 민감한 광선만 다시 적분 (simulation.h 참고)
+// N체 모드(nbody.h)에서는 쓰지 않음
+// 시뮬레이션 스레드 전용 (bodies / rayPaths를 직접 바꿈)
+
+const int RAY_PHASE_SLOTS = 4096;                        // 기본 장면 주기(약 105초)에서 위상 하나가 약 26ms
+const size_t RAY_PHASE_CACHE_MAX_BYTES = (size_t)256 << 20; // 넘으면 더 채우지 않음 (못 채운 위상은 매번 적분)
+const double RAY_PHASE_MAX_PERIOD = 2000.0;              // 이보다 긴 주기는 캐시하지 않음 (시뮬레이션 시간 단위)
+
+extern bool useRayPhaseCache; // 기본 false
+
+struct RayPhaseCacheStats {
+    bool active = false; // 켜져 있고 주기가 있는 장면인지
+    double period = 0.0;
+    int filled = 0;      // 채운 위상 수 (RAY_PHASE_SLOTS 중)
+    int pending = 0;     // 질량 편집을 아직 반영하지 않은 위상 수
+    size_t bytes = 0;
+    bool hit = false;    // 마지막 simulateRayPhase가 캐시에서 복사했는지
+};
+
+// 공전하는 천체의 각속도가 모두 어떤 기본 각속도의 정수배면 그 주기, 아니면 0
+double computeOrbitalPeriod();
+
+// simulateRay 대신 호출 (bodies는 이미 updateBodyPhysics(time)으로 옮겨둔 상태)
+// 캐시를 쓸 수 없으면 (꺼짐 / 주기 없음) simulateRay와 같음, 쓸 수 있으면 위상 경로를 복사하거나 적분해서 저장
+void simulateRayPhase(float time, glm::vec3 startPos);
+
+// time 다음 위상부터 아직 없는 위상을 budgetMs 동안 미리 채움 (세대 사이 남는 시간에 호출), 채운 위상 수
+// rayPaths는 덮어씀 (렌더 스레드에 넘긴 뒤에 호출)
+int fillRayPhaseCache(float time, glm::vec3 startPos, double budgetMs);
+
+// 설정 변경은 다음 호출에서 알아서 확인하므로 캐시를 통째로 버려야 할 때만
+void invalidateRayPhaseCache();
+
+// body의 질량이 deltaMass만큼 바뀐 뒤 호출 (저장된 위상은 재생하기 전에 민감한 광선만 다시 적분)
+void applyMassEditToRayPhaseCache(int body, float deltaMass);
+
+RayPhaseCacheStats rayPhaseCacheStats();
@@ -0,0 +1,112 @@
+﻿#include "gl_common.h"
+#include "ray_renderer.h"
+#include <cstring>
+#include <algorithm>
+
+// 애플 기본 GL(2.1)에는 glMapBufferRange가 없으므로 glBufferSubData만 사용
+#if defined(__APPLE__)
+#define RAY_VBO_MAP_RANGE 0
+#else
+#define RAY_VBO_MAP_RANGE 1
+#endif
+
+bool useRayVbo = true;
+
+static bool vboSupported = false;
+static bool mapRangeSupported = false;
+static GLuint rayVbo = 0;
+static GLsizeiptr vboCapacity = 0; // 바이트
+static GLintptr vboHead = 0;       // 다음 프레임을 쓸 위치
+static GLintptr drawOffset = 0;    // 마지막으로 올린 프레임 위치
+static long long uploadedGeneration = -1;
+
+bool initRayRenderer() {
+    vboSupported = hasGLVersion(1, 5);
+    mapRangeSupported = RAY_VBO_MAP_RANGE && (hasGLVersion(3, 0) || hasGLExtension("GL_ARB_map_buffer_range"));
+    if (!vboSupported) {
+        useRayVbo = false;
+        return false;
+    }
+    glGenBuffers(1, &rayVbo);
+    vboCapacity = 0;
+    vboHead = 0;
+    uploadedGeneration = -1;
+    return true;
+}
+
+void shutdownRayRenderer() {
+    if (rayVbo != 0) glDeleteBuffers(1, &rayVbo);
+    rayVbo = 0;
+    vboCapacity = 0;
+}
+
+// points[0, used)를 VBO 뒤쪽 빈 구간에 복사하고 그 위치를 drawOffset에 기록
+static void uploadRayPaths(const RayPathArena& paths) {
+    GLsizeiptr bytes = (GLsizeiptr)paths.used * sizeof(glm::vec3);
+    // 다음 구간 시작을 64바이트에 맞춤
+    GLsizeiptr stride = (bytes + 63) & ~(GLsizeiptr)63;
+
+    if (stride * RAY_VBO_RING_FRAMES > vboCapacity) {
+        // 광선 수가 늘면 링 크기도 키움 (줄어들 때는 그대로 재사용)
+        vboCapacity = stride * RAY_VBO_RING_FRAMES;
+        glBufferData(GL_ARRAY_BUFFER, vboCapacity, nullptr, GL_STREAM_DRAW);
+        vboHead = 0;
+    }
+    else if (vboHead + stride > vboCapacity) {
+        // 고아화: 드라이버가 새 저장소를 주므로 이전 프레임을 그리는 중이어도 기다리지 않음
+        glBufferData(GL_ARRAY_BUFFER, vboCapacity, nullptr, GL_STREAM_DRAW);
+        vboHead = 0;
+    }
+
+    if (bytes > 0) {
+        void* dst = nullptr;
+#if RAY_VBO_MAP_RANGE
+        // 이번 구간은 아직 아무 그리기도 참조하지 않으므로 동기화 없이 덮어씀
+        if (mapRangeSupported) {
+            dst = glMapBufferRange(GL_ARRAY_BUFFER, vboHead, bytes,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        }
+#endif
+        if (dst) {
+            std::memcpy(dst, paths.points.data(), (size_t)bytes);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        else {
+            glBufferSubData(GL_ARRAY_BUFFER, vboHead, bytes, paths.points.data());
+        }
+    }
+    drawOffset = vboHead;
+    vboHead += stride;
+}
+
+// 기존 방식 (VBO를 못 쓰거나 꺼둔 경우)
+static void drawRayPathsImmediate(const RayPathArena& paths) {
+    for (int i = 0; i < paths.numPaths; i++) {
+        glBegin(GL_LINE_STRIP);
+        for (const auto& p : paths.path(i)) {
+            glVertex3f(p.x, p.y, p.z);
+        }
+        glEnd();
+    }
+}
+
+void drawRayPaths(const RayPathArena& paths, long long generation) {
+    if (paths.numPaths <= 0) return;
+    if (!useRayVbo || !vboSupported) {
+        drawRayPathsImmediate(paths);
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, rayVbo);
+    if (generation != uploadedGeneration) {
+        uploadRayPaths(paths);
+        uploadedGeneration = generation;
+    }
+
+    // 정점 포인터를 이번 프레임 구간 시작으로 두면 아레나의 first/count를 그대로 쓸 수 있음
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(glm::vec3), (const void*)drawOffset);
+    glMultiDrawArrays(GL_LINE_STRIP, paths.first.data(), paths.count.data(), paths.numPaths);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
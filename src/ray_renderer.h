@@ -0,0 +1,22 @@
+﻿#pragma once
+#include "ray_path_arena.h"
+
+// --- 광선 VBO 렌더러 ---
+// 아레나의 경로 점을 스트리밍 VBO에 올리고 glMultiDrawArrays 한 번으로 모든 광선을 그림
+// VBO는 프레임마다 뒤쪽 빈 구간에 이어서 쓰고 (동기화 없는 매핑), 끝에 닿으면 고아화(orphan)해서
+// GPU가 아직 읽는 중인 이전 프레임 구간을 기다리지 않음
+// 고정 파이프라인(glVertexPointer)만 사용하므로 Mesa llvmpipe 같은 소프트웨어 GL에서도 동작
+
+// VBO 한 개에 담을 프레임 수 (이만큼 쓰고 나면 고아화)
+const int RAY_VBO_RING_FRAMES = 3;
+
+// GL 컨텍스트를 만든 뒤 호출, VBO를 못 쓰는 GL 1.5 미만이면 false (drawRayPaths가 즉시 모드로 그림)
+bool initRayRenderer();
+void shutdownRayRenderer();
+
+// 현재 블렌드/색 상태로 모든 경로를 선으로 그림
+// generation이 지난번과 같으면 다시 올리지 않고 VBO에 남아있는 구간을 그대로 그림
+void drawRayPaths(const RayPathArena& paths, long long generation);
+
+// 켜져 있으면 VBO, 꺼져 있으면 기존 glBegin/glVertex 즉시 모드 (비교용)
+extern bool useRayVbo;
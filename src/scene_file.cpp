@@ -0,0 +1,303 @@
+﻿#include "scene_file.h"
+#include "mapped_file.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+
+// --- 파일 구조 ---
+// [SceneFileHeader][성분 0 배열][성분 1 배열]... (각 배열은 64바이트 정렬, 천체마다 4바이트 값 하나)
+enum SceneField {
+    SCENE_POSITION_X, SCENE_POSITION_Y, SCENE_POSITION_Z, // t = 0 위치
+    SCENE_MASS,
+    SCENE_RADIUS,
+    SCENE_COLOR_R, SCENE_COLOR_G, SCENE_COLOR_B,
+    SCENE_CENTER_X, SCENE_CENTER_Y, SCENE_CENTER_Z,
+    SCENE_ORBIT_RADIUS,
+    SCENE_ORBIT_SPEED,
+    SCENE_ROTATION_SPEED,
+    SCENE_ECCENTRICITY,
+    SCENE_MEAN_ANOMALY,
+    SCENE_PLANE_PX, SCENE_PLANE_PY, SCENE_PLANE_PZ,
+    SCENE_PLANE_QX, SCENE_PLANE_QY, SCENE_PLANE_QZ,
+    SCENE_PARENT, // int32, 부모가 없으면 -1 (항상 앞 단계 천체 번호)
+    SCENE_FIELD_COUNT
+};
+
+struct SceneFileHeader {
+    char magic[4];        // "EHSB"
+    uint32_t version;
+    uint32_t bodyCount;
+    uint32_t fieldCount;  // SCENE_FIELD_COUNT
+    uint64_t sourceSize;  // 원본 텍스트 크기 (원본 없이 쓴 바이너리는 0)
+    int64_t sourceTime;   // 원본 수정 시각 (file_time_type 틱)
+    uint64_t offset[SCENE_FIELD_COUNT];
+};
+
+static const char SCENE_FILE_MAGIC[4] = { 'E', 'H', 'S', 'B' };
+
+static inline uint64_t align64(uint64_t value) {
+    return (value + 63) & ~(uint64_t)63;
+}
+
+static bool sceneError(std::string* error, int line, const std::string& message) {
+    if (error) *error = (line > 0) ? "line " + std::to_string(line) + ": " + message : message;
+    return false;
+}
+
+std::string sceneBinaryPath(const char* sourcePath) {
+    return std::string(sourcePath) + ".ehsb";
+}
+
+// 파일 성분 순서대로의 BodyStore 배열 (SCENE_PARENT 앞까지)
+static std::vector<float> BodyStore::* const SCENE_COLUMNS[SCENE_PARENT] = {
+    &BodyStore::x, &BodyStore::y, &BodyStore::z,
+    &BodyStore::mass,
+    &BodyStore::radius,
+    &BodyStore::colorR, &BodyStore::colorG, &BodyStore::colorB,
+    &BodyStore::centerX, &BodyStore::centerY, &BodyStore::centerZ,
+    &BodyStore::orbitRadius,
+    &BodyStore::orbitSpeed,
+    &BodyStore::rotationSpeed,
+    &BodyStore::eccentricity,
+    &BodyStore::meanAnomaly,
+    &BodyStore::planePX, &BodyStore::planePY, &BodyStore::planePZ,
+    &BodyStore::planeQX, &BodyStore::planeQY, &BodyStore::planeQZ,
+};
+
+// store는 단계 정렬과 t = 0 위치 계산이 끝난 상태
+static bool writeSceneColumns(const BodyStore& store, uint64_t sourceSize, int64_t sourceTime, const char* binaryPath) {
+    const int n = store.count;
+    SceneFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SCENE_FILE_MAGIC, 4);
+    header.version = SCENE_FILE_VERSION;
+    header.bodyCount = (uint32_t)n;
+    header.fieldCount = SCENE_FIELD_COUNT;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    uint64_t offset = align64(sizeof(SceneFileHeader));
+    for (int f = 0; f < SCENE_FIELD_COUNT; f++) {
+        header.offset[f] = offset;
+        offset = align64(offset + (uint64_t)n * 4);
+    }
+
+    // 중간에 실패해도 깨진 바이너리가 남지 않도록 임시 파일에 다 쓴 뒤 이름 바꿈
+    std::string tempPath = std::string(binaryPath) + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+    static const unsigned char padding[64] = { 0 };
+    uint64_t written = sizeof(header);
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int f = 0; ok && f < SCENE_FIELD_COUNT; f++) {
+        size_t pad = (size_t)(header.offset[f] - written);
+        const void* data = (f == SCENE_PARENT) ? (const void*)store.parent.data() : (const void*)(store.*SCENE_COLUMNS[f]).data();
+        ok = std::fwrite(padding, 1, pad, file) == pad
+            && std::fwrite(data, 4, (size_t)n, file) == (size_t)n;
+        written = header.offset[f] + (uint64_t)n * 4;
+    }
+    ok = (std::fclose(file) == 0) && ok;
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tempPath, binaryPath, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+// --- 텍스트 장면 ---
+// [begin, end) 안에서 공백으로 나뉜 다음 토큰 (없으면 false)
+static bool nextToken(const char*& cursor, const char* end, const char*& token, size_t& length) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) cursor++;
+    if (cursor >= end) return false;
+    token = cursor;
+    while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r') cursor++;
+    length = (size_t)(cursor - token);
+    return true;
+}
+
+static bool tokenIs(const char* token, size_t length, const char* word) {
+    return std::strlen(word) == length && std::strncmp(token, word, length) == 0;
+}
+
+// 다음 토큰 count개를 숫자로 읽음
+static bool readNumbers(const char*& cursor, const char* end, float* out, int count) {
+    for (int k = 0; k < count; k++) {
+        const char* token;
+        size_t length;
+        if (!nextToken(cursor, end, token, length)) return false;
+        char* parsed = nullptr;
+        out[k] = std::strtof(token, &parsed);
+        if (parsed != token + length) return false;
+    }
+    return true;
+}
+
+bool compileSceneFile(const char* sourcePath, const char* binaryPath, std::string* error) {
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (!fileStamp(sourcePath, sourceSize, sourceTime)) return sceneError(error, 0, std::string("cannot open ") + sourcePath);
+
+    std::string text((size_t)sourceSize, '\0');
+    FILE* file = std::fopen(sourcePath, "rb");
+    if (!file) return sceneError(error, 0, std::string("cannot open ") + sourcePath);
+    bool read = std::fread(&text[0], 1, text.size(), file) == text.size();
+    std::fclose(file);
+    if (!read) return sceneError(error, 0, std::string("cannot read ") + sourcePath);
+
+    BodyStore store;
+    std::unordered_map<std::string, int> names;
+    // 부모 이름은 뒤에 나와도 되므로 모든 줄을 읽은 뒤에 번호로 바꿈
+    struct ParentName { int body; int line; std::string name; };
+    std::vector<ParentName> parentNames;
+    int lineNumber = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t next = text.find('\n', pos);
+        if (next == std::string::npos) next = text.size();
+        const char* cursor = text.data() + pos;
+        const char* end = text.data() + next;
+        const char* comment = (const char*)std::memchr(cursor, '#', (size_t)(end - cursor));
+        if (comment) end = comment;
+        pos = next + 1;
+        lineNumber++;
+
+        const char* token;
+        size_t length;
+        if (!nextToken(cursor, end, token, length)) continue; // 빈 줄 / 주석
+        if (!tokenIs(token, length, "body")) return sceneError(error, lineNumber, "expected 'body'");
+        if (!nextToken(cursor, end, token, length)) return sceneError(error, lineNumber, "missing body name");
+        std::string name(token, length);
+        if (names.count(name)) return sceneError(error, lineNumber, "duplicate body '" + name + "'");
+
+        Body body;
+        body.mass = -1.0f;
+        body.radius = -1.0f;
+        bool hasParent = false;
+        while (nextToken(cursor, end, token, length)) {
+            std::string key(token, length);
+            float v[3];
+            if (key == "mass" && readNumbers(cursor, end, v, 1)) body.mass = v[0];
+            else if (key == "radius" && readNumbers(cursor, end, v, 1)) body.radius = v[0];
+            else if (key == "color" && readNumbers(cursor, end, v, 3)) body.color = glm::vec3(v[0], v[1], v[2]);
+            else if (key == "orbit" && readNumbers(cursor, end, v, 2)) { body.orbitRadius = v[0]; body.orbitSpeed = v[1]; }
+            else if (key == "spin" && readNumbers(cursor, end, v, 1)) body.rotationSpeed = v[0];
+            else if (key == "center" && readNumbers(cursor, end, v, 3)) body.relativeOffset = glm::vec3(v[0], v[1], v[2]);
+            else if (key == "eccentricity" && readNumbers(cursor, end, v, 1) && v[0] >= 0.0f && v[0] <= ORBIT_MAX_ECCENTRICITY) body.eccentricity = v[0];
+            else if (key == "inclination" && readNumbers(cursor, end, v, 1)) body.inclination = glm::radians(v[0]);
+            else if (key == "node" && readNumbers(cursor, end, v, 1)) body.ascendingNode = glm::radians(v[0]);
+            else if (key == "periapsis" && readNumbers(cursor, end, v, 1)) body.periapsisArgument = glm::radians(v[0]);
+            else if (key == "anomaly" && readNumbers(cursor, end, v, 1)) body.meanAnomaly = glm::radians(v[0]);
+            else if (key == "parent" && !hasParent && nextToken(cursor, end, token, length)) {
+                parentNames.push_back({ store.count, lineNumber, std::string(token, length) });
+                hasParent = true;
+            }
+            else return sceneError(error, lineNumber, "bad value for '" + key + "'");
+        }
+        if (body.mass < 0.0f || body.radius <= 0.0f) return sceneError(error, lineNumber, "body needs mass >= 0 and radius > 0");
+
+        names.emplace(name, store.count);
+        addBody(store, body);
+    }
+    if (store.count == 0) return sceneError(error, 0, std::string("no bodies in ") + sourcePath);
+
+    for (const ParentName& p : parentNames) {
+        auto found = names.find(p.name);
+        if (found == names.end()) return sceneError(error, p.line, "unknown parent '" + p.name + "'");
+        store.parent[p.body] = found->second;
+    }
+    if (!sortBodyLevels(store)) return sceneError(error, 0, "parent cycle in " + std::string(sourcePath));
+    updateBodyPositions(store, 0.0f); // t = 0 위치
+
+    if (!writeSceneColumns(store, sourceSize, sourceTime, binaryPath)) return sceneError(error, 0, std::string("cannot write ") + binaryPath);
+    return true;
+}
+
+bool writeSceneBinary(BodyStore& store, const char* binaryPath) {
+    if (store.levelStart.empty() && !sortBodyLevels(store)) return false;
+    return writeSceneColumns(store, 0, 0, binaryPath);
+}
+
+// --- 읽기 ---
+// 헤더와 부모 번호를 검사하고 (원본과 맞지 않거나 깨졌으면 false, bodies는 그대로) 성분 배열을 bodies로 복사
+static bool readSceneBinary(const MappedFile& file, bool checkSource, uint64_t sourceSize, int64_t sourceTime, std::string* error) {
+    if (file.size < sizeof(SceneFileHeader)) return sceneError(error, 0, "scene binary too small");
+    SceneFileHeader header;
+    std::memcpy(&header, file.data, sizeof(header));
+    if (std::memcmp(header.magic, SCENE_FILE_MAGIC, 4) != 0 || header.version != SCENE_FILE_VERSION ||
+        header.fieldCount != SCENE_FIELD_COUNT) {
+        return sceneError(error, 0, "not a scene binary (version " + std::to_string(SCENE_FILE_VERSION) + ")");
+    }
+    if (checkSource && (header.sourceSize != sourceSize || header.sourceTime != sourceTime)) {
+        return sceneError(error, 0, "scene binary is older than its source");
+    }
+    const uint64_t bytes = (uint64_t)header.bodyCount * 4;
+    for (int f = 0; f < SCENE_FIELD_COUNT; f++) {
+        if ((header.offset[f] & 3) != 0 || header.offset[f] > file.size || bytes > file.size - header.offset[f]) {
+            return sceneError(error, 0, "scene binary is truncated");
+        }
+    }
+
+    // 단계 순서 검사: 부모는 앞 번호이고 깊이는 줄어들지 않아야 함 (깊이가 바뀌는 곳이 단계 경계)
+    const int n = (int)header.bodyCount;
+    const int32_t* parent = (const int32_t*)(file.data + header.offset[SCENE_PARENT]);
+    std::vector<int> depth(n), levelStart;
+    for (int i = 0; i < n; i++) {
+        if (parent[i] < -1 || parent[i] >= i) return sceneError(error, 0, "body " + std::to_string(i) + " has an invalid parent");
+        depth[i] = (parent[i] < 0) ? 0 : depth[parent[i]] + 1;
+        if (i > 0 && depth[i] < depth[i - 1]) return sceneError(error, 0, "body " + std::to_string(i) + " is out of level order");
+        while ((int)levelStart.size() <= depth[i]) levelStart.push_back(i);
+    }
+    levelStart.push_back(n);
+    // 이심률이 범위 밖이면 케플러 풀이가 수렴하지 않음 (NaN도 여기서 걸림)
+    const float* eccentricity = (const float*)(file.data + header.offset[SCENE_ECCENTRICITY]);
+    for (int i = 0; i < n; i++) {
+        if (!(eccentricity[i] >= 0.0f && eccentricity[i] <= ORBIT_MAX_ECCENTRICITY)) {
+            return sceneError(error, 0, "body " + std::to_string(i) + " has an invalid eccentricity");
+        }
+    }
+
+    // 성분마다 배열 한 번 복사 (천체마다 할당 없음)
+    for (int f = 0; f < SCENE_PARENT; f++) {
+        const float* value = (const float*)(file.data + header.offset[f]);
+        (bodies.*SCENE_COLUMNS[f]).assign(value, value + n);
+    }
+    bodies.parent.assign(parent, parent + n);
+    bodies.levelStart = std::move(levelStart);
+    bodies.count = n;
+    return true;
+}
+
+static bool hasSuffix(const std::string& text, const char* suffix) {
+    size_t length = std::strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+bool loadSceneFile(const char* path, std::string* error) {
+    MappedFile file;
+    if (hasSuffix(path, ".ehsb")) {
+        if (!mapFileReadOnly(path, file)) return sceneError(error, 0, std::string("cannot open ") + path);
+        bool ok = readSceneBinary(file, false, 0, 0, error);
+        unmapFile(file);
+        return ok;
+    }
+
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (!fileStamp(path, sourceSize, sourceTime)) return sceneError(error, 0, std::string("cannot open ") + path);
+    std::string binaryPath = sceneBinaryPath(path);
+    if (mapFileReadOnly(binaryPath.c_str(), file)) {
+        bool ok = readSceneBinary(file, true, sourceSize, sourceTime, nullptr);
+        unmapFile(file);
+        if (ok) return true;
+    }
+
+    // 없거나 오래된 바이너리 -> 다시 컴파일하고 매핑
+    if (!compileSceneFile(path, binaryPath.c_str(), error)) return false;
+    if (!mapFileReadOnly(binaryPath.c_str(), file)) return sceneError(error, 0, "cannot open " + binaryPath);
+    bool ok = readSceneBinary(file, true, sourceSize, sourceTime, error);
+    unmapFile(file);
+    return ok;
+}
@@ -0,0 +1,31 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "simulation.h"
+
+// --- 장면 파일 ---
+// 사람이 쓰는 텍스트 장면(.ehscene)을 원본 옆 "<원본>.ehsb" 바이너리로 컴파일해 두고
+// 실행할 때는 바이너리를 메모리 매핑해서 읽음 (텍스처 캐시처럼 원본 크기/수정 시각이 다르면 다시 만듦)
+// 바이너리는 BodyStore와 같은 성분별 배열(위치, 질량, 반지름, 색, 공전 정보, 궤도면 기저, 부모 번호)을 계층 단계 순서로 담고 있어서
+// 읽을 때는 배열을 통째로 복사하고 부모 번호만 검사함 (천체가 백만 개여도 천체마다 할당 / 정렬 없음)
+//
+// 텍스트 형식: 한 줄에 천체 하나, '#' 뒤는 주석, 부모는 파일 안 다른 천체 이름 (뒤에 나와도 됨, 순환이면 오류)
+//   body <이름> mass <질량> radius <반지름> [color r g b] [parent <이름>] [orbit <반지름> <속도>] [spin <자전 속도>] [center x y z]
+//   center: 부모 위치(부모가 없으면 원점)에서 공전 중심까지의 오프셋 (Body::relativeOffset)
+//   타원 궤도 (선택, 각도는 도 단위): [eccentricity <e>] [inclination <i>] [node <승교점 경도>] [periapsis <근점 인수>] [anomaly <t = 0 평균 근점 이각>]
+//   orbit의 반지름은 긴반지름, eccentricity는 0 이상 ORBIT_MAX_ECCENTRICITY 이하
+// 천체 번호는 파일 순서가 아니라 단계 순서 (부모가 없는 천체들, 그 위성들, ... 순, 같은 단계 안에서는 파일 순서)
+
+const uint32_t SCENE_FILE_VERSION = 3;
+
+std::string sceneBinaryPath(const char* sourcePath);
+
+// 텍스트 장면을 바이너리로 컴파일 (임시 파일에 쓴 뒤 이름 바꿈, 실패하면 error에 줄 번호와 이유)
+bool compileSceneFile(const char* sourcePath, const char* binaryPath, std::string* error = nullptr);
+
+// store의 천체를 원본 없는 바이너리로 저장 (정렬 전이면 단계 순서로 정렬한 뒤)
+bool writeSceneBinary(BodyStore& store, const char* binaryPath);
+
+// 텍스트 장면이면 최신 바이너리를 (없거나 오래됐으면 먼저 컴파일해서) 매핑하고, .ehsb면 바로 매핑해서 bodies를 바꿈
+bool loadSceneFile(const char* path, std::string* error = nullptr);
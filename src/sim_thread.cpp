@@ -0,0 +1,260 @@
+﻿#include "sim_thread.h"
+#include "frame_profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// --- 삼중 버퍼 ---
+// frames[backFrame]: 워커가 쓰는 중, frames[frontFrame]: 렌더 스레드가 읽는 중
+// latestFrame: 가장 최근에 완성된 버퍼 번호 (+ 아직 렌더 스레드가 안 가져갔으면 FRAME_FRESH)
+// 양쪽 모두 교환(exchange) 한 번으로 버퍼를 바꾸므로 락이 없음
+static SimFrame frames[3];
+static const int FRAME_FRESH = 4;
+static std::atomic<int> latestFrame(2);
+static int backFrame = 1;  // 워커 스레드만 사용
+static int frontFrame = 0; // 렌더 스레드만 사용
+
+static std::thread worker;
+static std::atomic<bool> running(false);
+
+// 렌더 스레드 -> 워커 요청 (세대 시작 때 한 번 복사해 가는 작은 구조체라 뮤텍스로 충분)
+static std::mutex requestMutex;
+static SimControls pendingControls;
+static bool controlsChanged = false;
+static std::vector<std::pair<int, float>> pendingMassChanges;
+
+// --- 고정 스텝 시계 (워커 스레드 전용) ---
+static long long simStep = 0;
+static double accumulatorMs = 0.0;  // 아직 스텝이 되지 못한 벽시계 시간
+static double lastClockMs = -1.0;
+static long long droppedSteps = 0;
+
+// 지난 세대에 넘긴 위치 (다음 세대의 보간 시작점)
+static float publishedTime = 0.0f;
+static std::vector<glm::vec3> publishedPositions;
+static bool snapInterpolation = true; // 다음 세대는 보간 없이 바로 보여줌
+
+// 지난 호출 뒤 흐른 벽시계 시간을 누적해서 진행할 고정 스텝 수를 돌려줌
+static int takeSimSteps(double nowMs) {
+    if (lastClockMs < 0.0) lastClockMs = nowMs;
+    accumulatorMs += nowMs - lastClockMs;
+    lastClockMs = nowMs;
+    int steps = (int)std::floor(accumulatorMs / SIM_STEP_MS);
+    accumulatorMs -= steps * SIM_STEP_MS;
+    if (steps > SIM_MAX_STEPS_PER_GENERATION) {
+        droppedSteps += steps - SIM_MAX_STEPS_PER_GENERATION;
+        steps = SIM_MAX_STEPS_PER_GENERATION;
+    }
+    return steps;
+}
+
+static float stepTime(long long step) {
+    return (float)((double)step * SIM_STEP_TIME);
+}
+
+SimControls currentSimControls() {
+    SimControls c;
+    c.useSimdRays = useSimdRays;
+    c.useWavefrontRays = useWavefrontRays;
+    c.rayIntegrator = rayIntegrator;
+    c.escapeTolerance = escapeTolerance;
+    c.useOctree = useOctree;
+    c.useAccelField = useAccelField;
+    c.numRays = numRays;
+    c.maxSteps = maxSteps;
+    c.rayAmortizeStride = rayAmortizeStride;
+    c.useRayPhaseCache = useRayPhaseCache;
+    c.useNBody = useNBody;
+    c.nbodyIntegrator = nbodyIntegrator;
+    return c;
+}
+
+// 렌더 스레드가 보낸 설정 / 질량 변경을 전역 상태에 반영 (워커 스레드에서만 호출)
+static void applyRequests() {
+    std::lock_guard<std::mutex> lock(requestMutex);
+    if (controlsChanged) {
+        // 경로 모양이 달라지는 설정이 바뀌면 시간 분할로 재사용하던 지난 경로를 버림
+        // (품질 조절기가 바꾸는 광선 수 / 스텝 예산과 분할 간격은 그대로 둠, 새 광선은 기록이 없으므로 바로 적분됨)
+        const SimControls& c = pendingControls;
+        if (c.useSimdRays != useSimdRays || c.rayIntegrator != rayIntegrator || c.escapeTolerance != escapeTolerance ||
+            c.useOctree != useOctree || c.useAccelField != useAccelField) {
+            invalidateRayHistory();
+        }
+        // N체를 켜거나 끄면 천체가 궤도에서 벗어나거나 궤도로 돌아가므로 지난 경로도 버림 (켤 때는 그 시각의 궤도에서 시작)
+        if (c.useNBody != useNBody) {
+            resetNBody();
+            invalidateRayHistory();
+            snapInterpolation = true; // 궤도 위치와 N체 위치 사이를 미끄러지듯 보간하지 않게
+        }
+        useSimdRays = pendingControls.useSimdRays;
+        useWavefrontRays = pendingControls.useWavefrontRays; // 묶음 엔진과 결과가 같으므로 지난 경로를 그대로 둠
+        rayIntegrator = pendingControls.rayIntegrator;
+        escapeTolerance = pendingControls.escapeTolerance;
+        useOctree = pendingControls.useOctree;
+        useAccelField = pendingControls.useAccelField;
+        setActiveRayCount(pendingControls.numRays);
+        maxSteps = std::max(1, pendingControls.maxSteps);
+        rayAmortizeStride = std::max(1, pendingControls.rayAmortizeStride);
+        useRayPhaseCache = pendingControls.useRayPhaseCache; // 다른 설정 변경은 캐시가 직접 확인해서 비움
+        useNBody = pendingControls.useNBody;
+        nbodyIntegrator = pendingControls.nbodyIntegrator; // 적분 중에 바꿔도 상태는 그대로 이어감
+        controlsChanged = false;
+    }
+    for (const auto& change : pendingMassChanges) {
+        if (change.first < 0 || change.first >= bodies.count) continue;
+        float& mass = bodies.mass[change.first];
+        float delta = std::max(0.0f, mass + change.second) - mass;
+        if (delta == 0.0f) continue;
+        mass += delta;
+        // 저장해둔 경로 중 이 천체에 민감한 광선만 다시 적분 (나머지는 끝점 변위 추정이 massEditTolerance 이하)
+        applyMassEditToRayHistory(change.first, delta);
+        applyMassEditToRayPhaseCache(change.first, delta);
+    }
+    pendingMassChanges.clear();
+}
+
+// 고정 스텝 steps개를 진행해서 한 세대를 계산한 뒤 back 버퍼에 기록하고 공개 (그 세대의 시뮬레이션 시간을 돌려줌)
+static float runGeneration(long long generation, int steps) {
+    applyRequests();
+
+    simStep += steps;
+    float time = stepTime(simStep);
+    double physicsStart = profileClockMs();
+    // 스텝마다 물리 진행 (N체는 updateBodyPhysics 한 번에 적분하는 스텝 수에 상한이 있으므로 나눠 부름)
+    // 케플러 궤도는 시각만으로 정해지는 닫힌 식이라 마지막 스텝만 계산
+    long long firstStep = useNBody ? std::min(simStep, simStep - steps + 1) : simStep;
+    for (long long s = firstStep; s <= simStep; s++) updateBodyPhysics(stepTime(s));
+    double raysStart = profileClockMs();
+    simulateRayPhase(time, glm::vec3(lightPosition));
+    double raysEnd = profileClockMs();
+
+    SimFrame& back = frames[backFrame];
+    back.generation = generation;
+    back.time = time;
+    back.step = simStep;
+    back.steps = steps;
+    back.droppedSteps = droppedSteps;
+    back.bodyPositions.resize(bodies.count);
+    back.bodyMasses.assign(bodies.mass.begin(), bodies.mass.end());
+    back.bodyRadii.assign(bodies.radius.begin(), bodies.radius.end());
+    back.bodySpins.assign(bodies.rotationSpeed.begin(), bodies.rotationSpeed.end());
+    back.bodyColors.resize(bodies.count);
+    for (int i = 0; i < bodies.count; i++) {
+        back.bodyPositions[i] = bodies.position(i);
+        back.bodyColors[i] = bodies.color(i);
+    }
+    if (snapInterpolation || publishedPositions.size() != back.bodyPositions.size()) {
+        back.previousTime = time;
+        back.previousBodyPositions = back.bodyPositions;
+        snapInterpolation = false;
+    }
+    else {
+        back.previousTime = publishedTime;
+        back.previousBodyPositions.swap(publishedPositions); // 받은 쪽 옛 배열은 아래에서 용량만 재사용
+    }
+    publishedTime = time;
+    publishedPositions.assign(back.bodyPositions.begin(), back.bodyPositions.end());
+    // 경로는 복사하지 않고 맞바꿈 (rayPaths는 세 세대 전 아레나를 받아서 용량을 재사용)
+    std::swap(back.rayPaths, rayPaths);
+    back.stats = lastRayStats;
+    back.solveMs = raysEnd - physicsStart;
+    back.physicsStartMs = physicsStart;
+    back.physicsMs = raysStart - physicsStart;
+    back.raysStartMs = raysStart;
+    back.raysMs = raysEnd - raysStart;
+    back.phaseCache = rayPhaseCacheStats();
+    back.nbody = useNBody;
+    back.nbodyStats = nbodyStats;
+    back.publishMs = profileClockMs();
+
+    int previous = latestFrame.exchange(backFrame | FRAME_FRESH, std::memory_order_acq_rel);
+    backFrame = previous & 3;
+    return time;
+}
+
+static void workerLoop() {
+    long long generation = 1;
+    while (running.load(std::memory_order_acquire)) {
+        auto start = std::chrono::steady_clock::now();
+        int steps = takeSimSteps(profileClockMs());
+        if (steps == 0) {
+            // 다음 스텝이 찰 때까지 대기 (같은 시각의 세대를 다시 만들지 않음)
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(SIM_STEP_MS - accumulatorMs));
+            continue;
+        }
+        float time = runGeneration(++generation, steps);
+
+        auto next = start + std::chrono::duration<double, std::milli>(SIM_MIN_GENERATION_MS);
+        // 남는 시간에 앞으로 재생할 위상을 미리 적분 (rayPaths는 이미 넘겼으므로 덮어써도 됨)
+        double idleMs = std::chrono::duration<double, std::milli>(next - std::chrono::steady_clock::now()).count();
+        fillRayPhaseCache(time, glm::vec3(lightPosition), idleMs - SIM_PHASE_FILL_MARGIN_MS);
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void startSimulationThread() {
+    if (running.load()) return;
+    pendingControls = currentSimControls();
+    takeSimSteps(profileClockMs()); // 시계는 첫 세대부터 셈 (시작 전 로딩 시간은 건너뜀)
+    runGeneration(1, 0);
+    acquireSimFrame();
+
+    running.store(true, std::memory_order_release);
+    worker = std::thread(workerLoop);
+}
+
+void stopSimulationThread() {
+    if (!running.load()) return;
+    running.store(false, std::memory_order_release);
+    if (worker.joinable()) worker.join();
+}
+
+const SimFrame& acquireSimFrame() {
+    if (latestFrame.load(std::memory_order_acquire) & FRAME_FRESH) {
+        int previous = latestFrame.exchange(frontFrame, std::memory_order_acq_rel);
+        frontFrame = previous & 3;
+    }
+    return frames[frontFrame];
+}
+
+void submitSimControls(const SimControls& controls) {
+    std::lock_guard<std::mutex> lock(requestMutex);
+    pendingControls = controls;
+    controlsChanged = true;
+}
+
+void submitMassChange(int bodyIndex, float delta) {
+    std::lock_guard<std::mutex> lock(requestMutex);
+    pendingMassChanges.push_back({ bodyIndex, delta });
+}
+
+float advanceSimPlayback(SimPlayback& playback, const SimFrame& frame, double nowMs) {
+    const double msPerTime = SIM_STEP_MS / SIM_STEP_TIME;
+    const double span = frame.time - frame.previousTime;
+    const double target = std::min((double)frame.time, frame.previousTime + (nowMs - frame.publishMs) / msPerTime);
+    if (playback.time < 0.0 || std::fabs(target - playback.time) > SIM_PLAYBACK_SNAP_STEPS * SIM_STEP_TIME) {
+        playback.time = target;
+    }
+    else {
+        const double elapsedMs = std::max(0.0, nowMs - playback.clockMs);
+        playback.time += elapsedMs / msPerTime;
+        playback.time += (target - playback.time) * std::min(1.0, elapsedMs / SIM_PLAYBACK_SMOOTH_MS);
+    }
+    playback.clockMs = nowMs;
+    playback.time = std::min((double)frame.time, std::max((double)frame.previousTime, playback.time));
+    return (span > 0.0) ? (float)((playback.time - frame.previousTime) / span) : 1.0f;
+}
+
+float interpolateSimFrame(const SimFrame& frame, float blend, std::vector<glm::vec3>& positions) {
+    const size_t n = frame.bodyPositions.size();
+    positions.resize(n);
+    if (frame.previousBodyPositions.size() != n) blend = 1.0f;
+    for (size_t i = 0; i < n; i++) {
+        positions[i] = (blend >= 1.0f) ? frame.bodyPositions[i] : frame.previousBodyPositions[i] + (frame.bodyPositions[i] - frame.previousBodyPositions[i]) * blend;
+    }
+    return frame.previousTime + (frame.time - frame.previousTime) * blend;
+}
@@ -0,0 +1,101 @@
+﻿#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "simulation.h"
+#include "ray_phase_cache.h"
+#include "nbody.h"
+
+// --- 백그라운드 시뮬레이션 스레드 ---
+// 천체 궤도 계산과 광선 적분을 GLUT 스레드 밖에서 돌리고
+// 완성된 결과(세대)만 삼중 버퍼로 넘겨서 display()가 적분을 기다리지 않게 함
+// 시작한 뒤에는 bodies / rayPaths / 설정 전역 변수는 워커 스레드만 만짐
+// (렌더 스레드는 SimFrame을 읽고, 바꾸고 싶은 값은 submit 함수로 요청)
+//
+// 시뮬레이션 시간은 고정 스텝 시계: 벽시계(steady_clock) 경과 시간을 누적해서 SIM_STEP_MS마다 SIM_STEP_TIME씩 진행
+// 세대 시각은 항상 스텝의 정수 배라 적분 / 광선 계산이 느려도 우주가 느려지지 않고 (밀린 스텝을 다음 세대가 한꺼번에 처리)
+// 렌더 스레드는 마지막 두 세대의 천체 위치를 보간해서 시뮬레이션보다 빠른 화면 주사율에서도 부드럽게 그림
+
+// 고정 스텝 (기존처럼 60 FPS에서 프레임당 0.02씩 흐르는 속도)
+const double SIM_STEP_MS = 1000.0 / 60.0;
+const double SIM_STEP_TIME = 0.02;
+// 한 세대에 처리하는 최대 스텝 수 (더 밀리면 나머지는 버림, 느린 세대가 다음 세대를 더 느리게 만들지 않게)
+const int SIM_MAX_STEPS_PER_GENERATION = 8;
+
+// 한 세대의 결과 (워커가 다 쓴 뒤에만 렌더 스레드에 보임)
+struct SimFrame {
+    long long generation = 0;
+    float time = 0.0f;                      // updateBodyPhysics에 넘긴 시간 (= step * SIM_STEP_TIME)
+    long long step = 0;                     // 시작 뒤 진행한 고정 스텝 수
+    int steps = 0;                          // 이번 세대가 진행한 고정 스텝 수
+    long long droppedSteps = 0;             // SIM_MAX_STEPS_PER_GENERATION에 걸려 버린 스텝 합
+    std::vector<glm::vec3> bodyPositions;   // bodies와 같은 순서
+    // 보간 시작점 (지난 세대의 시각 / 위치, 첫 세대나 N체 전환 / 천체 수 변경 직후에는 이번 세대와 같음)
+    float previousTime = 0.0f;
+    std::vector<glm::vec3> previousBodyPositions;
+    double publishMs = 0.0;                 // 렌더 스레드에 넘긴 순간 (profileClockMs 기준)
+    std::vector<float> bodyMasses;
+    // 그리기에 필요한 천체 속성 (렌더 스레드는 bodies를 읽지 않고 이 값만 씀)
+    std::vector<float> bodyRadii;
+    std::vector<float> bodySpins;           // bodies.rotationSpeed
+    std::vector<glm::vec3> bodyColors;
+    RayPathArena rayPaths;
+    RayStats stats;
+    double solveMs = 0.0;                   // updateBodyPhysics + simulateRay 시간
+    // 프로파일러용 구간 (profileClockMs 기준)
+    double physicsStartMs = 0.0, physicsMs = 0.0;
+    double raysStartMs = 0.0, raysMs = 0.0;
+    RayPhaseCacheStats phaseCache;          // hit: 이번 세대 경로를 위상 캐시에서 복사했는지
+    bool nbody = false;                     // 이번 세대가 N체 적분인지
+    NBodyStats nbodyStats;
+};
+
+// 키 입력으로 바꾸는 설정 (렌더 스레드가 들고 있다가 통째로 넘김)
+struct SimControls {
+    bool useSimdRays;
+    bool useWavefrontRays;
+    int rayIntegrator;
+    float escapeTolerance;
+    bool useOctree;
+    bool useAccelField;
+    int numRays;   // 품질 조절기가 바꿈
+    int maxSteps;
+    int rayAmortizeStride;
+    bool useRayPhaseCache;
+    bool useNBody;
+    int nbodyIntegrator;
+};
+
+// 워커가 프레임을 만드는 최소 간격 (고정 스텝 하나, 스텝이 차지 않았으면 세대를 만들지 않음)
+const double SIM_MIN_GENERATION_MS = SIM_STEP_MS;
+// 세대 사이 남는 시간에 위상 캐시를 채울 때 다음 세대 시작 전에 남겨둘 여유
+const double SIM_PHASE_FILL_MARGIN_MS = 2.0;
+
+// 현재 전역 설정값으로 SimControls를 채움 (스레드 시작 전에 호출)
+SimControls currentSimControls();
+
+// 첫 세대는 호출한 스레드에서 바로 계산해서 넘겨두고 워커를 띄움
+void startSimulationThread();
+void stopSimulationThread();
+
+// 렌더 스레드 전용: 가장 최근에 완성된 세대 (다음 호출 전까지 내용이 바뀌지 않음)
+const SimFrame& acquireSimFrame();
+
+// 다음 세대 시작 시 워커가 반영
+void submitSimControls(const SimControls& controls);
+void submitMassChange(int bodyIndex, float delta);
+
+// 렌더 스레드가 들고 있는 재생 시계 (화면에 보여주는 시뮬레이션 시간)
+// 목표는 세대를 받은 순간부터 두 세대 사이 간격에 걸쳐 previous -> 이번 세대로 가는 시각 (한 세대 늦게 따라감)
+// 세대가 오는 간격이 흔들려도 목표로 바로 튀지 않고 벽시계 속도로 흐르면서 SIM_PLAYBACK_SMOOTH_MS에 걸쳐 따라감
+struct SimPlayback {
+    double time = -1.0;   // 음수면 다음 호출에서 목표로 바로 맞춤
+    double clockMs = 0.0;
+};
+const double SIM_PLAYBACK_SMOOTH_MS = 100.0;
+// 목표에서 이보다 멀어지면 (멈췄다 재개, 스텝을 버림) 따라가지 않고 바로 맞춤
+const double SIM_PLAYBACK_SNAP_STEPS = 8.0;
+
+// 재생 시계를 nowMs(profileClockMs 기준)까지 진행하고 frame 안의 보간 비율을 돌려줌 (0 = previous, 1 = 이번 세대)
+float advanceSimPlayback(SimPlayback& playback, const SimFrame& frame, double nowMs);
+// 보간한 천체 위치를 positions에 채우고 그 위치의 시뮬레이션 시간을 돌려줌 (자전 각도 등에 씀)
+float interpolateSimFrame(const SimFrame& frame, float blend, std::vector<glm::vec3>& positions);
@@ -0,0 +1,111 @@
+﻿#pragma once
+#include <cmath>
+#include "ray_batch.h" // RAY_BATCH_LANES
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// --- lane 연산 래퍼 ---
+// 커널 본문은 하나로 유지하고, 명령어 집합별로 아래 함수만 바꿔 끼움
+// 광선 엔진(ray_batch)과 천체 공전 갱신(body_store)이 같이 씀, lane 수는 RAY_BATCH_LANES
+
+#if defined(__AVX512F__)
+typedef __m512 vfloat;
+typedef __mmask16 vmask;
+
+static inline vfloat vSet1(float a) { return _mm512_set1_ps(a); }
+static inline vfloat vLoad(const float* p) { return _mm512_load_ps(p); }
+static inline void vStore(float* p, vfloat a) { _mm512_store_ps(p, a); }
+static inline vfloat vLoadU(const float* p) { return _mm512_loadu_ps(p); }
+static inline void vStoreU(float* p, vfloat a) { _mm512_storeu_ps(p, a); }
+static inline vfloat vGather(const float* base, const int* index) { return _mm512_i32gather_ps(_mm512_loadu_si512(index), base, 4); }
+static inline vfloat vAdd(vfloat a, vfloat b) { return _mm512_add_ps(a, b); }
+static inline vfloat vSub(vfloat a, vfloat b) { return _mm512_sub_ps(a, b); }
+static inline vfloat vMul(vfloat a, vfloat b) { return _mm512_mul_ps(a, b); }
+static inline vfloat vFma(vfloat a, vfloat b, vfloat c) { return _mm512_fmadd_ps(a, b, c); }
+static inline vfloat vDiv(vfloat a, vfloat b) { return _mm512_div_ps(a, b); }
+static inline vfloat vMin(vfloat a, vfloat b) { return _mm512_min_ps(a, b); }
+static inline vfloat vMax(vfloat a, vfloat b) { return _mm512_max_ps(a, b); }
+static inline vfloat vSqrt(vfloat a) { return _mm512_sqrt_ps(a); }
+static inline vfloat vRsqrt(vfloat a) { return _mm512_rsqrt14_ps(a); }
+static inline vfloat vAbs(vfloat a) { return _mm512_abs_ps(a); }
+static inline vfloat vFloor(vfloat a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+static inline vmask vLess(vfloat a, vfloat b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+static inline vmask vGreater(vfloat a, vfloat b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+static inline vfloat vSelect(vmask m, vfloat a, vfloat b) { return _mm512_mask_blend_ps(m, b, a); }
+static inline vmask vOr(vmask a, vmask b) { return (vmask)(a | b); }
+static inline vmask vAnd(vmask a, vmask b) { return (vmask)(a & b); }
+static inline vmask vAndNot(vmask a, vmask b) { return (vmask)(a & ~b); }
+static inline unsigned vBits(vmask m) { return (unsigned)m; }
+static inline vmask vMaskFromBits(unsigned bits) { return (vmask)bits; }
+
+#elif defined(__AVX2__)
+typedef __m256 vfloat;
+typedef __m256 vmask;
+
+static inline vfloat vSet1(float a) { return _mm256_set1_ps(a); }
+static inline vfloat vLoad(const float* p) { return _mm256_load_ps(p); }
+static inline void vStore(float* p, vfloat a) { _mm256_store_ps(p, a); }
+static inline vfloat vLoadU(const float* p) { return _mm256_loadu_ps(p); }
+static inline void vStoreU(float* p, vfloat a) { _mm256_storeu_ps(p, a); }
+static inline vfloat vGather(const float* base, const int* index) { return _mm256_i32gather_ps(base, _mm256_loadu_si256((const __m256i*)index), 4); }
+static inline vfloat vAdd(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+static inline vfloat vSub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+static inline vfloat vMul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+#if defined(__FMA__) || defined(_MSC_VER)
+static inline vfloat vFma(vfloat a, vfloat b, vfloat c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+static inline vfloat vFma(vfloat a, vfloat b, vfloat c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+static inline vfloat vDiv(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+static inline vfloat vMin(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+static inline vfloat vMax(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+static inline vfloat vSqrt(vfloat a) { return _mm256_sqrt_ps(a); }
+static inline vfloat vRsqrt(vfloat a) { return _mm256_rsqrt_ps(a); }
+static inline vfloat vAbs(vfloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline vfloat vFloor(vfloat a) { return _mm256_floor_ps(a); }
+static inline vmask vLess(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline vmask vGreater(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline vfloat vSelect(vmask m, vfloat a, vfloat b) { return _mm256_blendv_ps(b, a, m); }
+static inline vmask vOr(vmask a, vmask b) { return _mm256_or_ps(a, b); }
+static inline vmask vAnd(vmask a, vmask b) { return _mm256_and_ps(a, b); }
+static inline vmask vAndNot(vmask a, vmask b) { return _mm256_andnot_ps(b, a); }
+static inline unsigned vBits(vmask m) { return (unsigned)_mm256_movemask_ps(m); }
+static inline vmask vMaskFromBits(unsigned bits) {
+    const __m256i bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i b = _mm256_and_si256(_mm256_set1_epi32((int)bits), bit);
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(b, bit));
+}
+
+#else
+// SIMD 명령어가 없는 빌드: 고정 길이 배열 루프 (컴파일러가 SSE 등으로 자동 벡터화)
+struct vfloat { float v[RAY_BATCH_LANES]; };
+typedef unsigned vmask;
+
+static inline vfloat vSet1(float a) { vfloat r; for (int l = 0; l < RAY_BATCH_LANES; l++) r.v[l] = a; return r; }
+static inline vfloat vLoad(const float* p) { vfloat r; for (int l = 0; l < RAY_BATCH_LANES; l++) r.v[l] = p[l]; return r; }
+static inline void vStore(float* p, vfloat a) { for (int l = 0; l < RAY_BATCH_LANES; l++) p[l] = a.v[l]; }
+static inline vfloat vLoadU(const float* p) { return vLoad(p); }
+static inline void vStoreU(float* p, vfloat a) { vStore(p, a); }
+static inline vfloat vGather(const float* base, const int* index) { vfloat r; for (int l = 0; l < RAY_BATCH_LANES; l++) r.v[l] = base[index[l]]; return r; }
+static inline vfloat vAdd(vfloat a, vfloat b) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] += b.v[l]; return a; }
+static inline vfloat vSub(vfloat a, vfloat b) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] -= b.v[l]; return a; }
+static inline vfloat vMul(vfloat a, vfloat b) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] *= b.v[l]; return a; }
+static inline vfloat vFma(vfloat a, vfloat b, vfloat c) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] = a.v[l] * b.v[l] + c.v[l]; return a; }
+static inline vfloat vDiv(vfloat a, vfloat b) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] /= b.v[l]; return a; }
+static inline vfloat vMin(vfloat a, vfloat b) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] = a.v[l] < b.v[l] ? a.v[l] : b.v[l]; return a; }
+static inline vfloat vMax(vfloat a, vfloat b) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] = a.v[l] > b.v[l] ? a.v[l] : b.v[l]; return a; }
+static inline vfloat vSqrt(vfloat a) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] = std::sqrt(a.v[l]); return a; }
+static inline vfloat vRsqrt(vfloat a) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] = 1.0f / std::sqrt(a.v[l]); return a; }
+static inline vfloat vAbs(vfloat a) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] = std::fabs(a.v[l]); return a; }
+static inline vfloat vFloor(vfloat a) { for (int l = 0; l < RAY_BATCH_LANES; l++) a.v[l] = std::floor(a.v[l]); return a; }
+static inline vmask vLess(vfloat a, vfloat b) { vmask m = 0; for (int l = 0; l < RAY_BATCH_LANES; l++) if (a.v[l] < b.v[l]) m |= 1u << l; return m; }
+static inline vmask vGreater(vfloat a, vfloat b) { vmask m = 0; for (int l = 0; l < RAY_BATCH_LANES; l++) if (a.v[l] > b.v[l]) m |= 1u << l; return m; }
+static inline vfloat vSelect(vmask m, vfloat a, vfloat b) { for (int l = 0; l < RAY_BATCH_LANES; l++) if (m & (1u << l)) b.v[l] = a.v[l]; return b; }
+static inline vmask vOr(vmask a, vmask b) { return a | b; }
+static inline vmask vAnd(vmask a, vmask b) { return a & b; }
+static inline vmask vAndNot(vmask a, vmask b) { return a & ~b; }
+static inline unsigned vBits(vmask m) { return m; }
+static inline vmask vMaskFromBits(unsigned bits) { return bits; }
+#endif
@@ -0,0 +1,656 @@
+﻿#include "simulation.h"
+#include <cmath>
+#include <algorithm>
+#include <glm/gtc/random.hpp>
+#include <atomic>
+#include "task_pool.h"
+#include "nbody.h"
+
+// --- 설정 변수 ---
+int numRays = 300; // 성능을 위해 1000 -> 300으로 조정 (벤치마크에서 변경 가능)
+float lightSpeed = 30.0f;
+float dt = 0.01f; // 시뮬레이션 스텝 간격 조정
+int maxSteps = 2000; // 광선당 최대 스텝 수 (성능 타협점)
+
+// SoA 광선 배치 엔진 사용 여부 (V 키로 전환, 끄면 기존 스칼라 루프)
+bool useSimdRays = true;
+bool useWavefrontRays = true;
+// 광선 적분기 (I 키로 전환) 와 RK45 허용 오차
+int rayIntegrator = RAY_INTEGRATOR_EULER;
+float rk45Tolerance = 1e-4f;
+// 해석적 탈출 허용 변위 (월드 단위, 0이면 끔, E 키로 전환)
+float escapeTolerance = 0.25f;
+// 천체가 많을 때 Barnes-Hut 옥트리 사용 (B 키로 전환)
+bool useOctree = true;
+float octreeTheta = 0.5f;
+// 가속도장 굽기 모드 (F 키로 전환, 기본 꺼짐)
+bool useAccelField = false;
+// 시간 분할: 세대마다 1/k 광선만 다시 적분 (1이면 끔, T 키로 전환), 나이 제한 (세대)
+int rayAmortizeStride = 1;
+int rayMaxAge = 8;
+// 질량 편집 뒤 그대로 둘 광선의 끝점 변위 허용치 (기본 장면에서 방향키 한 번에 약 30%만 다시 적분, 벤치마크 massEdit)
+float massEditTolerance = 4.0f;
+glm::vec4 lightPosition = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+// --- 전역 변수 ---
+RayPathArena rayPaths; // 모든 광선 경로를 담는 연속 배열
+BodyStore bodies;
+std::vector<glm::vec3> initialVelocities(numRays);
+BodySoA bodySoA; // 광선 적분용으로 펼쳐둔 천체 정보 (매 프레임 갱신)
+BodyOctree bodyOctree; // bodySoA로부터 매 프레임 다시 만드는 트리
+AccelField accelField; // 천체가 바뀔 때만 다시 굽는 가속도 격자
+RayStats lastRayStats;
+static RayPathWriter rayPathWriter; // simulateRay 동안 rayPaths에 쓰는 스레드별 구역
+
+// --- 함수 정의 ---
+
+void setupScene() {
+    clearBodies(bodies);
+
+    // 1. 블랙홀 (광원 주위를 공전)
+    Body blackhole;
+    blackhole.mass = 800.0f; // 질량 키움
+    blackhole.radius = 4.0f;
+    blackhole.color = { 0.1f, 0.1f, 0.1f };
+    blackhole.orbitSpeed = 0.3f;
+    blackhole.rotationSpeed = 0.05f;
+    blackhole.orbitRadius = 50.0f; // 광원(원점)에서의 거리
+    int blackholeIndex = addBody(bodies, blackhole);
+
+    // 2. 중성자별 (블랙홀 주위를 공전)
+    Body neutronStar;
+    neutronStar.mass = 500.0f;
+    neutronStar.radius = 2.0f;
+    neutronStar.color = { 0.4f, 0.4f, 0.9f };
+    neutronStar.parent = blackholeIndex;
+    neutronStar.orbitRadius = 15.0f; // 거리
+    neutronStar.orbitSpeed = 1.0f;   // 공전 속도
+    neutronStar.rotationSpeed = 2.0f;
+    int neutronStarIndex = addBody(bodies, neutronStar);
+
+    // 3. 행성 (중성자별 주위를 공전)
+    Body planet1;
+    planet1.mass = 100.0f;
+    planet1.radius = 1.0f;
+    planet1.color = { 0.8f, 0.3f, 0.3f };
+    planet1.parent = neutronStarIndex;
+    planet1.orbitRadius = 4.0f;
+    planet1.orbitSpeed = 3.0f;
+    planet1.rotationSpeed = 1.0f;
+    addBody(bodies, planet1);
+
+    sortBodyLevels(bodies);
+}
+
+void makeVelocities() {
+    initialVelocities.resize(numRays);
+    for (int i = 0; i < numRays; i++) {
+        // 구면으로 랜덤하게 퍼지는 빛
+        initialVelocities[i] = glm::sphericalRand(1.0f) * lightSpeed;
+    }
+}
+
+void setActiveRayCount(int count) {
+    count = std::max(1, count);
+    // 방향이 균일 난수라 앞쪽 일부만 써도 구면에 고르게 퍼져 있음
+    while ((int)initialVelocities.size() < count) {
+        initialVelocities.push_back(glm::sphericalRand(1.0f) * lightSpeed);
+    }
+    numRays = count;
+}
+
+// 순수 수학으로 위치 업데이트
+void updateBodyPhysics(float currentTime) {
+    if (useNBody) {
+        advanceNBody(currentTime);
+        return;
+    }
+    updateBodyPositions(bodies, currentTime);
+}
+
+// bodies를 SoA 배열로 복사 (용량은 유지하므로 천체 수가 같으면 재할당 없음)
+void packBodies(BodySoA& soa) {
+    int n = bodies.count;
+    soa.x.assign(bodies.x.begin(), bodies.x.end());
+    soa.y.assign(bodies.y.begin(), bodies.y.end());
+    soa.z.assign(bodies.z.begin(), bodies.z.end());
+    soa.mass.assign(bodies.mass.begin(), bodies.mass.end());
+    soa.radiusSq.resize(n);
+    for (int i = 0; i < n; i++) soa.radiusSq[i] = bodies.radius[i] * bodies.radius[i];
+    soa.count = n;
+    computeBodyBounds(soa);
+}
+
+// 광선 적분기가 중력을 구할 때 쓰는 자료 (이번 프레임에 만든 것만 채워짐)
+struct RayScene {
+    const BodySoA* soa;
+    const BodyOctree* tree;  // 없으면 직접 합산
+    const AccelField* field; // 있으면 트리보다 우선
+};
+
+// 한 위치에서의 중력 가속도 합 (모든 적분기가 공유)
+// crashed: 천체 반지름 안쪽이면 true, minDistSq: 가장 가까운 천체까지 거리 제곱
+static inline glm::vec3 computeAcceleration(const RayScene& scene, const glm::vec3& pos, float& minDistSq, bool& crashed) {
+    if (scene.field) return sampleAccelField(*scene.field, pos, minDistSq, crashed);
+    if (scene.tree) return octreeAcceleration(*scene.tree, pos, octreeTheta, minDistSq, crashed);
+
+    const BodySoA& soa = *scene.soa;
+
+    glm::vec3 totalAccel = { 0, 0, 0 };
+    crashed = false;
+    minDistSq = 1e9f;
+
+    for (int b = 0; b < soa.count; b++) {
+        glm::vec3 dir = glm::vec3(soa.x[b], soa.y[b], soa.z[b]) - pos;
+        float distSq = glm::dot(dir, dir);
+
+        if (distSq < soa.radiusSq[b]) {
+            crashed = true;
+            break;
+        }
+
+        if (distSq < minDistSq) minDistSq = distSq;
+
+        // 중력 가속도 F = G * M / r^2 (G=1로 가정, 방향 벡터 정규화 포함)
+        // a = M / r^2 * (dir / r) = M * dir / r^3
+        float dist = sqrt(distSq);
+        float accelMag = soa.mass[b] / (distSq * dist);
+        totalAccel += dir * accelMag * 5.0f; // * 5.0f는 중력 효과 과장을 위한 계수
+    }
+    return totalAccel;
+}
+
+static inline bool isOutsideBox(const glm::vec3& pos) {
+    return std::fabs(pos.x) > 200.0f || std::fabs(pos.y) > 200.0f || std::fabs(pos.z) > 200.0f;
+}
+
+// 기존 오일러 적분 (광선 1개)
+static void traceRayEuler(const RayScene& scene, glm::vec3 startPos, glm::vec3 vel,
+    RayPathWriter& paths, int ray, long long& steps, long long& forceEvals, long long& escapes) {
+    glm::vec3 pos = startPos;
+
+    // 최악의 경우 점 개수만큼 자리를 잡고 실제로 쓴 만큼만 확정
+    int offset = claimRayPath(paths, paths.maxPointsPerRay);
+    if (offset < 0) { deferRayPath(paths, ray); return; }
+    glm::vec3* path = paths.arena->points.data() + offset;
+    int count = 0;
+    path[count++] = pos;
+
+    int step = 0;
+    for (; step < maxSteps; step++) {
+        bool crashed;
+        float minDistSq;
+        glm::vec3 totalAccel = computeAcceleration(scene, pos, minDistSq, crashed);
+        forceEvals++;
+
+        if (crashed) break;
+
+        // 가변 dt (천체 근처에서는 정밀하게, 멀면 빠르게)
+        float currentDt = dt;
+        if (minDistSq > 500.0f) currentDt *= 2.0f;
+        if (minDistSq > 2000.0f) currentDt *= 4.0f;
+
+        vel += totalAccel * currentDt;
+        pos += vel * currentDt;
+
+        // 경계 체크
+        if (isOutsideBox(pos)) break;
+
+        // 너무 촘촘하게 저장하면 그리기 느려짐, 일정 간격마다 저장
+        if (step % 10 == 0) path[count++] = pos;
+
+        // 중력권을 벗어났으면 남은 직선 구간은 한 번에 처리 (SIMD 엔진과 같이 8 스텝마다)
+        if (escapeTolerance > 0.0f && (step & 7) == 7 && tryAnalyticEscape(*scene.soa, pos, vel, escapeTolerance)) {
+            escapes++;
+            break;
+        }
+    }
+    // 마지막 위치 저장
+    path[count++] = pos;
+    commitRayPath(paths, ray, offset, count);
+    steps += (step < maxSteps) ? step + 1 : maxSteps; // 중간 종료 시 종료 스텝까지 포함
+}
+
+// --- Dormand-Prince RK45 (적응형 스텝) ---
+// 상태 y = (pos, vel), y' = (vel, a(pos))
+// 5차 해로 진행하고 4차 해와의 차이로 오차를 추정해서 스텝 크기를 조절함
+// 중력이 약한 곳에서는 큰 스텝, 천체 근처에서만 작은 스텝을 씀
+static const float DP_A[7][6] = {
+    { 0 },
+    { 1.0f / 5.0f },
+    { 3.0f / 40.0f, 9.0f / 40.0f },
+    { 44.0f / 45.0f, -56.0f / 15.0f, 32.0f / 9.0f },
+    { 19372.0f / 6561.0f, -25360.0f / 2187.0f, 64448.0f / 6561.0f, -212.0f / 729.0f },
+    { 9017.0f / 3168.0f, -355.0f / 33.0f, 46732.0f / 5247.0f, 49.0f / 176.0f, -5103.0f / 18656.0f },
+    { 35.0f / 384.0f, 0.0f, 500.0f / 1113.0f, 125.0f / 192.0f, -2187.0f / 6784.0f, 11.0f / 84.0f },
+};
+// 5차 해 - 4차 해 (오차 추정 계수)
+static const float DP_E[7] = {
+    71.0f / 57600.0f, 0.0f, -71.0f / 16695.0f, 71.0f / 1920.0f, -17253.0f / 339200.0f, 22.0f / 525.0f, -1.0f / 40.0f
+};
+
+static void traceRayRK45(const RayScene& scene, glm::vec3 startPos, glm::vec3 vel,
+    RayPathWriter& paths, int ray, long long& steps, long long& forceEvals, long long& escapes) {
+    glm::vec3 pos = startPos;
+
+    int offset = claimRayPath(paths, paths.maxPointsPerRay);
+    if (offset < 0) { deferRayPath(paths, ray); return; }
+    glm::vec3* path = paths.arena->points.data() + offset;
+    int count = 0;
+    path[count++] = pos;
+
+    // 한 스텝에 이동할 수 있는 최대 거리 (경로 그리기 해상도 유지용)
+    const float maxStepLength = 50.0f;
+    const float hMin = dt * 0.01f;
+    float h = dt;
+
+    glm::vec3 kp[7], kv[7]; // 각 단계의 위치/속도 미분
+    bool crashed;
+    float minDistSq;
+    kp[0] = vel;
+    kv[0] = computeAcceleration(scene, pos, minDistSq, crashed);
+    forceEvals++;
+
+    int attempt = 0;
+    while (!crashed && attempt < maxSteps) {
+        attempt++;
+        float speed = glm::length(vel);
+        if (speed > 0.0f) h = std::min(h, maxStepLength / speed);
+
+        // 2~7단계 (7단계는 새 위치에서의 미분 -> 다음 스텝의 1단계로 재사용, FSAL)
+        bool stageCrashed = false;
+        for (int s = 1; s < 7; s++) {
+            glm::vec3 sp = pos, sv = vel;
+            for (int j = 0; j < s; j++) {
+                sp += kp[j] * (h * DP_A[s][j]);
+                sv += kv[j] * (h * DP_A[s][j]);
+            }
+            bool stageHit;
+            kp[s] = sv;
+            kv[s] = computeAcceleration(scene, sp, minDistSq, stageHit);
+            forceEvals++;
+            if (stageHit) { stageCrashed = true; if (s < 6) break; }
+        }
+
+        // 천체 내부를 지나는 스텝은 스텝을 줄여 다시 시도 (더 못 줄이면 충돌로 처리)
+        if (stageCrashed) {
+            if (h > hMin) {
+                h = std::max(h * 0.25f, hMin);
+                continue;
+            }
+            crashed = true;
+            break;
+        }
+
+        glm::vec3 newPos = pos, newVel = vel;
+        for (int j = 0; j < 6; j++) {
+            newPos += kp[j] * (h * DP_A[6][j]);
+            newVel += kv[j] * (h * DP_A[6][j]);
+        }
+
+        // 오차 추정 (위치/속도 각각 상대+절대 허용오차로 정규화)
+        glm::vec3 errPos(0.0f), errVel(0.0f);
+        for (int j = 0; j < 7; j++) {
+            errPos += kp[j] * (h * DP_E[j]);
+            errVel += kv[j] * (h * DP_E[j]);
+        }
+        float scalePos = rk45Tolerance * (1.0f + glm::length(newPos));
+        float scaleVel = rk45Tolerance * (1.0f + glm::length(newVel));
+        float err = std::max(glm::length(errPos) / scalePos, glm::length(errVel) / scaleVel);
+
+        // 다음 스텝 크기: h * 0.9 * err^(-1/5), 한 번에 0.2~5배로 제한
+        float factor = (err > 0.0f) ? 0.9f * std::pow(err, -0.2f) : 5.0f;
+        factor = std::min(5.0f, std::max(0.2f, factor));
+
+        if (err > 1.0f && h > hMin) {
+            h = std::max(h * factor, hMin); // 거절: 같은 위치에서 작은 스텝으로 재시도
+            continue;
+        }
+
+        // 수락
+        pos = newPos;
+        vel = newVel;
+        kp[0] = kp[6];
+        kv[0] = kv[6];
+        h *= factor;
+        path[count++] = pos;
+
+        if (isOutsideBox(pos)) break;
+        if (escapeTolerance > 0.0f && tryAnalyticEscape(*scene.soa, pos, vel, escapeTolerance)) {
+            path[count++] = pos;
+            escapes++;
+            break;
+        }
+    }
+    commitRayPath(paths, ray, offset, count);
+    steps += attempt;
+}
+
+// 광선 하나가 남길 수 있는 최대 점 개수
+// 오일러: 시작점 + 10 스텝마다 + 끝점, RK45: 시작점 + 수락한 스텝마다 + 탈출 지점
+static int maxRayPathPoints() {
+    if (rayIntegrator == RAY_INTEGRATOR_RK45) return maxSteps + 2;
+    return (maxSteps + 9) / 10 + 2;
+}
+
+// 스칼라 적분에서 작업 하나가 맡는 광선 수 (광선마다 스텝 수가 크게 달라서 작게 나누고 나머지는 작업 훔치기로 맞춤)
+static const int SCALAR_RAY_TASK_RAYS = 8;
+
+// velocities[0, count) 광선을 적분해서 paths에 기록 (광선 번호는 velocities 인덱스)
+static void integrateRays(const RayScene& scene, bool simdEuler, glm::vec3 startPos,
+    const std::vector<glm::vec3>& velocities, int count, RayPathArena& paths) {
+    // 아레나 용량은 프레임 사이에 유지되므로 평소에는 재할당 없음
+    beginRayPaths(rayPathWriter, paths, count, maxRayPathPoints());
+
+    if (simdEuler && !scene.tree && !scene.field) {
+        auto engine = useWavefrontRays ? simulateRayWavefront : simulateRayBatch;
+        lastRayStats.steps = engine(*scene.soa, startPos, velocities, count, maxSteps, dt,
+            escapeTolerance, rayPathWriter, lastRayStats.escapes);
+        lastRayStats.forceEvals = lastRayStats.steps;
+    }
+    else {
+        // 아레나가 모자라서 미뤄진 광선은 용량을 늘린 뒤 그 광선만 다시 적분
+        std::atomic<long long> totalSteps(0), totalEvals(0), totalEscapes(0);
+        bool retry = false;
+        do {
+            parallelFor(count, SCALAR_RAY_TASK_RAYS, [&](int begin, int end) {
+                long long steps = 0, evals = 0, escapes = 0;
+                for (int i = begin; i < end; i++) {
+                    if (retry && paths.count[i] >= 0) continue;
+                    if (rayIntegrator == RAY_INTEGRATOR_RK45) {
+                        traceRayRK45(scene, startPos, velocities[i], rayPathWriter, i, steps, evals, escapes);
+                    }
+                    else {
+                        traceRayEuler(scene, startPos, velocities[i], rayPathWriter, i, steps, evals, escapes);
+                    }
+                }
+                totalSteps += steps;
+                totalEvals += evals;
+                totalEscapes += escapes;
+            });
+            retry = true;
+        } while (finishRayPaths(rayPathWriter));
+        lastRayStats.steps = totalSteps;
+        lastRayStats.forceEvals = totalEvals;
+        lastRayStats.escapes = totalEscapes;
+    }
+}
+
+// --- 광선별 천체 영향 ---
+// 박스 안에서 끝난 광선(천체에 충돌 / 스텝 소진)은 조금만 비껴가도 박스 끝까지 날아갈 수 있으므로 남은 경로에 이만큼 더함
+static const float RAY_BOX_HALF_SIZE = 200.0f;
+// 영향 기록에서 작업 하나가 맡는 광선 수 (광선마다 점 수가 비슷해서 적분보다 크게 나눔)
+static const int INFLUENCE_TASK_RAYS = 32;
+
+// 경로 점 사이를 직선으로 보고 선분마다 천체 중심에 가장 가까운 점을 찾음 (천체 수만큼 한 줄)
+static void recordInfluenceRow(const BodySoA& soa, RayPathView path, float* closest, float* remaining) {
+    const int n = soa.count;
+    float bestSq[RAY_INFLUENCE_MAX_BODIES];
+    float bestArc[RAY_INFLUENCE_MAX_BODIES]; // 최근접 지점까지의 경로 길이
+    for (int b = 0; b < n; b++) {
+        float dx = soa.x[b] - path[0].x, dy = soa.y[b] - path[0].y, dz = soa.z[b] - path[0].z;
+        bestSq[b] = dx * dx + dy * dy + dz * dz;
+        bestArc[b] = 0.0f;
+    }
+    float arc = 0.0f;
+    for (int k = 1; k < path.count; k++) {
+        const glm::vec3 a = path[k - 1];
+        const glm::vec3 seg = path[k] - a;
+        const float lenSq = glm::dot(seg, seg);
+        if (lenSq <= 0.0f) continue;
+        const float len = std::sqrt(lenSq);
+        const float invLenSq = 1.0f / lenSq;
+        for (int b = 0; b < n; b++) {
+            float tx = soa.x[b] - a.x, ty = soa.y[b] - a.y, tz = soa.z[b] - a.z;
+            float t = std::min(1.0f, std::max(0.0f, (tx * seg.x + ty * seg.y + tz * seg.z) * invLenSq));
+            float dx = tx - seg.x * t, dy = ty - seg.y * t, dz = tz - seg.z * t;
+            float distSq = dx * dx + dy * dy + dz * dz;
+            if (distSq < bestSq[b]) {
+                bestSq[b] = distSq;
+                bestArc[b] = arc + t * len;
+            }
+        }
+        arc += len;
+    }
+    const glm::vec3& end = path.back();
+    float reach = std::max(std::fabs(end.x), std::max(std::fabs(end.y), std::fabs(end.z)));
+    float extra = (reach < RAY_BOX_HALF_SIZE - 1.0f) ? RAY_BOX_HALF_SIZE : 0.0f;
+    for (int b = 0; b < n; b++) {
+        closest[b] = std::sqrt(bestSq[b]);
+        remaining[b] = arc - bestArc[b] + extra;
+    }
+}
+
+// 기록할 천체 수 (너무 많으면 0 = 기록 안 함)
+static int influenceBodyCount(const BodySoA& soa) {
+    return (soa.count <= RAY_INFLUENCE_MAX_BODIES) ? soa.count : 0;
+}
+
+static void resizeInfluence(RayInfluence& influence, int bodyCount, int rays) {
+    influence.bodyCount = bodyCount;
+    influence.closest.resize((size_t)rays * bodyCount);
+    influence.remaining.resize((size_t)rays * bodyCount);
+    influence.drift.resize(rays, 0.0f);
+}
+
+// paths의 j번 경로를 influence의 rows[j]번 광선 기록으로 (rows가 없으면 j번, drift는 그대로 둠)
+static void recordInfluenceRows(const BodySoA& soa, const RayPathArena& paths, int count, const int* rows, RayInfluence& influence) {
+    const int n = influence.bodyCount;
+    parallelFor(count, INFLUENCE_TASK_RAYS, [&](int begin, int end) {
+        for (int j = begin; j < end; j++) {
+            int ray = rows ? rows[j] : j;
+            recordInfluenceRow(soa, paths.path(j), &influence.closest[(size_t)ray * n], &influence.remaining[(size_t)ray * n]);
+        }
+    });
+}
+
+void recordRayInfluence(const BodySoA& soa, const RayPathArena& paths, RayInfluence& influence) {
+    resizeInfluence(influence, influenceBodyCount(soa), paths.numPaths);
+    influence.drift.assign(paths.numPaths, 0.0f);
+    if (influence.bodyCount > 0) recordInfluenceRows(soa, paths, paths.numPaths, nullptr, influence);
+}
+
+// --- 일부 광선만 다시 적분 (시간 분할 / 질량 편집) ---
+static RayPathArena rayPathHistory; // 지난 세대 출력 사본 (재사용할 경로)
+static RayInfluence rayInfluenceHistory; // rayPathHistory 광선들의 영향 기록 (질량 편집 때 채움, drift만 세대를 넘어 유지)
+static std::vector<BodySoA> stripeLayouts; // stripeLayouts[a] = a세대 전 천체 배치 (나이 a인 광선이 지나간 배치)
+static RayPathArena freshPaths;    // 이번에 다시 적분한 광선
+static std::vector<int> rayAges;    // 광선별로 마지막 적분 후 지난 세대 수
+static std::vector<int> freshRays; // freshPaths의 j번 경로 = freshRays[j]번 광선 (오름차순)
+static std::vector<glm::vec3> freshVelocities;
+static std::vector<int> massEditRays;
+static int stripePhase = 0;
+
+void invalidateRayHistory() {
+    rayPathHistory.numPaths = 0;
+}
+
+static void copyRayPaths(RayPathArena& dst, const RayPathArena& src) {
+    // assign은 용량이 충분하면 재할당하지 않음
+    dst.points.assign(src.points.begin(), src.points.begin() + src.used);
+    dst.first.assign(src.first.begin(), src.first.begin() + src.numPaths);
+    dst.count.assign(src.count.begin(), src.count.begin() + src.numPaths);
+    dst.numPaths = src.numPaths;
+    dst.used = src.used;
+}
+
+// freshRays만 적분해서 freshPaths에 기록
+static void integrateFreshRays(const RayScene& scene, bool simdEuler, glm::vec3 startPos) {
+    freshVelocities.clear();
+    for (int i : freshRays) freshVelocities.push_back(initialVelocities[i]);
+    integrateRays(scene, simdEuler, startPos, freshVelocities, (int)freshRays.size(), freshPaths);
+}
+
+// 출력 아레나를 새 경로(freshPaths) + previous 경로로 빈칸 없이 다시 채움
+static void mergeRayPaths(const RayPathArena& previous) {
+    const int m = (int)freshRays.size();
+    long long total = 0;
+    for (int j = 0, i = 0; i < numRays; i++) {
+        bool fresh = (j < m && freshRays[j] == i);
+        total += fresh ? freshPaths.count[j++] : previous.count[i];
+    }
+    if ((long long)rayPaths.points.size() < total) rayPaths.points.resize((size_t)total);
+    rayPaths.first.resize(numRays);
+    rayPaths.count.resize(numRays);
+
+    int offset = 0;
+    for (int j = 0, i = 0; i < numRays; i++) {
+        RayPathView src = (j < m && freshRays[j] == i) ? freshPaths.path(j++) : previous.path(i);
+        std::copy(src.begin(), src.end(), rayPaths.points.begin() + offset);
+        rayPaths.first[i] = offset;
+        rayPaths.count[i] = src.count;
+        offset += src.count;
+    }
+    rayPaths.numPaths = numRays;
+    rayPaths.used = offset;
+    lastRayStats.reusedRays = numRays - m;
+}
+
+static void integrateRayStripe(const RayScene& scene, bool simdEuler, glm::vec3 startPos) {
+    const int k = rayAmortizeStride;
+    if (stripePhase >= k) stripePhase = 0;
+    // 영향 기록은 질량을 편집할 때만 필요하므로 여기서는 세대별 천체 배치만 보관 (가장 오래된 배치 자리에 이번 배치를 복사)
+    stripeLayouts.resize(std::max(rayMaxAge, 0) + 1);
+    std::rotate(stripeLayouts.begin(), stripeLayouts.end() - 1, stripeLayouts.end());
+    stripeLayouts[0] = *scene.soa;
+    rayInfluenceHistory.drift.resize(numRays, 0.0f);
+    const int historyRays = rayPathHistory.numPaths;
+    if ((int)rayAges.size() < numRays) rayAges.resize(numRays, 0);
+
+    // 이번 줄무늬 + 나이 제한에 걸린 광선(질량 편집으로 표시된 광선 포함) + 기록이 없는 광선 (새로 늘어났거나 설정이 바뀐 뒤)
+    freshRays.clear();
+    for (int i = 0; i < numRays; i++) {
+        if (i % k == stripePhase || rayAges[i] >= rayMaxAge || i >= historyRays) {
+            freshRays.push_back(i);
+            rayAges[i] = 0;
+            rayInfluenceHistory.drift[i] = 0.0f;
+        }
+        else {
+            rayAges[i]++;
+        }
+    }
+    stripePhase = (stripePhase + 1) % k;
+
+    integrateFreshRays(scene, simdEuler, startPos);
+    mergeRayPaths(rayPathHistory);
+    copyRayPaths(rayPathHistory, rayPaths);
+}
+
+// 이번 프레임 천체 배치로 bodySoA와 (설정에 따라) 옥트리 / 가속도장을 준비
+static RayScene prepareRayScene(bool& simdEuler) {
+    packBodies(bodySoA);
+
+    // 천체가 많으면 옥트리를 만들어서 스칼라 적분기에 넘김 (SIMD 엔진은 직접 합산 전용)
+    // 가속도장 모드는 천체가 바뀐 프레임에만 옥트리를 만들고 다시 구움
+    simdEuler = useSimdRays && rayIntegrator == RAY_INTEGRATOR_EULER;
+    RayScene scene = { &bodySoA, nullptr, nullptr };
+    lastRayStats.bakedField = false;
+    lastRayStats.reusedRays = 0;
+    if (useAccelField && bodySoA.count > 0) {
+        if (!isAccelFieldCurrent(accelField, bodySoA, octreeTheta)) {
+            buildBodyOctree(bodyOctree, bodySoA);
+            bakeAccelField(accelField, bodySoA, bodyOctree, octreeTheta);
+            lastRayStats.bakedField = true;
+        }
+        scene.field = &accelField;
+    }
+    else if (useOctree && bodySoA.count >= (simdEuler ? OCTREE_MIN_BODIES_SIMD : OCTREE_MIN_BODIES)) {
+        buildBodyOctree(bodyOctree, bodySoA);
+        scene.tree = &bodyOctree;
+    }
+    lastRayStats.usedOctree = (scene.tree != nullptr);
+    lastRayStats.usedField = (scene.field != nullptr);
+    return scene;
+}
+
+void simulateRay(glm::vec3 startPos, bool allowAmortize) {
+    bool simdEuler;
+    RayScene scene = prepareRayScene(simdEuler);
+
+    if (allowAmortize && rayAmortizeStride > 1) {
+        integrateRayStripe(scene, simdEuler, startPos);
+        return;
+    }
+    // 모든 광선을 매번 적분 (다음에 분할 모드를 켜면 처음부터 다시 채움)
+    invalidateRayHistory();
+    integrateRays(scene, simdEuler, startPos, initialVelocities, numRays, rayPaths);
+}
+
+bool selectMassEditRays(RayInfluence& influence, int body, float deltaMass, std::vector<int>& stale) {
+    stale.clear();
+    const int n = influence.bodyCount;
+    if (n <= 0 || n != bodies.count || body < 0 || body >= n) return false;
+
+    // 천체 b를 거리 r로 지나는 광선은 약 10M / (r v^2)만큼 꺾임 (5는 중력 과장 계수, 직선 근사)
+    // 질량이 dm만큼 바뀌면 꺾이는 각도가 10|dm| / (r v^2)만큼 달라지고 끝점은 남은 경로 길이만큼 곱해서 움직임
+    // 편집한 천체 자신과 그 뒤에 지나간 천체들에서 크게 꺾인 광선일수록 작은 어긋남이 더 벌어짐 (렌즈 증폭)
+    // 편집한 천체는 편집 전후 중 큰 질량으로 잼
+    const float k = 10.0f / (lightSpeed * lightSpeed);
+    std::vector<float> bend(n);
+    for (int b = 0; b < n; b++) bend[b] = k * bodies.mass[b];
+    bend[body] = k * std::max(bodies.mass[body], bodies.mass[body] - deltaMass);
+    const float change = k * std::fabs(deltaMass);
+
+    const int count = (int)influence.drift.size();
+    for (int i = 0; i < count; i++) {
+        const float* r = &influence.closest[(size_t)i * n];
+        const float* length = &influence.remaining[(size_t)i * n];
+        const float re = std::max(r[body], 1e-3f);
+        float after = 1.0f;
+        for (int b = 0; b < n; b++) {
+            if (b != body && length[b] < length[body]) after += bend[b] / std::max(r[b], 1e-3f);
+        }
+        float estimate = change / re * length[body] * (1.0f + bend[body] / re) * after;
+        if (influence.drift[i] + estimate > massEditTolerance) {
+            stale.push_back(i);
+        }
+        else {
+            influence.drift[i] += estimate;
+        }
+    }
+    return true;
+}
+
+void resimulateRays(glm::vec3 startPos, const std::vector<int>& stale, const RayPathArena& previous, RayInfluence& influence) {
+    bool simdEuler;
+    RayScene scene = prepareRayScene(simdEuler);
+    freshRays = stale;
+    integrateFreshRays(scene, simdEuler, startPos);
+    if (influence.bodyCount > 0 && influence.bodyCount == scene.soa->count) {
+        recordInfluenceRows(*scene.soa, freshPaths, (int)freshRays.size(), freshRays.data(), influence);
+    }
+    for (int i : stale) {
+        if (i < (int)influence.drift.size()) influence.drift[i] = 0.0f;
+    }
+    mergeRayPaths(previous);
+}
+
+void applyMassEditToRayHistory(int body, float deltaMass) {
+    const int historyRays = rayPathHistory.numPaths;
+    if (historyRays == 0) return;
+    // 광선마다 마지막으로 적분한 세대의 배치로 영향을 기록 (천체 수가 그 사이에 바뀌었으면 기록할 수 없음)
+    const int bodyCount = stripeLayouts.empty() ? 0 : influenceBodyCount(stripeLayouts[0]);
+    resizeInfluence(rayInfluenceHistory, bodyCount, historyRays);
+    bool recorded = (bodyCount > 0 && (int)rayAges.size() >= historyRays);
+    for (int i = 0; recorded && i < historyRays; i++) {
+        int age = rayAges[i];
+        recorded = (age < (int)stripeLayouts.size() && stripeLayouts[age].count == bodyCount);
+    }
+    if (recorded) {
+        parallelFor(historyRays, INFLUENCE_TASK_RAYS, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                recordInfluenceRow(stripeLayouts[rayAges[i]], rayPathHistory.path(i),
+                    &rayInfluenceHistory.closest[(size_t)i * bodyCount], &rayInfluenceHistory.remaining[(size_t)i * bodyCount]);
+            }
+        });
+    }
+    if (!recorded || !selectMassEditRays(rayInfluenceHistory, body, deltaMass, massEditRays) ||
+        (int)massEditRays.size() >= rayPathHistory.numPaths) {
+        invalidateRayHistory();
+        return;
+    }
+    // 다음 세대에 줄무늬와 상관없이 다시 적분
+    for (int i : massEditRays) {
+        if (i < (int)rayAges.size()) rayAges[i] = rayMaxAge;
+    }
+}
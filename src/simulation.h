@@ -0,0 +1,96 @@
+﻿#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "ray_batch.h"
+#include "octree.h"
+#include "accel_field.h"
+#include "ray_path_arena.h"
+#include "body_store.h"
+
+// --- 시뮬레이션 코어 ---
+// 천체 궤도 계산과 광선 적분만 담당 (GLUT/OpenGL 의존성 없음)
+// main.cpp(렌더링)와 benchmark.cpp(헤드리스 측정)가 같이 사용함
+
+// 마지막 simulateRay 호출의 작업량 (벤치마크/디버깅용)
+struct RayStats {
+    long long steps = 0; // 모든 광선이 실제로 진행한 스텝 수 합 (RK45는 거절된 시도 포함)
+    long long forceEvals = 0; // 중력 합산(천체 루프) 횟수
+    long long escapes = 0; // 해석적 탈출로 끝낸 광선 수
+    bool usedOctree = false; // 중력 합산에 옥트리를 썼는지
+    bool usedField = false;  // 구워둔 가속도장을 읽었는지
+    bool bakedField = false; // 이번 호출에서 가속도장을 새로 구웠는지
+    int reusedRays = 0;      // 시간 분할 모드에서 지난 세대 경로를 그대로 쓴 광선 수
+};
+
+// 광선별 천체 영향 기록 (질량을 바꿨을 때 다시 적분할 광선을 고르는 데 씀)
+// 적분이 끝난 경로 점과 그때의 천체 배치로 계산하므로 적분 엔진(스칼라 / SIMD / RK45 / 옥트리 / 가속도장)과 상관없음
+// 천체가 RAY_INFLUENCE_MAX_BODIES개보다 많으면 기록하지 않음 (bodyCount = 0, 질량을 바꾸면 전부 다시 적분)
+struct RayInfluence {
+    int bodyCount = 0;
+    std::vector<float> closest;   // [ray * bodyCount + b]: 천체 b 중심에 가장 가까이 간 거리 r (b가 준 최대 가속도 5M / r^2)
+    std::vector<float> remaining; // [ray * bodyCount + b]: 그 지점부터 끝점까지 경로 길이 (박스 안에서 끝난 광선은 박스 크기를 더함)
+    std::vector<float> drift;     // 광선별: 다시 적분하지 않고 넘긴 질량 편집들의 끝점 변위 추정 합
+};
+
+const int RAY_INFLUENCE_MAX_BODIES = 256;
+
+// 광선 적분 방식
+enum RayIntegrator {
+    RAY_INTEGRATOR_EULER = 0, // 기존 가변 dt 오일러 (SIMD 엔진 지원)
+    RAY_INTEGRATOR_RK45 = 1,  // Dormand-Prince 적응형 스텝
+};
+
+// --- 설정 변수 ---
+extern int numRays;
+extern float lightSpeed;
+extern float dt;
+extern int maxSteps;
+extern bool useSimdRays;
+extern bool useWavefrontRays; // SIMD 엔진을 묶음 대신 웨이브프런트로 돌림 (결과는 같음)
+extern int rayIntegrator;
+extern float rk45Tolerance; // 스텝당 상대 오차 허용치
+extern float escapeTolerance; // 해석적 탈출 허용 변위 (0이면 끔)
+extern bool useOctree; // 천체가 OCTREE_MIN_BODIES 이상이면 Barnes-Hut 트리 사용
+extern float octreeTheta; // 열림 각도 (작을수록 정확, 0이면 직접 합산과 같음)
+extern bool useAccelField; // 가속도장을 격자에 구워서 보간으로 읽음 (천체가 멈춰 있을 때 유리)
+// 시간 분할: 1보다 크면 세대마다 광선 i % k == 회전 위상인 줄무늬만 다시 적분하고 나머지는 지난 경로를 씀
+// (같은 비용으로 k배 많은 광선), rayMaxAge 세대 넘게 다시 적분하지 않은 광선은 줄무늬와 상관없이 적분
+extern int rayAmortizeStride;
+extern int rayMaxAge;
+// 질량 편집 뒤 끝점 변위 추정이 이보다 작은 광선은 지난 경로를 그대로 씀 (월드 단위, 박스 반지름 200 기준)
+extern float massEditTolerance;
+extern glm::vec4 lightPosition;
+
+// --- 시뮬레이션 상태 ---
+extern BodyStore bodies; // 계층 단계 순서 (천체 번호 = 이 배열의 번호)
+extern RayPathArena rayPaths;
+extern std::vector<glm::vec3> initialVelocities;
+extern BodySoA bodySoA;
+extern BodyOctree bodyOctree;
+extern AccelField accelField;
+extern RayStats lastRayStats;
+
+void setupScene();
+void makeVelocities();
+// 활성 광선 수 변경 (품질 조절기용): 늘릴 때는 기존 방향을 그대로 두고 새 방향만 추가해서 광선이 튀지 않게 함
+void setActiveRayCount(int count);
+// 시각 currentTime의 공전 위치로 bodies 갱신 (단계별 벡터 루프, body_store 참고, useNBody면 그 시각까지 N체 적분)
+void updateBodyPhysics(float currentTime);
+void packBodies(BodySoA& soa);
+// allowAmortize가 false면 rayAmortizeStride와 상관없이 모든 광선을 적분 (위상 캐시가 완전한 경로 집합을 저장할 때)
+void simulateRay(glm::vec3 startPos, bool allowAmortize = true);
+// 재사용할 지난 경로를 버림 (적분 설정이 바뀌어서 이전 경로와 섞이면 안 될 때)
+void invalidateRayHistory();
+
+// --- 질량 편집 후 일부 광선만 다시 적분 ---
+// paths의 모든 광선에 대해 soa 천체 배치 기준 영향을 기록 (drift는 0으로)
+void recordRayInfluence(const BodySoA& soa, const RayPathArena& paths, RayInfluence& influence);
+// body의 질량이 deltaMass만큼 바뀐 뒤 호출: 끝점 변위 추정이 massEditTolerance를 넘는 광선 번호를 stale에 (오름차순)
+// 추정 = 10|dm| / (v^2 r) (r을 지나며 꺾이는 각도) x 남은 경로 x (1 + 편집한 천체의 굴절각) x (1 + 그 뒤에 지나간 다른 천체들의 굴절각 합)
+// 나머지 광선은 drift에 추정을 더해 두고 합이 허용치를 넘는 편집에서 다시 적분, 기록이 없으면 false (전부 다시 적분해야 함)
+bool selectMassEditRays(RayInfluence& influence, int body, float deltaMass, std::vector<int>& stale);
+// stale 광선만 지금 천체 배치로 다시 적분하고 나머지는 previous 경로를 그대로 써서 rayPaths를 채움
+// (previous는 numRays개 광선을 모두 담고 있어야 함, influence의 stale 광선 기록도 새로 쓰고 drift는 0으로)
+void resimulateRays(glm::vec3 startPos, const std::vector<int>& stale, const RayPathArena& previous, RayInfluence& influence);
+// 시간 분할 기록에 질량 편집 반영: 민감한 광선만 다음 세대에 줄무늬와 상관없이 다시 적분 (기록이 없으면 전부 버림)
+void applyMassEditToRayHistory(int body, float deltaMass);
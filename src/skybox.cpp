@@ -0,0 +1,115 @@
+﻿#include "gl_common.h"
+#include "skybox.h"
+#include <iostream>
+#include "image.h"
+
+bool useSkybox = true;
+
+static GLuint cubeTexture = 0;
+static bool cubeLoaded = false;
+
+// 근평면(1)과 원평면(500) 사이에 들어가는 크기 (꼭짓점 거리 = 100 * sqrt(3))
+static const float SKYBOX_HALF_SIZE = 100.0f;
+
+static const float cubeVertices[8][3] = {
+    { -1, -1, -1 }, { 1, -1, -1 }, { 1, 1, -1 }, { -1, 1, -1 },
+    { -1, -1,  1 }, { 1, -1,  1 }, { 1, 1,  1 }, { -1, 1,  1 },
+};
+
+// 안쪽에서 보므로 감김 방향은 상관없음 (컬링을 쓰지 않음)
+static const unsigned char cubeIndices[36] = {
+    0, 1, 2, 0, 2, 3, // -Z
+    4, 6, 5, 4, 7, 6, // +Z
+    0, 3, 7, 0, 7, 4, // -X
+    1, 5, 6, 1, 6, 2, // +X
+    0, 4, 5, 0, 5, 1, // -Y
+    3, 2, 6, 3, 6, 7, // +Y
+};
+
+bool initSkybox(const char* const faceFiles[SKYBOX_FACES]) {
+    if (!hasGLVersion(1, 3) && !hasGLExtension("GL_ARB_texture_cube_map")) return false;
+
+    glGenTextures(1, &cubeTexture);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubeTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    bool ok = true;
+    for (int face = 0; face < SKYBOX_FACES && ok; face++) {
+        Image image;
+        if (!loadImageFile(faceFiles[face], image)) {
+            std::cerr << "Failed to load skybox face: " << faceFiles[face] << std::endl;
+            ok = false;
+            break;
+        }
+        // 하늘은 불투명이라 알파는 버리고 RGB로 저장
+        GLenum format = (image.channels == 4) ? GL_RGBA : GL_RGB;
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB, image.width, image.height, 0,
+            format, GL_UNSIGNED_BYTE, image.pixels);
+        freeImage(image);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // 면 해상도가 화면보다 낮아서 항상 확대되므로 밉맵 없이 선형 필터
+    // 가장자리는 CLAMP_TO_EDGE로 해야 면 경계에 이음새가 보이지 않음
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    if (!ok) {
+        shutdownSkybox();
+        return false;
+    }
+    cubeLoaded = true;
+    return true;
+}
+
+void shutdownSkybox() {
+    if (cubeTexture != 0) glDeleteTextures(1, &cubeTexture);
+    cubeTexture = 0;
+    cubeLoaded = false;
+}
+
+bool skyboxReady() {
+    return useSkybox && cubeLoaded;
+}
+
+void drawSkybox(float brightness) {
+    if (!skyboxReady()) return;
+
+    // 카메라 위치 제거(회전만 유지)
+    glPushMatrix();
+    GLfloat mv[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+    mv[12] = mv[13] = mv[14] = 0.0f;
+    glLoadMatrixf(mv);
+    glScalef(SKYBOX_HALF_SIZE, SKYBOX_HALF_SIZE, SKYBOX_HALF_SIZE);
+
+    // 모든 조각의 깊이를 1.0으로 고정: 지워진 채로 남은 픽셀(깊이 1.0)만 GL_LEQUAL을 통과
+    glDepthRange(1.0, 1.0);
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_LIGHTING);
+    glEnable(GL_TEXTURE_CUBE_MAP);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubeTexture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glColor3f(brightness, brightness, brightness);
+
+    // 방향 벡터가 곧 큐브맵 좌표라 정점 배열을 텍스처 좌표로도 씀
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, cubeVertices);
+    glTexCoordPointer(3, GL_FLOAT, 0, cubeVertices);
+    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, cubeIndices);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    glDisable(GL_TEXTURE_CUBE_MAP);
+    glEnable(GL_LIGHTING);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+    glDepthRange(0.0, 1.0);
+    glPopMatrix();
+}
@@ -0,0 +1,24 @@
+﻿#pragma once
+
+// --- 큐브맵 스카이박스 ---
+// 여섯 면(px, nx, py, ny, pz, nz) 이미지를 GL_TEXTURE_CUBE_MAP 하나에 올리고
+// 정육면체 하나를 그리기 호출 한 번으로 그림 (텍스처 좌표 = 정점 방향)
+// 깊이를 먼 평면(1.0)에 고정하고 불투명 물체 뒤에 그리므로 가려진 픽셀은 깊이 테스트에서 바로 버려짐
+// 8K 등장방형 스카이돔(gluSphere 64x64 + 최대 수백 MB 텍스처) 대신 사용
+
+const int SKYBOX_FACES = 6;
+
+// GL_TEXTURE_CUBE_MAP_POSITIVE_X부터의 순서 (+X, -X, +Y, -Y, +Z, -Z)
+// GL 컨텍스트를 만든 뒤 호출, 큐브맵을 못 쓰거나 면 하나라도 읽지 못하면 false
+bool initSkybox(const char* const faceFiles[SKYBOX_FACES]);
+void shutdownSkybox();
+
+// 큐브맵이 올라와 있고 켜져 있는지
+bool skyboxReady();
+
+// 현재 모델뷰의 회전만 사용해서 그림 (불투명 물체 다음, 가산 블렌딩 효과 전에 호출)
+// brightness: 색에 곱하는 밝기 (GL_MODULATE)
+void drawSkybox(float brightness);
+
+// 켜져 있으면 큐브맵, 꺼져 있으면 기존 스카이돔 (비교용)
+extern bool useSkybox;
@@ -0,0 +1,163 @@
+﻿#include "gl_common.h"
+#include "sphere_mesh.h"
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+// 단위 구라서 위치가 곧 법선 (glNormalPointer도 같은 배열을 가리킴)
+struct SphereVertex {
+    float x, y, z;
+    float s, t;
+};
+
+struct SphereLod {
+    int slices = 0;
+    int firstVertex = 0;
+    int firstIndex = 0;
+    int indexCount = 0;
+};
+
+static SphereLod lods[SPHERE_LOD_LEVELS];
+static std::vector<SphereVertex> vertices;   // 모든 단계를 이어붙인 정점
+static std::vector<unsigned short> indices;  // 단계별로 자기 firstVertex 기준 인덱스
+static GLuint sphereVbo = 0, sphereIbo = 0;
+static bool useBuffers = false;
+
+static glm::vec3 lodEye(0.0f);
+static float lodPixelsPerUnit = 1.0f;
+static float lodMaxErrorPx = SPHERE_LOD_MAX_ERROR_PX;
+
+// gluSphere(GLU_SMOOTH, 텍스처 켬)와 같은 배치:
+// rho는 +z(t = 1)에서 -z(t = 0)로, theta는 slices 등분 (마지막 열은 s = 1인 이음새 정점)
+static void buildSphereLod(SphereLod& lod, int slices) {
+    const int stacks = slices;
+    const float pi = 3.14159265358979f;
+    const float drho = pi / stacks;
+    const float dtheta = 2.0f * pi / slices;
+
+    lod.slices = slices;
+    lod.firstVertex = (int)vertices.size();
+    lod.firstIndex = (int)indices.size();
+
+    for (int i = 0; i <= stacks; i++) {
+        float rho = i * drho;
+        float t = 1.0f - (float)i / stacks;
+        for (int j = 0; j <= slices; j++) {
+            float theta = (j == slices) ? 0.0f : j * dtheta;
+            SphereVertex v;
+            v.x = -std::sin(theta) * std::sin(rho);
+            v.y = std::cos(theta) * std::sin(rho);
+            v.z = std::cos(rho);
+            v.s = (float)j / slices;
+            v.t = t;
+            vertices.push_back(v);
+        }
+    }
+
+    // 쿼드 스트립 (i, j) (i+1, j) (i, j+1) (i+1, j+1) 순서를 삼각형 두 개로
+    const int row = slices + 1;
+    for (int i = 0; i < stacks; i++) {
+        for (int j = 0; j < slices; j++) {
+            unsigned short a = (unsigned short)(i * row + j);
+            unsigned short b = (unsigned short)((i + 1) * row + j);
+            unsigned short c = (unsigned short)(i * row + j + 1);
+            unsigned short d = (unsigned short)((i + 1) * row + j + 1);
+            indices.push_back(a); indices.push_back(b); indices.push_back(c);
+            indices.push_back(c); indices.push_back(b); indices.push_back(d);
+        }
+    }
+    lod.indexCount = (int)indices.size() - lod.firstIndex;
+}
+
+void initSphereMeshes() {
+    vertices.clear();
+    indices.clear();
+    for (int level = 0; level < SPHERE_LOD_LEVELS; level++) {
+        buildSphereLod(lods[level], SPHERE_LOD_SLICES[level]);
+    }
+
+    // GL 1.5 미만이면 CPU 배열을 그대로 클라이언트 배열로 사용
+    useBuffers = hasGLVersion(1, 5);
+    if (!useBuffers) return;
+
+    glGenBuffers(1, &sphereVbo);
+    glGenBuffers(1, &sphereIbo);
+    glBindBuffer(GL_ARRAY_BUFFER, sphereVbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(SphereVertex), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereIbo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void shutdownSphereMeshes() {
+    if (sphereVbo != 0) glDeleteBuffers(1, &sphereVbo);
+    if (sphereIbo != 0) glDeleteBuffers(1, &sphereIbo);
+    sphereVbo = sphereIbo = 0;
+    useBuffers = false;
+}
+
+void setSphereLodView(const glm::vec3& eye, float pixelsPerUnit) {
+    lodEye = eye;
+    lodPixelsPerUnit = pixelsPerUnit;
+}
+
+void setSphereLodMaxError(float errorPx) {
+    lodMaxErrorPx = std::max(0.01f, errorPx);
+}
+
+int sphereLodLevel(const glm::vec3& center, float radius) {
+    glm::vec3 d = center - lodEye;
+    float dist = std::sqrt(glm::dot(d, d));
+    if (dist <= radius) return SPHERE_LOD_LEVELS - 1; // 카메라가 구 안쪽
+
+    // 화면 반지름 r(px)인 원을 n각형으로 그리면 외곽선 오차는 약 r * (pi / n)^2 / 2
+    // 오차 <= e 가 되려면 n >= pi * sqrt(r / (2e))
+    float screenRadius = radius * lodPixelsPerUnit / dist;
+    float needed = 3.14159265f * std::sqrt(screenRadius / (2.0f * lodMaxErrorPx));
+    for (int level = 0; level < SPHERE_LOD_LEVELS; level++) {
+        if (SPHERE_LOD_SLICES[level] >= needed) return level;
+    }
+    return SPHERE_LOD_LEVELS - 1;
+}
+
+void drawSphereMesh(int level, float radius) {
+    if (vertices.empty()) return;
+    level = std::max(0, std::min(level, SPHERE_LOD_LEVELS - 1));
+    const SphereLod& lod = lods[level];
+
+    // 정점 포인터를 단계 시작으로 두면 unsigned short 인덱스를 그대로 쓸 수 있음
+    const char* base;
+    const void* indexOffset;
+    if (useBuffers) {
+        glBindBuffer(GL_ARRAY_BUFFER, sphereVbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereIbo);
+        base = (const char*)(lod.firstVertex * sizeof(SphereVertex));
+        indexOffset = (const void*)(lod.firstIndex * sizeof(unsigned short));
+    }
+    else {
+        base = (const char*)(vertices.data() + lod.firstVertex);
+        indexOffset = indices.data() + lod.firstIndex;
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(SphereVertex), base);
+    glNormalPointer(GL_FLOAT, sizeof(SphereVertex), base);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(SphereVertex), base + 3 * sizeof(float));
+
+    // 법선은 GL_NORMALIZE(initLighting)로 다시 단위 길이가 됨
+    glPushMatrix();
+    glScalef(radius, radius, radius);
+    glDrawElements(GL_TRIANGLES, lod.indexCount, GL_UNSIGNED_SHORT, indexOffset);
+    glPopMatrix();
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (useBuffers) {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
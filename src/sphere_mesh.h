@@ -0,0 +1,29 @@
+﻿#pragma once
+#include <glm/glm.hpp>
+
+// --- 구체 메시 캐시 ---
+// gluSphere / glutSolidSphere는 호출할 때마다 구체 정점을 새로 계산해서 보내므로
+// 분할 단계(LOD)별 단위 구를 한 번만 만들어 VBO/IBO에 올려두고 모든 천체가 같이 씀
+// 법선과 텍스처 좌표는 gluSphere와 같은 규칙이라 기존 텍스처가 그대로 맞음
+// 단계는 화면에 투영된 반지름으로 고름 (다각형 외곽선 오차가 SPHERE_LOD_MAX_ERROR_PX 이하가 되는 가장 낮은 단계)
+
+const int SPHERE_LOD_LEVELS = 6;
+// 단계별 분할 수 (slices = stacks), 마지막 단계가 기존 태양/스카이돔 해상도
+const int SPHERE_LOD_SLICES[SPHERE_LOD_LEVELS] = { 6, 10, 16, 24, 40, 64 };
+// 허용하는 외곽선 오차 기본값 (픽셀, 품질 조절기가 setSphereLodMaxError로 바꿈)
+const float SPHERE_LOD_MAX_ERROR_PX = 0.5f;
+
+// GL 컨텍스트를 만든 뒤 호출 (VBO를 못 쓰면 클라이언트 배열로 그림)
+void initSphereMeshes();
+void shutdownSphereMeshes();
+
+// 프레임마다 카메라 위치와 투영 배율 설정 (pixelsPerUnit: 거리 1에서 월드 1이 차지하는 픽셀 수)
+void setSphereLodView(const glm::vec3& eye, float pixelsPerUnit);
+
+void setSphereLodMaxError(float errorPx);
+
+// 월드 위치 center, 반지름 radius인 구에 맞는 단계
+int sphereLodLevel(const glm::vec3& center, float radius);
+
+// 현재 행렬 원점에 반지름 radius인 구를 그림 (현재 재질/색/텍스처 상태 사용)
+void drawSphereMesh(int level, float radius);
@@ -0,0 +1,60 @@
+﻿#include "spline.h"
+#include "task_pool.h"
+
+glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t) {
+    float t2 = t * t;
+    float t3 = t2 * t;
+
+    // Catmull-Rom 공식 (GLM 벡터 연산 활용)
+    // 0.5 * ( (2*p1) + (-p0 + p2)*t + (2*p0 - 5*p1 + 4*p2 - p3)*t^2 + (-p0 + 3*p1 - 3*p2 + p3)*t3 )
+    glm::vec3 result = p1 * 2.0f;
+    result += (p2 - p0) * t;
+    result += (p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3) * t2;
+    result += (-p0 + p1 * 3.0f - p2 * 3.0f + p3) * t3;
+    result *= 0.5f;
+
+    return result;
+}
+
+void tessellateRayPaths(const RayPathArena& paths, int segments, RayPathArena& out) {
+    const int n = paths.numPaths;
+    out.numPaths = n;
+    out.first.resize(n);
+    out.count.resize(n);
+    int total = 0;
+    for (int r = 0; r < n; r++) {
+        out.first[r] = total;
+        out.count[r] = (paths.count[r] > 0) ? (paths.count[r] - 1) * segments + 1 : 0;
+        total += out.count[r];
+    }
+    if ((int)out.points.size() < total) out.points.resize(total);
+    out.used = total;
+
+    parallelFor(n, 64, [&](int begin, int end) {
+        for (int r = begin; r < end; r++) {
+            RayPathView path = paths.path(r);
+            if (path.count <= 0) continue;
+            glm::vec3* dst = out.points.data() + out.first[r];
+            for (int i = 0; i + 1 < path.count; i++) {
+                const glm::vec3& p0 = (i == 0) ? path[0] : path[i - 1];
+                const glm::vec3& p3 = (i + 2 == path.count) ? path[i + 1] : path[i + 2];
+                for (int j = 0; j < segments; j++) {
+                    *dst++ = catmullRom(p0, path[i], path[i + 1], p3, (float)j / (float)segments);
+                }
+            }
+            *dst = path.back();
+        }
+    });
+}
+
+bool isPointVisible(const glm::vec3& point, const glm::mat4& mvpMatrix) {
+    glm::vec4 p = mvpMatrix * glm::vec4(point, 1.0f);
+
+    // OpenGL의 클립 공간 좌표 범위: -w <= x, y, z <= w
+    // 약간의 여유(margin)를 주어 경계선에서 갑자기 사라지는 것을 방지 (1.0 -> 1.2 등)
+    float w = p.w * 1.1f;
+
+    return (p.x >= -w && p.x <= w) &&
+        (p.y >= -w && p.y <= w) &&
+        (p.z >= -w && p.z <= w);
+}
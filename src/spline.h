@@ -0,0 +1,14 @@
+﻿#pragma once
+#include <glm/glm.hpp>
+#include "ray_path_arena.h"
+
+// --- Spline 함수 (Catmull-Rom) ---
+// p0, p1, p2, p3 네 개의 점을 이용해 p1과 p2 사이의 곡선상 위치를 반환
+glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t);
+
+// 경로마다 점 사이를 segments개로 나눈 Catmull-Rom 곡선을 out에 기록 (경로 i의 점 (count - 1) * segments + 1개)
+// 양 끝 구간은 끝점을 한 번 더 써서 제어점으로 씀, 경로 묶음 단위로 작업 풀에서 나눠 계산
+void tessellateRayPaths(const RayPathArena& paths, int segments, RayPathArena& out);
+
+// 점이 화면(Frustum) 안에 있는지 검사하는 함수
+bool isPointVisible(const glm::vec3& point, const glm::mat4& mvpMatrix);
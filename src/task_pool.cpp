@@ -0,0 +1,295 @@
+﻿#include "task_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// 슬롯 하나의 남은 작업 번호 [head, tail) (주인은 앞에서, 훔치는 쪽은 뒤에서 가져감)
+struct alignas(64) TaskDeque {
+    std::mutex lock;
+    int head = 0;
+    int tail = 0;
+};
+
+// parallelFor 한 번 (호출 스레드가 소유, 스레드마다 재사용)
+struct TaskLoop {
+    TaskBody body = { nullptr, nullptr };
+    int count = 0;
+    int chunk = 1;
+    int slots = 0;
+    std::unique_ptr<TaskDeque[]> deques;
+    int dequeCapacity = 0;
+    std::atomic<int> remaining{ 0 }; // 아직 끝나지 않은 작업 수
+    std::atomic<int> helpers{ 0 };   // 이 루프를 돕고 있는 작업 스레드 수 (0이 돼야 호출 스레드가 돌아감)
+};
+
+static TaskPoolConfig config;
+static std::vector<std::thread> workers;
+static std::atomic<bool> stopping(false);
+static std::atomic<bool> started(false);
+static std::mutex configMutex; // 처음 쓰는 스레드 여럿이 동시에 띄우지 않게
+
+// 열린 루프 목록 (작업 스레드가 여기서 도울 루프를 고름)
+static std::mutex loopMutex;
+static std::vector<TaskLoop*> openLoops;
+static std::atomic<int> openLoopCount(0);
+
+static std::mutex asyncMutex;
+static std::deque<std::function<void()>> asyncTasks;
+static std::atomic<int> asyncCount(0);
+
+// 할 일이 없는 작업 스레드가 잠드는 곳
+static std::mutex sleepMutex;
+static std::condition_variable wakeWorkers;
+
+static thread_local int currentSlot = 0;
+// 작업 안에서 다시 parallelFor를 부를 수 있으므로 중첩 단계별로 루프를 둠
+static thread_local std::vector<std::unique_ptr<TaskLoop>> loopStack;
+static thread_local int loopDepth = 0;
+
+static void wakeAll() {
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wakeWorkers.notify_all();
+}
+
+static bool hasWork() {
+    return openLoopCount.load(std::memory_order_acquire) > 0 || asyncCount.load(std::memory_order_acquire) > 0;
+}
+
+static void pinCurrentThread(int index) {
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    int core = (int)(index % cores);
+#if defined(_WIN32)
+    if (core < 64) SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)core; // 고정을 지원하지 않는 플랫폼은 무시
+#endif
+}
+
+// 작업 번호 하나를 가져옴: 자기 덱 앞쪽, 없으면 다른 슬롯 덱의 뒤쪽 절반을 훔쳐서 자기 덱에 넣음
+static bool takeTask(TaskLoop& loop, int slot, int& task) {
+    TaskDeque& own = loop.deques[slot];
+    {
+        std::lock_guard<std::mutex> lock(own.lock);
+        if (own.head < own.tail) {
+            task = own.head++;
+            return true;
+        }
+    }
+    for (int k = 1; k < loop.slots; k++) {
+        TaskDeque& victim = loop.deques[(slot + k) % loop.slots];
+        int begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.lock);
+            int n = victim.tail - victim.head;
+            if (n <= 0) continue;
+            begin = victim.tail - (n + 1) / 2;
+            end = victim.tail;
+            victim.tail = begin;
+        }
+        task = begin;
+        if (end - begin > 1) {
+            std::lock_guard<std::mutex> lock(own.lock);
+            own.head = begin + 1;
+            own.tail = end;
+        }
+        return true;
+    }
+    return false;
+}
+
+static void runLoopTasks(TaskLoop& loop, int slot) {
+    int savedSlot = currentSlot;
+    currentSlot = slot;
+    int task;
+    while (takeTask(loop, slot, task)) {
+        int begin = task * loop.chunk;
+        int end = std::min(loop.count, begin + loop.chunk);
+        loop.body.invoke(loop.body.context, begin, end);
+        loop.remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    currentSlot = savedSlot;
+}
+
+// 남은 작업이 있는 열린 루프 하나를 골라 helpers를 올림 (목록에서 빠진 루프는 고를 수 없으므로 호출 스레드가 안전하게 기다릴 수 있음)
+static TaskLoop* acquireLoop(int slot) {
+    if (openLoopCount.load(std::memory_order_acquire) == 0) return nullptr;
+    std::lock_guard<std::mutex> lock(loopMutex);
+    int n = (int)openLoops.size();
+    for (int k = 0; k < n; k++) {
+        TaskLoop* loop = openLoops[(slot + k) % n];
+        if (slot < loop->slots && loop->remaining.load(std::memory_order_acquire) > 0) {
+            loop->helpers.fetch_add(1, std::memory_order_acq_rel);
+            return loop;
+        }
+    }
+    return nullptr;
+}
+
+static bool popAsyncTask(std::function<void()>& task) {
+    if (asyncCount.load(std::memory_order_acquire) == 0) return false;
+    std::lock_guard<std::mutex> lock(asyncMutex);
+    if (asyncTasks.empty()) return false;
+    task = std::move(asyncTasks.front());
+    asyncTasks.pop_front();
+    asyncCount.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+static void workerLoop(int slot) {
+    if (config.pinThreads) pinCurrentThread(slot);
+    int idle = 0;
+    while (!stopping.load(std::memory_order_acquire)) {
+        if (TaskLoop* loop = acquireLoop(slot)) {
+            runLoopTasks(*loop, slot);
+            loop->helpers.fetch_sub(1, std::memory_order_acq_rel);
+            idle = 0;
+            continue;
+        }
+        std::function<void()> task;
+        if (popAsyncTask(task)) {
+            task();
+            idle = 0;
+            continue;
+        }
+        if (++idle < TASK_POOL_SPIN_COUNT) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeWorkers.wait(lock, [] { return stopping.load() || hasWork(); });
+        idle = 0;
+    }
+}
+
+static void stopWorkers() {
+    if (!started.load()) return;
+    stopping.store(true);
+    wakeAll();
+    for (auto& t : workers) t.join();
+    workers.clear();
+    started.store(false);
+}
+
+static void startWorkers(const TaskPoolConfig& requested) {
+    config = requested;
+    if (config.threads <= 0) config.threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    config.threads = std::min(config.threads, TASK_POOL_MAX_THREADS);
+    stopping.store(false);
+    for (int slot = 1; slot < config.threads; slot++) workers.emplace_back(workerLoop, slot);
+    started.store(true);
+}
+
+void configureTaskPool(const TaskPoolConfig& requested) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    stopWorkers();
+    startWorkers(requested);
+}
+
+void stopTaskPool() {
+    std::lock_guard<std::mutex> lock(configMutex);
+    stopWorkers();
+}
+
+static void ensureStarted() {
+    if (started.load(std::memory_order_acquire)) return;
+    std::lock_guard<std::mutex> lock(configMutex);
+    if (!started.load()) startWorkers(config);
+}
+
+const TaskPoolConfig& taskPoolConfig() {
+    return config;
+}
+
+int taskPoolThreads() {
+    ensureStarted();
+    return config.threads;
+}
+
+int taskSlot() {
+    return currentSlot;
+}
+
+void runParallelFor(int count, int chunk, const TaskBody& body) {
+    if (count <= 0) return;
+    ensureStarted();
+    chunk = std::max(1, chunk);
+    const int tasks = (count + chunk - 1) / chunk;
+    if (tasks == 1 || config.threads == 1) {
+        // 나눌 게 없으면 깨우지 않고 바로 실행 (작업 번호 순서대로)
+        int savedSlot = currentSlot;
+        currentSlot = 0;
+        for (int t = 0; t < tasks; t++) body.invoke(body.context, t * chunk, std::min(count, (t + 1) * chunk));
+        currentSlot = savedSlot;
+        return;
+    }
+
+    if ((int)loopStack.size() <= loopDepth) loopStack.emplace_back(new TaskLoop);
+    TaskLoop& loop = *loopStack[loopDepth++];
+    loop.body = body;
+    loop.count = count;
+    loop.chunk = chunk;
+    loop.slots = config.threads;
+    if (loop.dequeCapacity < loop.slots) {
+        loop.deques.reset(new TaskDeque[loop.slots]);
+        loop.dequeCapacity = loop.slots;
+    }
+    // 슬롯마다 연속된 작업 번호 구간 (앞쪽 작업이 호출 스레드에 가므로 작은 루프도 바로 시작)
+    for (int s = 0; s < loop.slots; s++) {
+        loop.deques[s].head = (int)((long long)tasks * s / loop.slots);
+        loop.deques[s].tail = (int)((long long)tasks * (s + 1) / loop.slots);
+    }
+    loop.remaining.store(tasks, std::memory_order_release);
+    loop.helpers.store(0, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(loopMutex);
+        openLoops.push_back(&loop);
+        openLoopCount.fetch_add(1, std::memory_order_acq_rel);
+    }
+    wakeAll();
+
+    // 작업 스레드 안에서 부른 중첩 루프는 슬롯 0을 호출 스레드 몫으로 씀
+    // (그 스레드 자신의 슬롯은 이 루프를 돕지 않으므로 겹치지 않음)
+    runLoopTasks(loop, 0);
+    while (loop.remaining.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+
+    {
+        std::lock_guard<std::mutex> lock(loopMutex);
+        openLoops.erase(std::find(openLoops.begin(), openLoops.end(), &loop));
+        openLoopCount.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    while (loop.helpers.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+    loopDepth--;
+}
+
+void submitTask(std::function<void()> task) {
+    ensureStarted();
+    if (config.threads <= 1) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        asyncTasks.push_back(std::move(task));
+        asyncCount.fetch_add(1, std::memory_order_acq_rel);
+    }
+    wakeAll();
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+#include <functional>
+#include <type_traits>
+
+// --- 작업 훔치기 스레드 풀 ---
+// 컴파일러 OpenMP 지원과 상관없이 병렬로 돌도록 직접 만든 풀 (광선 적분, 가속도장 굽기, 텍스처 캐시, 스플라인)
+// parallelFor(count, chunk)는 [0, count)를 작업 t = [t * chunk, (t + 1) * chunk)로 나눔 (작업 번호는 스레드 수와 무관하게 고정)
+// 처음에는 슬롯(호출 스레드 = 0, 작업 스레드 = 1..)마다 연속된 작업 번호를 덱에 나눠 넣고
+// 자기 덱이 비면 다른 슬롯 덱의 뒤쪽 절반을 훔쳐옴 (광선마다 스텝 수가 달라도 일이 고르게 퍼짐)
+// 호출한 스레드도 같이 일하고 작업이 다 끝나야 돌아옴
+// 여러 스레드(시뮬레이션 스레드, 텍스처 작업)가 동시에 parallelFor를 불러도 되고 작업 안에서 다시 불러도 됨
+
+const int TASK_POOL_MAX_THREADS = 256;
+// 작업 스레드가 할 일이 없을 때 잠들기 전에 양보하며 기다리는 횟수 (연달아 오는 루프 사이에 깨우는 비용 절약)
+const int TASK_POOL_SPIN_COUNT = 2000;
+
+struct TaskPoolConfig {
+    int threads = 0;         // 호출 스레드 포함 전체 슬롯 수 (0이면 하드웨어 스레드 수)
+    bool pinThreads = false; // 작업 스레드 i를 논리 코어 i에 고정 (호출 스레드는 그대로)
+};
+
+// 풀을 (다시) 띄움, 처음 parallelFor 전에 부르지 않으면 기본 설정으로 뜸
+// 루프나 비동기 작업이 도는 중에는 부르지 말 것
+void configureTaskPool(const TaskPoolConfig& config);
+void stopTaskPool();
+const TaskPoolConfig& taskPoolConfig();
+int taskPoolThreads();
+
+// 지금 작업을 실행 중인 슬롯 번호 [0, taskPoolThreads()) (같은 루프를 동시에 도는 스레드끼리는 겹치지 않음, 루프 밖에서는 0)
+int taskSlot();
+
+// 호출 비용을 줄이려고 std::function 대신 (문맥, 함수) 쌍으로 넘김 (루프마다 힙 할당 없음)
+struct TaskBody {
+    void* context;
+    void (*invoke)(void* context, int begin, int end);
+};
+void runParallelFor(int count, int chunk, const TaskBody& body);
+
+// fn(begin, end)를 작업마다 호출 (작업이 하나뿐이거나 스레드가 하나면 호출한 스레드에서 바로 실행)
+template <class F>
+void parallelFor(int count, int chunk, F&& fn) {
+    typedef typename std::remove_reference<F>::type Fn;
+    TaskBody body = { (void*)&fn, [](void* context, int begin, int end) { (*(Fn*)context)(begin, end); } };
+    runParallelFor(count, chunk, body);
+}
+
+// 기다리지 않는 작업 (텍스처 디코딩 등), 열린 parallelFor를 먼저 돕고 남는 작업 스레드가 순서대로 실행
+// 작업 스레드가 없으면 (threads = 1) 호출한 스레드에서 바로 실행
+void submitTask(std::function<void()> task);
@@ -0,0 +1,327 @@
+﻿#include "texture_cache.h"
+#include "image.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+#include "task_pool.h"
+
+// --- 파일 구조 ---
+// [TextureCacheHeader][레벨 0 데이터][레벨 1 데이터]... (각 레벨은 16바이트 정렬)
+struct TextureCacheFileLevel {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct TextureCacheHeader {
+    char magic[4];         // "EHTX"
+    uint32_t version;
+    uint32_t format;       // TextureCacheFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    uint64_t sourceSize;   // 원본 파일 크기
+    int64_t sourceTime;    // 원본 수정 시각 (file_time_type 틱)
+    TextureCacheFileLevel level[TEXTURE_CACHE_MAX_LEVELS];
+};
+
+static const char TEXTURE_CACHE_MAGIC[4] = { 'E', 'H', 'T', 'X' };
+
+static inline uint64_t align16(uint64_t value) {
+    return (value + 15) & ~(uint64_t)15;
+}
+
+std::string textureCachePath(const char* sourcePath) {
+    return std::string(sourcePath) + ".ehtx";
+}
+
+// --- 밉맵 ---
+// 2x2 박스 필터 (홀수 크기는 마지막 행/열을 한 번 더 씀)
+static void downsample(const std::vector<unsigned char>& src, int width, int height, int channels,
+    std::vector<unsigned char>& dst, int dstWidth, int dstHeight) {
+    dst.resize((size_t)dstWidth * dstHeight * channels);
+    parallelFor(dstHeight, 16, [&](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; y++) {
+            int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+            for (int x = 0; x < dstWidth; x++) {
+                int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                for (int c = 0; c < channels; c++) {
+                    int sum = src[((size_t)y0 * width + x0) * channels + c] + src[((size_t)y0 * width + x1) * channels + c]
+                        + src[((size_t)y1 * width + x0) * channels + c] + src[((size_t)y1 * width + x1) * channels + c];
+                    dst[((size_t)y * dstWidth + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+    });
+}
+
+// --- BC1 ---
+static inline uint16_t packRGB565(const float c[3]) {
+    int r = (int)std::lround(std::min(255.0f, std::max(0.0f, c[0])) * 31.0f / 255.0f);
+    int g = (int)std::lround(std::min(255.0f, std::max(0.0f, c[1])) * 63.0f / 255.0f);
+    int b = (int)std::lround(std::min(255.0f, std::max(0.0f, c[2])) * 31.0f / 255.0f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static inline void unpackRGB565(uint16_t c, int out[3]) {
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+// 4색 모드 팔레트 (c0 > c1일 때), c0 == c1이면 3색 모드지만 인덱스 0만 쓰므로 같은 식으로 충분
+static void bc1Palette(uint16_t c0, uint16_t c1, int palette[4][3]) {
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int k = 0; k < 3; k++) {
+        if (c0 > c1) {
+            palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+            palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+        }
+        else {
+            palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+            palette[3][k] = 0;
+        }
+    }
+}
+
+// 16픽셀(RGB)의 주성분 축 위 양 끝을 끝점으로 쓰고 각 픽셀은 가장 가까운 팔레트 색으로
+static void encodeBC1Block(const unsigned char pixels[16][3], unsigned char out[8]) {
+    float mean[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++) {
+        for (int k = 0; k < 3; k++) mean[k] += pixels[i][k];
+    }
+    for (int k = 0; k < 3; k++) mean[k] /= 16.0f;
+
+    float cov[6] = { 0, 0, 0, 0, 0, 0 }; // rr rg rb gg gb bb
+    for (int i = 0; i < 16; i++) {
+        float r = pixels[i][0] - mean[0], g = pixels[i][1] - mean[1], b = pixels[i][2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+
+    // 거듭제곱법으로 가장 큰 고유벡터
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iter = 0; iter < 4; iter++) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float len = std::max(std::fabs(x), std::max(std::fabs(y), std::fabs(z)));
+        if (len <= 0.0f) break;
+        axis[0] = x / len; axis[1] = y / len; axis[2] = z / len;
+    }
+    float axisLenSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+    float tMin = 0.0f, tMax = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        float t = ((pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1]
+            + (pixels[i][2] - mean[2]) * axis[2]) / axisLenSq;
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    float e0[3], e1[3];
+    for (int k = 0; k < 3; k++) {
+        e0[k] = mean[k] + axis[k] * tMax;
+        e1[k] = mean[k] + axis[k] * tMin;
+    }
+
+    uint16_t c0 = packRGB565(e0), c1 = packRGB565(e1);
+    if (c0 < c1) std::swap(c0, c1);
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        int palette[4][3];
+        bc1Palette(c0, c1, palette);
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestDist = 1 << 30;
+            for (int p = 0; p < 4; p++) {
+                int dr = pixels[i][0] - palette[p][0], dg = pixels[i][1] - palette[p][1], db = pixels[i][2] - palette[p][2];
+                int dist = dr * dr + dg * dg + db * db;
+                if (dist < bestDist) { bestDist = dist; best = p; }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+
+    out[0] = (unsigned char)(c0 & 0xff); out[1] = (unsigned char)(c0 >> 8);
+    out[2] = (unsigned char)(c1 & 0xff); out[3] = (unsigned char)(c1 >> 8);
+    for (int k = 0; k < 4; k++) out[4 + k] = (unsigned char)(indices >> (8 * k));
+}
+
+static size_t bc1LevelSize(int width, int height) {
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+static void encodeBC1Level(const std::vector<unsigned char>& rgb, int width, int height, unsigned char* out) {
+    const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    parallelFor(blocksY, 4, [&](int rowBegin, int rowEnd) {
+        unsigned char pixels[16][3];
+        for (int by = rowBegin; by < rowEnd; by++) {
+            for (int bx = 0; bx < blocksX; bx++) {
+                // 가장자리 블록은 마지막 행/열을 반복
+                for (int i = 0; i < 16; i++) {
+                    int x = std::min(bx * 4 + (i & 3), width - 1);
+                    int y = std::min(by * 4 + (i >> 2), height - 1);
+                    const unsigned char* p = &rgb[((size_t)y * width + x) * 3];
+                    pixels[i][0] = p[0]; pixels[i][1] = p[1]; pixels[i][2] = p[2];
+                }
+                encodeBC1Block(pixels, out + ((size_t)by * blocksX + bx) * 8);
+            }
+        }
+    });
+}
+
+void decodeBC1Level(const TextureCacheLevel& level, unsigned char* rgb) {
+    const int blocksX = (level.width + 3) / 4, blocksY = (level.height + 3) / 4;
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            const unsigned char* block = level.data + ((size_t)by * blocksX + bx) * 8;
+            uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+            uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+            uint32_t indices = (uint32_t)block[4] | ((uint32_t)block[5] << 8) | ((uint32_t)block[6] << 16) | ((uint32_t)block[7] << 24);
+            int palette[4][3];
+            bc1Palette(c0, c1, palette);
+            for (int i = 0; i < 16; i++) {
+                int x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+                if (x >= level.width || y >= level.height) continue;
+                const int* c = palette[(indices >> (2 * i)) & 3];
+                unsigned char* p = rgb + ((size_t)y * level.width + x) * 3;
+                p[0] = (unsigned char)c[0]; p[1] = (unsigned char)c[1]; p[2] = (unsigned char)c[2];
+            }
+        }
+    }
+}
+
+// --- 캐시 생성 ---
+bool buildTextureCache(const char* sourcePath, const char* cachePath) {
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (!fileStamp(sourcePath, sourceSize, sourceTime)) return false;
+
+    // 알파가 있으면 RGBA8, 없으면 RGB로 읽어서 BC1
+    int sourceChannels = imageFileChannels(sourcePath);
+    if (sourceChannels == 0) return false;
+    const bool hasAlpha = (sourceChannels == 2 || sourceChannels == 4);
+    const int channels = hasAlpha ? 4 : 3;
+
+    Image image;
+    if (!loadImageFile(sourcePath, image, channels)) return false;
+
+    TextureCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TEXTURE_CACHE_MAGIC, 4);
+    header.version = TEXTURE_CACHE_VERSION;
+    header.format = hasAlpha ? TEXTURE_CACHE_RGBA8 : TEXTURE_CACHE_BC1;
+    header.width = (uint32_t)image.width;
+    header.height = (uint32_t)image.height;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+
+    std::vector<unsigned char> level(image.pixels, image.pixels + (size_t)image.width * image.height * channels);
+    freeImage(image);
+
+    // data[i]는 파일의 dataStart + i 위치
+    const uint64_t dataStart = align16(sizeof(TextureCacheHeader));
+    std::vector<unsigned char> data, next;
+    int width = (int)header.width, height = (int)header.height, levels = 0;
+    while (levels < TEXTURE_CACHE_MAX_LEVELS) {
+        size_t size = hasAlpha ? level.size() : bc1LevelSize(width, height);
+        size_t start = data.size();
+        TextureCacheFileLevel& entry = header.level[levels++];
+        entry.offset = dataStart + start;
+        entry.size = size;
+        entry.width = (uint32_t)width;
+        entry.height = (uint32_t)height;
+
+        data.resize(start + (size_t)align16(size), 0);
+        if (hasAlpha) std::memcpy(data.data() + start, level.data(), size);
+        else encodeBC1Level(level, width, height, data.data() + start);
+
+        if (width == 1 && height == 1) break;
+        int nextWidth = std::max(1, width / 2), nextHeight = std::max(1, height / 2);
+        downsample(level, width, height, channels, next, nextWidth, nextHeight);
+        level.swap(next);
+        width = nextWidth;
+        height = nextHeight;
+    }
+    header.levels = (uint32_t)levels;
+
+    // 중간에 실패해도 깨진 캐시가 남지 않도록 임시 파일에 다 쓴 뒤 이름 바꿈
+    std::string tempPath = std::string(cachePath) + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+    static const unsigned char padding[16] = { 0 };
+    size_t headerPad = (size_t)(dataStart - sizeof(TextureCacheHeader));
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+        && std::fwrite(padding, 1, headerPad, file) == headerPad
+        && std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = (std::fclose(file) == 0) && ok;
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tempPath, cachePath, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+// --- 메모리 매핑 ---
+void closeTextureCache(MappedTexture& texture) {
+    unmapFile(texture.file);
+    texture = MappedTexture();
+}
+
+// 헤더를 검사하고 레벨 포인터를 채움 (원본과 맞지 않으면 false)
+static bool readMappedHeader(MappedTexture& texture, uint64_t sourceSize, int64_t sourceTime) {
+    if (texture.file.size < sizeof(TextureCacheHeader)) return false;
+    TextureCacheHeader header;
+    std::memcpy(&header, texture.file.data, sizeof(header));
+    if (std::memcmp(header.magic, TEXTURE_CACHE_MAGIC, 4) != 0 || header.version != TEXTURE_CACHE_VERSION) return false;
+    if (header.sourceSize != sourceSize || header.sourceTime != sourceTime) return false;
+    if (header.levels == 0 || header.levels > (uint32_t)TEXTURE_CACHE_MAX_LEVELS) return false;
+    if (header.format != TEXTURE_CACHE_BC1 && header.format != TEXTURE_CACHE_RGBA8) return false;
+
+    texture.format = (TextureCacheFormat)header.format;
+    texture.width = (int)header.width;
+    texture.height = (int)header.height;
+    texture.levels = (int)header.levels;
+    const unsigned char* base = texture.file.data;
+    for (int i = 0; i < texture.levels; i++) {
+        const TextureCacheFileLevel& entry = header.level[i];
+        if (entry.offset > texture.file.size || entry.size > texture.file.size - entry.offset) return false;
+        texture.level[i].width = (int)entry.width;
+        texture.level[i].height = (int)entry.height;
+        texture.level[i].data = base + entry.offset;
+        texture.level[i].size = (size_t)entry.size;
+    }
+    return true;
+}
+
+bool openTextureCache(const char* sourcePath, MappedTexture& texture, bool* rebuilt) {
+    if (rebuilt) *rebuilt = false;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (!fileStamp(sourcePath, sourceSize, sourceTime)) return false;
+
+    std::string cachePath = textureCachePath(sourcePath);
+    if (mapFileReadOnly(cachePath.c_str(), texture.file)) {
+        if (readMappedHeader(texture, sourceSize, sourceTime)) return true;
+        closeTextureCache(texture);
+    }
+
+    // 없거나 오래된 캐시 -> 다시 만들고 매핑
+    if (!buildTextureCache(sourcePath, cachePath.c_str())) return false;
+    if (rebuilt) *rebuilt = true;
+    if (!mapFileReadOnly(cachePath.c_str(), texture.file)) return false;
+    if (!readMappedHeader(texture, sourceSize, sourceTime)) {
+        closeTextureCache(texture);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "mapped_file.h"
+
+// --- 텍스처 캐시 ---
+// 원본 이미지(JPG/PNG)를 한 번만 디코딩해서 밉맵 체인을 만들고 BC1(DXT1)로 압축한 뒤
+// 원본 옆 "<원본>.ehtx" 파일에 저장 (KTX와 비슷한 단순 컨테이너: 헤더 + 레벨 표 + 레벨 데이터)
+// 이후 실행은 파일을 메모리 매핑해서 레벨별 압축 데이터를 그대로 GL에 올림 (JPEG 디코딩 없음)
+// 원본 크기/수정 시각이 헤더와 다르면 다시 만듦
+// GL 의존성 없음 (업로드는 texture_loader에서)
+
+enum TextureCacheFormat : uint32_t {
+    TEXTURE_CACHE_BC1 = 1,   // RGB, 4x4 블록당 8바이트 (원본 RGB의 1/6)
+    TEXTURE_CACHE_RGBA8 = 2, // 알파가 있는 원본은 압축하지 않고 밉맵만 저장
+};
+
+const uint32_t TEXTURE_CACHE_VERSION = 1;
+const int TEXTURE_CACHE_MAX_LEVELS = 16; // 32768 x 32768까지
+
+struct TextureCacheLevel {
+    int width = 0;
+    int height = 0;
+    const unsigned char* data = nullptr; // 매핑된 파일 안을 가리킴
+    size_t size = 0;
+};
+
+// 매핑된 캐시 파일 (closeTextureCache 전까지 level[].data가 유효)
+struct MappedTexture {
+    TextureCacheFormat format = TEXTURE_CACHE_BC1;
+    int width = 0;
+    int height = 0;
+    int levels = 0;
+    TextureCacheLevel level[TEXTURE_CACHE_MAX_LEVELS];
+
+    MappedFile file;
+};
+
+std::string textureCachePath(const char* sourcePath);
+
+// 원본을 디코딩해서 캐시 파일을 새로 씀 (임시 파일에 쓴 뒤 이름 바꿈)
+bool buildTextureCache(const char* sourcePath, const char* cachePath);
+
+// 최신 캐시를 매핑 (없거나 오래됐으면 먼저 만듦, rebuilt가 있으면 다시 만들었는지 기록)
+bool openTextureCache(const char* sourcePath, MappedTexture& texture, bool* rebuilt = nullptr);
+void closeTextureCache(MappedTexture& texture);
+
+// BC1 레벨 전체를 RGB 8비트로 풀기 (GL이 S3TC를 지원하지 않을 때 / 화질 측정용)
+void decodeBC1Level(const TextureCacheLevel& level, unsigned char* rgb);
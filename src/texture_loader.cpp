@@ -0,0 +1,303 @@
+﻿#include "texture_loader.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <initializer_list>
+#include "texture_cache.h"
+#include "image.h"
+#include "task_pool.h"
+
+static void setTextureParameters(int levels) {
+    // 작은 구체에 8K 텍스처를 입힐 때도 밉맵에서 읽도록 삼선형 필터
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+static bool hasS3TC() {
+    return hasGLVersion(1, 3) && hasGLExtension("GL_EXT_texture_compression_s3tc");
+}
+
+// 레벨 i 하나를 현재 바인딩된 텍스처에 올림 (rgb: S3TC가 없을 때 미리 풀어둔 레벨, 없으면 여기서 풂)
+static void uploadMappedLevel(const MappedTexture& texture, int i, bool s3tc,
+    const unsigned char* rgb, std::vector<unsigned char>& scratch) {
+    const TextureCacheLevel& level = texture.level[i];
+    if (texture.format == TEXTURE_CACHE_RGBA8) {
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+    }
+    else if (s3tc) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, level.width, level.height, 0,
+            (GLsizei)level.size, level.data);
+    }
+    else {
+        if (!rgb) {
+            scratch.resize((size_t)level.width * level.height * 3);
+            decodeBC1Level(level, scratch.data());
+            rgb = scratch.data();
+        }
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGB, level.width, level.height, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    }
+}
+
+static GLuint uploadMappedTexture(const MappedTexture& texture) {
+    const bool s3tc = hasS3TC();
+
+    GLuint texId = 0;
+    glGenTextures(1, &texId);
+    glBindTexture(GL_TEXTURE_2D, texId);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // 작은 레벨은 행이 4바이트 배수가 아님
+
+    std::vector<unsigned char> rgb;
+    for (int i = 0; i < texture.levels; i++) {
+        uploadMappedLevel(texture, i, s3tc, nullptr, rgb);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    setTextureParameters(texture.levels);
+    return texId;
+}
+
+// 캐시를 못 쓸 때: 기존처럼 원본을 디코딩 (밉맵은 GLU가 만듦)
+static GLuint uploadDecodedImage(const Image& image) {
+    GLuint texId = 0;
+    glGenTextures(1, &texId);
+    glBindTexture(GL_TEXTURE_2D, texId);
+
+    GLenum format = (image.channels == 4) ? GL_RGBA : GL_RGB;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    gluBuild2DMipmaps(GL_TEXTURE_2D, format, image.width, image.height, format, GL_UNSIGNED_BYTE, image.pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    return texId;
+}
+
+static GLuint uploadDecodedTexture(const char* filename) {
+    Image image;
+    if (!loadImageFile(filename, image)) return 0;
+    GLuint texId = uploadDecodedImage(image);
+    freeImage(image);
+    return texId;
+}
+
+GLuint loadTextureFile(const char* filename) {
+    MappedTexture texture;
+    bool rebuilt = false;
+    if (openTextureCache(filename, texture, &rebuilt)) {
+        if (rebuilt) std::cout << "Built texture cache: " << textureCachePath(filename) << std::endl;
+        GLuint texId = uploadMappedTexture(texture);
+        closeTextureCache(texture);
+        return texId;
+    }
+    return uploadDecodedTexture(filename);
+}
+
+// --- 비동기 로드 ---
+
+struct TextureJob {
+    std::string filename;
+    GLuint* texture = nullptr;
+    bool* loaded = nullptr;
+
+    // 작업 스레드가 채움
+    bool ok = false;
+    bool rebuilt = false;
+    bool mapped = false;        // true면 cache, false면 image (캐시를 못 쓴 경우)
+    MappedTexture cache;
+    std::vector<std::vector<unsigned char>> rgbLevels; // S3TC가 없을 때 미리 풀어둔 레벨
+    Image image;
+
+    // GL 스레드 진행 상태
+    GLuint id = 0;
+    int nextLevel = -1; // 다음에 올릴 레벨 (가장 작은 레벨부터 0까지 내려감)
+};
+
+static std::mutex jobMutex;
+static std::deque<std::unique_ptr<TextureJob>> pendingJobs; // 작업 스레드가 가져갈 요청
+static std::deque<std::unique_ptr<TextureJob>> readyJobs;   // 디코딩이 끝나 업로드를 기다리는 것
+static int decodeTasks = 0;    // 작업 풀에 넘겼지만 아직 끝나지 않은 디코딩 작업 수 (jobMutex)
+static std::condition_variable decodeDone;
+static int jobsInFlight = 0;   // 요청 후 아직 다 올리지 못한 텍스처 수 (GL 스레드 전용)
+static bool s3tcSupported = false; // 요청 전에 GL 스레드에서 정함 (작업 스레드는 읽기만)
+
+// GL 스레드에서 올리는 중인 것 (앞에서부터 순서대로)
+static std::deque<std::unique_ptr<TextureJob>> uploadingJobs;
+
+static void prepareTextureJob(TextureJob& job) {
+    job.mapped = openTextureCache(job.filename.c_str(), job.cache, &job.rebuilt);
+    if (job.mapped) {
+        // S3TC가 없으면 BC1 풀기도 여기서 끝내서 GL 스레드는 복사만 함
+        if (job.cache.format == TEXTURE_CACHE_BC1 && !s3tcSupported) {
+            job.rgbLevels.resize(job.cache.levels);
+            for (int i = 0; i < job.cache.levels; i++) {
+                const TextureCacheLevel& level = job.cache.level[i];
+                job.rgbLevels[i].resize((size_t)level.width * level.height * 3);
+                decodeBC1Level(level, job.rgbLevels[i].data());
+            }
+        }
+        job.ok = true;
+        return;
+    }
+    job.ok = loadImageFile(job.filename.c_str(), job.image);
+}
+
+// 작업 풀의 비동기 작업 하나 = 대기열 맨 앞 텍스처 하나 (종료 중에 대기열을 비웠으면 아무것도 안 함)
+// 작업 안의 밉맵 / BC1 압축은 다시 parallelFor로 나뉘어 쉬는 작업 스레드가 도움
+static void decodeNextTexture() {
+    std::unique_ptr<TextureJob> job;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        if (!pendingJobs.empty()) {
+            job = std::move(pendingJobs.front());
+            pendingJobs.pop_front();
+        }
+    }
+    if (job) prepareTextureJob(*job);
+    std::lock_guard<std::mutex> lock(jobMutex);
+    if (job) readyJobs.push_back(std::move(job));
+    decodeTasks--;
+    decodeDone.notify_all();
+}
+
+void requestTextureAsync(const char* filename, GLuint* texture, bool* loaded) {
+    static bool s3tcChecked = false;
+    if (!s3tcChecked) {
+        // 처음 요청할 때 정함 (작업 스레드는 읽기만)
+        s3tcSupported = hasS3TC();
+        s3tcChecked = true;
+    }
+
+    std::unique_ptr<TextureJob> job(new TextureJob);
+    job->filename = filename;
+    job->texture = texture;
+    job->loaded = loaded;
+    jobsInFlight++;
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        pendingJobs.push_back(std::move(job));
+        decodeTasks++;
+    }
+    submitTask(decodeNextTexture);
+}
+
+static size_t levelUploadBytes(const TextureJob& job, int i) {
+    const TextureCacheLevel& level = job.cache.level[i];
+    if (job.cache.format == TEXTURE_CACHE_BC1 && !s3tcSupported) return (size_t)level.width * level.height * 3;
+    return level.size;
+}
+
+static void finishTextureJob(TextureJob& job) {
+    if (job.mapped) closeTextureCache(job.cache);
+    else freeImage(job.image);
+    job.rgbLevels.clear();
+    jobsInFlight--;
+}
+
+// 레벨 하나(또는 캐시가 없을 때 전체)를 올리고 쓴 바이트 수를 돌려줌, 다 올렸으면 done = true
+static size_t uploadNextLevel(TextureJob& job, bool& done) {
+    done = false;
+    if (!job.mapped) {
+        // 원본 경로는 GLU가 밉맵을 한 번에 만들어서 나눌 수 없음
+        *job.texture = uploadDecodedImage(job.image);
+        *job.loaded = true;
+        done = true;
+        return (size_t)job.image.width * job.image.height * job.image.channels;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (job.id == 0) {
+        glGenTextures(1, &job.id);
+        glBindTexture(GL_TEXTURE_2D, job.id);
+        setTextureParameters(job.cache.levels);
+        job.nextLevel = job.cache.levels - 1;
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D, job.id);
+    }
+
+    const int i = job.nextLevel;
+    std::vector<unsigned char> scratch;
+    uploadMappedLevel(job.cache, i, s3tcSupported, job.rgbLevels.empty() ? nullptr : job.rgbLevels[i].data(), scratch);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // [i, levels)가 모두 있으므로 여기까지만 샘플링하도록 해서 텍스처가 완전한 상태를 유지
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, i);
+    *job.texture = job.id;
+    *job.loaded = true;
+
+    job.nextLevel--;
+    done = (job.nextLevel < 0);
+    return levelUploadBytes(job, i);
+}
+
+void pumpTextureUploads(size_t byteBudget) {
+    if (jobsInFlight == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        while (!readyJobs.empty()) {
+            uploadingJobs.push_back(std::move(readyJobs.front()));
+            readyJobs.pop_front();
+        }
+    }
+
+    // 예산을 넘기기 전까지 레벨 단위로 올림 (첫 레벨은 예산보다 커도 올려서 항상 진행되게)
+    size_t spent = 0;
+    GLint previous = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+    while (!uploadingJobs.empty() && spent < byteBudget) {
+        TextureJob& job = *uploadingJobs.front();
+        if (!job.ok) {
+            std::cerr << "Failed to load texture: " << job.filename << std::endl;
+            finishTextureJob(job);
+            uploadingJobs.pop_front();
+            continue;
+        }
+        if (job.rebuilt && job.id == 0) {
+            std::cout << "Built texture cache: " << textureCachePath(job.filename.c_str()) << std::endl;
+        }
+
+        // 다음 레벨이 남은 예산보다 크면 다음 프레임으로 (이번 프레임에 아무것도 안 올렸을 때만 예외)
+        if (job.mapped && job.id != 0 && spent > 0 && spent + levelUploadBytes(job, job.nextLevel) > byteBudget) break;
+
+        bool done = false;
+        spent += uploadNextLevel(job, done);
+        if (done) {
+            finishTextureJob(job);
+            uploadingJobs.pop_front();
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, (GLuint)previous);
+}
+
+bool textureUploadsFinished() {
+    return jobsInFlight == 0;
+}
+
+void shutdownTextureLoader() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        pendingJobs.clear();
+    }
+    {
+        // 이미 디코딩 중인 것은 끝날 때까지 기다림 (대기열에 남았던 작업은 바로 끝남)
+        std::unique_lock<std::mutex> lock(jobMutex);
+        decodeDone.wait(lock, [] { return decodeTasks == 0; });
+    }
+
+    for (auto* queue : { &readyJobs, &uploadingJobs }) {
+        for (auto& job : *queue) {
+            if (job->ok) finishTextureJob(*job);
+        }
+        queue->clear();
+    }
+    jobsInFlight = 0;
+}
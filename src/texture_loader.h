@@ -0,0 +1,33 @@
+﻿#pragma once
+#include "gl_common.h"
+#include <cstddef>
+
+// --- 텍스처 로더 ---
+// texture_cache의 밉맵 + BC1 캐시 파일을 매핑해서 레벨별로 그대로 GL에 올림
+// S3TC를 지원하지 않는 GL이면 BC1을 CPU에서 풀어서 올림 (밉맵은 그대로 사용)
+// 캐시를 쓸 수 없으면(읽기 전용 폴더 등) 원본을 디코딩해서 gluBuild2DMipmaps로 올림
+
+// 한 프레임에 GL로 올리는 텍스처 데이터 상한 (레벨 하나가 이보다 크면 그 레벨만 올림)
+const size_t TEXTURE_UPLOAD_BUDGET_BYTES = 4u << 20;
+
+// 실패 시 0 (동기 로드: 디코딩/업로드가 끝날 때까지 기다림)
+GLuint loadTextureFile(const char* filename);
+
+// --- 비동기 로드 ---
+// 작업 풀(task_pool)의 비동기 작업으로 캐시 열기/만들기(JPEG 디코딩, 압축)를 동시에 하고
+// 끝난 텍스처는 큐로 GL 스레드에 넘어가서 pumpTextureUploads가 프레임마다 나눠 올림
+// 작은 밉 레벨부터 올리고 GL_TEXTURE_BASE_LEVEL을 낮춰가므로 흐린 텍스처가 먼저 보이고 점점 선명해짐
+// 첫 레벨이 올라가면 *texture와 *loaded를 설정 (그 전까지는 호출하는 쪽의 기본 재질로 그림)
+// texture/loaded는 GL 스레드에서만 읽고 쓰므로 따로 동기화하지 않음
+
+// GL 스레드에서 호출, 실패하면 pumpTextureUploads에서 오류를 출력하고 *loaded는 false로 남음
+void requestTextureAsync(const char* filename, GLuint* texture, bool* loaded);
+
+// 프레임마다 GL 스레드에서 호출, byteBudget 안에서 준비된 레벨을 올림
+void pumpTextureUploads(size_t byteBudget = TEXTURE_UPLOAD_BUDGET_BYTES);
+
+// 요청한 텍스처가 모두 올라갔는지 (실패한 것 포함)
+bool textureUploadsFinished();
+
+// 디코딩 중인 작업을 기다리고 올리는 중이던 매핑 해제
+void shutdownTextureLoader();